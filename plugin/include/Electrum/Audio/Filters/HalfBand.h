@@ -0,0 +1,92 @@
+#pragma once
+#include "Electrum/Audio/SIMD.h"
+
+/* Polyphase IIR half-band filters for 2x up/downsampling.
+ * Each one is two chains of first-order allpasses running at
+ * the lower rate, one for the even output samples and one
+ * for the odd ones, so a 2x stage costs about as much as
+ * a single allpass chain at the high rate.
+ *
+ * The coefficients come from the elliptic half-band design
+ * in Laurent de Soras' HIIR library. The first stage has to
+ * keep everything up to 20kHz and block the images right
+ * above that, so it gets more coefficients; the second stage
+ * for 4x only has to deal with an already band-limited
+ * signal so it can use a much wider transition band.
+ *
+ * Like the ladder kernels these are templates that work on
+ * either plain floats or SIMD registers. The samples are in
+ * float buffers with one T's worth of floats per sample
+ * index, i.e. interleaved across the SIMD lanes.
+ * */
+
+// 8 coefficients, transition band 0.04, ~-99dB stopband
+#define HALFBAND_COEFFS_2X 8
+// 4 coefficients, transition band 0.25, ~-116dB stopband
+#define HALFBAND_COEFFS_4X 4
+
+// previous input of each path + previous output of every
+// allpass in each path
+#define HALFBAND_STATE_SIZE(numCoeffs) ((numCoeffs) + 2)
+
+namespace HalfBand {
+constexpr float coeffs2x[HALFBAND_COEFFS_2X] = {
+    0.040633461f, 0.150505129f, 0.300757056f, 0.460774505f,
+    0.609524315f, 0.738503841f, 0.849223810f, 0.949742784f};
+
+constexpr float coeffs4x[HALFBAND_COEFFS_4X] = {0.042454710f, 0.170739850f,
+                                                0.393319893f, 0.745713589f};
+
+/* One path of allpasses, each being
+ * y[n] = c * (x[n] - y[n-1]) + x[n-1]. Path 0 uses the even
+ * coefficients and path 1 the odd ones. 's[i]' is the last
+ * input to stage i, which is also the last output of stage
+ * i - 1.
+ * */
+template <int N, int path, typename T>
+inline T allpassPath(const float* coeffs, T x, T* s) {
+  for (int i = 0; i < N / 2; ++i) {
+    const T y = ((x - s[i + 1]) * coeffs[path + (2 * i)]) + s[i];
+    s[i] = x;
+    x = y;
+  }
+  s[N / 2] = x;
+  return x;
+}
+
+// 'in' has numSamples samples, 'out' needs room for twice that
+template <int N, typename T>
+inline void upsample(const float* coeffs,
+                     const float* in,
+                     float* out,
+                     int numSamples,
+                     T* state) {
+  constexpr int stride = (int)(sizeof(T) / sizeof(float));
+  for (int i = 0; i < numSamples; ++i) {
+    const T x = SIMD::load<T>(in + (i * stride));
+    float* dest = out + (2 * i * stride);
+    SIMD::store(allpassPath<N, 0>(coeffs, x, state), dest);
+    SIMD::store(allpassPath<N, 1>(coeffs, x, state + (N / 2) + 1),
+                dest + stride);
+  }
+}
+
+// 'in' has numSamples * 2 samples, 'out' gets numSamples
+template <int N, typename T>
+inline void downsample(const float* coeffs,
+                       const float* in,
+                       float* out,
+                       int numSamples,
+                       T* state) {
+  constexpr int stride = (int)(sizeof(T) / sizeof(float));
+  for (int i = 0; i < numSamples; ++i) {
+    const float* src = in + (2 * i * stride);
+    const T even = SIMD::load<T>(src);
+    const T odd = SIMD::load<T>(src + stride);
+    const T a = allpassPath<N, 0>(coeffs, odd, state);
+    const T b = allpassPath<N, 1>(coeffs, even, state + (N / 2) + 1);
+    SIMD::store((a + b) * 0.5f, out + (i * stride));
+  }
+}
+
+}  // namespace HalfBand
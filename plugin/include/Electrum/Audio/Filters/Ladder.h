@@ -1,31 +1,79 @@
 #pragma once
+#include "Electrum/Identifiers.h"
+#include "HalfBand.h"
+#include "Prewarp.h"
+#include "Saturation.h"
+
+#define LADDER_MAKEUP_DB 16.0f
+// the four poles and then whatever the nonlinearity needs
+#define LADDER_CORE_STATE_SIZE (4 + SATURATION_STATE_SIZE)
+// followed by the half-band filters for oversampling: the
+// up and downsampler for the first 2x, then the same for
+// the second 2x
+#define LADDER_OVERSAMPLE_2X_STATE_SIZE \
+  (2 * HALFBAND_STATE_SIZE(HALFBAND_COEFFS_2X))
+#define LADDER_OVERSAMPLE_4X_STATE_SIZE \
+  (2 * HALFBAND_STATE_SIZE(HALFBAND_COEFFS_4X))
+#define LADDER_STATE_SIZE                                   \
+  (LADDER_CORE_STATE_SIZE + LADDER_OVERSAMPLE_2X_STATE_SIZE + \
+   LADDER_OVERSAMPLE_4X_STATE_SIZE)
+
+// the coefficients that every ladder topology shares, these
+// are kept together so the SIMD kernels can gather them per lane
+struct ladder_coeffs_t {
+  float g = 0.0f;
+  float g2 = 0.0f;
+  float g3 = 0.0f;
+  float g4 = 0.0f;
+  float bigG = 0.0f;
+  float k = 3.0f;
+  // 1 / (1 + k * g4), the feedback path's denominator.
+  // precomputed so the processing loops only multiply
+  float invDenom = 1.0f;
+  // the values that the last processed block ended on,
+  // the SIMD batch ramps from these to the current values
+  // over the course of each block
+  float lastG = 0.0f;
+  float lastBigG = 0.0f;
+  float lastK = 3.0f;
+  // the rate the batch runs this filter at, the coefficients
+  // get looked up for that rate
+  OversamplingE rate = OversampleOff;
+  // the prewarp tables for the host's sample rate, this has
+  // to be set before the cutoff is
+  const Prewarp::prewarp_tables_t* tables = nullptr;
+  void setCutoff(float cutoffHz);
+  void setK(float val);
+  // jump straight to the current values with no ramp
+  void snap() {
+    lastG = g;
+    lastBigG = bigG;
+    lastK = k;
+  }
+};
+
 
 class LadderLPBasic {
 private:
   // 2-D array for the filter state variables
   // accessed like [channel][pole]
-  float zState[2][4];
+  float zState[2][LADDER_STATE_SIZE];
 
   // the cutoff variables for each stage
   float cutoffHz = 2000.0f;
-  float g4;
-  float bigG;
-  float g3;
-  float g2;
-  float g;
-
-  float k = 3.0f;
-  void updateG(double sampleRate);
+  ladder_coeffs_t c;
 
 public:
   LadderLPBasic();
-  void prepare(double sampleRate) { updateG(sampleRate); }
+  void prepare();
   // getters
   float getCutoffHz() const { return cutoffHz; }
-  float getResonance() const { return k; }
+  float getResonance() const { return c.k; }
+  ladder_coeffs_t* getCoeffs() { return &c; }
+  float* getState(int channel) { return zState[channel]; }
   // setters
   void setCutoffHz(float hz);
-  void setResonance(float val) { k = val * 4.0f; }
+  void setResonance(float val) { c.setK(val * 4.0f); }
   // main processing
   float processMono(float input, int channel = 0);
   void processStereo(float& left, float& right);
@@ -37,28 +85,26 @@ public:
 
 class LadderLP {
 private:
-  float zState[2][4];
+  float zState[2][LADDER_STATE_SIZE];
 
   // the cutoff variables
   float cutoffHz = 2000.0f;
-  float g4;
-  float bigG;
-  float g3;
-  float g2;
-  float g;
-
-  float k = 3.0f;
-  void updateG(double sampleRate);
+  ladder_coeffs_t c;
 
 public:
   LadderLP();
-  void prepare(double sampleRate) { updateG(sampleRate); }
+  void prepare();
   // getters
   float getCutoffHz() const { return cutoffHz; }
-  float getResonance() const { return k; }
+  float getResonance() const { return c.k; }
+  ladder_coeffs_t* getCoeffs() { return &c; }
+  float* getState(int channel) { return zState[channel]; }
   // setters
   void setCutoffHz(float hz);
-  void setResonance(float val) { k = val * LADDER_MAX_K; }
+  void setResonance(float val) { c.setK(val * LADDER_MAX_K); }
+  // only the SIMD batch oversamples, processMono is always
+  // at the host rate and expects this to be off
+  void setOversampling(OversamplingE rate);
   // main processing
   float processMono(float input, int channel = 0);
   void processStereo(float& left, float& right);
@@ -68,28 +114,26 @@ public:
 
 class LadderHighPass {
 private:
-  float zState[2][4];
+  float zState[2][LADDER_STATE_SIZE];
 
   // the cutoff variables
   float cutoffHz = 2000.0f;
-  float g4;
-  float bigG;
-  float g3;
-  float g2;
-  float g;
-
-  float k = 3.0f;
-  void updateG(double sampleRate);
+  ladder_coeffs_t c;
 
 public:
   LadderHighPass();
-  void prepare(double sampleRate) { updateG(sampleRate); }
+  void prepare();
   // getters
   float getCutoffHz() const { return cutoffHz; }
-  float getResonance() const { return k; }
+  float getResonance() const { return c.k; }
+  ladder_coeffs_t* getCoeffs() { return &c; }
+  float* getState(int channel) { return zState[channel]; }
   // setters
   void setCutoffHz(float hz);
-  void setResonance(float val) { k = val * LADDER_MAX_K; }
+  void setResonance(float val) { c.setK(val * LADDER_MAX_K); }
+  // only the SIMD batch oversamples, processMono is always
+  // at the host rate and expects this to be off
+  void setOversampling(OversamplingE rate);
   // main processing
   float processMono(float input, int channel = 0);
   void processStereo(float& left, float& right);
@@ -99,28 +143,26 @@ public:
 
 class LadderBandPass {
 private:
-  float zState[2][4];
+  float zState[2][LADDER_STATE_SIZE];
 
   // the cutoff variables
   float cutoffHz = 2000.0f;
-  float g4;
-  float bigG;
-  float g3;
-  float g2;
-  float g;
-
-  float k = 3.0f;
-  void updateG(double sampleRate);
+  ladder_coeffs_t c;
 
 public:
   LadderBandPass();
-  void prepare(double sampleRate) { updateG(sampleRate); }
+  void prepare();
   // getters
   float getCutoffHz() const { return cutoffHz; }
-  float getResonance() const { return k; }
+  float getResonance() const { return c.k; }
+  ladder_coeffs_t* getCoeffs() { return &c; }
+  float* getState(int channel) { return zState[channel]; }
   // setters
   void setCutoffHz(float hz);
-  void setResonance(float val) { k = val * LADDER_MAX_K; }
+  void setResonance(float val) { c.setK(val * LADDER_MAX_K); }
+  // only the SIMD batch oversamples, processMono is always
+  // at the host rate and expects this to be off
+  void setOversampling(OversamplingE rate);
   // main processing
   float processMono(float input, int channel = 0);
   void processStereo(float& left, float& right);
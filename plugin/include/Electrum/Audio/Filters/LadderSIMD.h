@@ -0,0 +1,66 @@
+#pragma once
+#include "Electrum/Audio/SIMD.h"
+#include "Electrum/Identifiers.h"
+#include "Ladder.h"
+
+// enough for the left and right channels of every voice
+#define LADDER_BATCH_MAX 64
+
+// one channel of one voice's ladder filter
+struct ladder_lane_t {
+  // the block of samples, this gets processed in place
+  float* samples;
+  // the pole and saturation states, these live in the
+  // voice's ladder object
+  float* state;
+  ladder_coeffs_t* coeffs;
+  float inputGain;
+};
+
+/* Runs the ladder filters for a batch of voice-channels
+ * at once, one channel per SIMD lane. At the start of a
+ * block each group of lanes gathers its coefficients and
+ * state into registers, the samples get interleaved so each
+ * sample index is one vector, and the state is written back
+ * to the voices when the group is done. Whenever a lane's
+ * coefficients have changed since the last block, they
+ * get ramped linearly across the block so fast cutoff
+ * modulation doesn't click.
+ *
+ * The saturating ladders can also run oversampled: each
+ * group's interleaved block goes through half-band
+ * upsamplers, the filter, and back down again, with the
+ * half-band state kept after the ladder's own state. The
+ * rate comes from the lanes' coefficients since those have
+ * to be looked up for it anyway, see
+ * VoiceFilter::setOversampling.
+ * */
+class LadderBatch {
+private:
+  ladder_lane_t lanes[LADDER_BATCH_MAX];
+  int numLanes = 0;
+  SaturationModeE saturation = SATURATION_DEFAULT_MODE;
+#if JUCE_USE_SIMD
+  alignas(32) float interleaved[MAX_VOICE_BLOCK * SIMD::lanes];
+#endif
+  // the signal at 2x and 4x for oversampling
+  alignas(32) float halfRate[MAX_VOICE_BLOCK * 2 * SIMD::lanes];
+  alignas(32) float overRate[MAX_VOICE_BLOCK * 4 * SIMD::lanes];
+  template <FilterTypeE type>
+  void processWithSaturation(int numSamples);
+  template <FilterTypeE type, typename Sat>
+  void processLanes(int numSamples);
+
+public:
+  LadderBatch() = default;
+  void clear() { numLanes = 0; }
+  int getNumLanes() const { return numLanes; }
+  void addLane(float* samples,
+               float* state,
+               ladder_coeffs_t* coeffs,
+               float inputGain);
+  void setSaturationMode(SaturationModeE mode) { saturation = mode; }
+  SaturationModeE getSaturationMode() const { return saturation; }
+  // every lane in the batch needs to be using the same filter type
+  void process(FilterTypeE type, int numSamples);
+};
@@ -0,0 +1,48 @@
+#pragma once
+#include "Electrum/Common.h"
+
+// the table covers 2^4 - 2^15 Hz, which contains the whole
+// cutoff range, with this many points per octave
+#define PREWARP_OCTAVE_MIN 4
+#define PREWARP_OCTAVE_MAX 15
+#define PREWARP_POINTS_PER_OCTAVE 128
+#define PREWARP_TABLE_SIZE \
+  (((PREWARP_OCTAVE_MAX - PREWARP_OCTAVE_MIN) * PREWARP_POINTS_PER_OCTAVE) + 1)
+
+/* Cutoff -> coefficient lookup for the zero delay feedback
+ * filters. Rather than calling std::tan every time a cutoff
+ * gets modulated, we keep a table of g = tan(pi * hz / sr)
+ * and G = g / (1 + g) indexed in log-frequency and
+ * interpolate between points.
+ *
+ * The index is a piecewise-linear log2 (the float's exponent
+ * plus its mantissa) so finding it is just some bit
+ * twiddling. The table is built on exactly the same curve
+ * with a point on every power of two, so each pair of points
+ * we interpolate between is inside one octave where the
+ * index is linear in Hz.
+ * */
+namespace Prewarp {
+struct prewarp_point_t {
+  float g;
+  float bigG;
+};
+typedef std::array<prewarp_point_t, PREWARP_TABLE_SIZE> prewarp_table_t;
+// one table for each oversampling rate
+typedef std::array<prewarp_table_t, NUM_OVERSAMPLING_MODES> prewarp_tables_t;
+
+// the tables for the given host sample rate. These get built
+// the first time a rate is asked for and are never changed
+// or freed after that, so each processor can hold on to the
+// ones for its own rate. This takes a lock so call it from
+// prepareToPlay rather than the audio thread
+const prewarp_tables_t* getTables(double sampleRate);
+// finds g and G for the given cutoff when running at the
+// given oversampling rate, anything outside the filters'
+// cutoff range gets clamped
+void lookup(const prewarp_tables_t* tables,
+            float cutoffHz,
+            float& g,
+            float& bigG,
+            OversamplingE rate = OversampleOff);
+}  // namespace Prewarp
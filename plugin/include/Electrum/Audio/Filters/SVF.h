@@ -0,0 +1,95 @@
+#pragma once
+#include "Electrum/Identifiers.h"
+#include "Prewarp.h"
+
+/* A 2-pole multimode state variable filter, the TPT version
+ * from chapter 4 of the Zavalishin book (same as TPTFilter,
+ * but with two integrators and a feedback path). Compared to
+ * the ladders it's a lot cheaper and has no nonlinearity, so
+ * it's the better choice when a patch just needs some
+ * filtering rather than the ladder's character.
+ * */
+
+// the two integrators for each channel
+#define SVF_STATE_SIZE 2
+// k at full resonance, which works out to a Q of 25
+#define SVF_MIN_K 0.04f
+
+inline bool isSVFType(FilterTypeE type) {
+  return type >= SVFLowPass;
+}
+
+struct svf_coeffs_t {
+  float g = 0.0f;
+  // the damping, 2R in the book's notation or 1/Q
+  float k = 2.0f;
+  // 1 / (1 + kg + g^2), the feedback path's denominator
+  float invDenom = 1.0f;
+  // the values that the last processed block ended on,
+  // same as ladder_coeffs_t
+  float lastG = 0.0f;
+  float lastK = 2.0f;
+  // same as ladder_coeffs_t
+  const Prewarp::prewarp_tables_t* tables = nullptr;
+  void setCutoff(float cutoffHz);
+  void setK(float val);
+  void snap() {
+    lastG = g;
+    lastK = k;
+  }
+};
+
+namespace SVF {
+/* One sample of the filter for any of the SVF modes, written
+ * so it compiles for both plain floats and SIMD registers.
+ * This is the only place the SVF math lives, the per-voice
+ * and batched versions both call it.
+ * */
+template <FilterTypeE mode, typename T>
+inline T tick(T input, T* z, T g, T k, T invDenom) {
+  const T hp = (input - ((k + g) * z[0]) - z[1]) * invDenom;
+  const T v1 = hp * g;
+  const T bp = v1 + z[0];
+  z[0] = bp + v1;
+  const T v2 = bp * g;
+  const T lp = v2 + z[1];
+  z[1] = lp + v2;
+  if constexpr (mode == SVFLowPass) {
+    return lp;
+  } else if constexpr (mode == SVFBandPass) {
+    return bp;
+  } else if constexpr (mode == SVFHighPass) {
+    return hp;
+  } else if constexpr (mode == SVFNotch) {
+    return lp + hp;
+  } else {
+    static_assert(mode == SVFPeak);
+    return lp - hp;
+  }
+}
+}  // namespace SVF
+
+// one of these for each of the SVF entries in FilterTypeE,
+// with the same interface as the ladder classes
+template <FilterTypeE mode>
+class StateVariable {
+private:
+  float zState[2][SVF_STATE_SIZE];
+  float cutoffHz = 2000.0f;
+  svf_coeffs_t c;
+
+public:
+  StateVariable();
+  void prepare();
+  // getters
+  float getCutoffHz() const { return cutoffHz; }
+  float getResonance() const { return c.k; }
+  svf_coeffs_t* getCoeffs() { return &c; }
+  float* getState(int channel) { return zState[channel]; }
+  // setters
+  void setCutoffHz(float hz);
+  void setResonance(float val) { c.setK(2.0f - (val * (2.0f - SVF_MIN_K))); }
+  // main processing
+  float processMono(float input, int channel = 0);
+  void processStereo(float& left, float& right);
+};
@@ -0,0 +1,45 @@
+#pragma once
+#include "Electrum/Audio/SIMD.h"
+#include "Electrum/Identifiers.h"
+#include "SVF.h"
+
+// enough for the left and right channels of every voice
+#define SVF_BATCH_MAX 64
+
+// one channel of one voice's SVF
+struct svf_lane_t {
+  // the block of samples, this gets processed in place
+  float* samples;
+  // the integrator states, these live in the voice's filter
+  float* state;
+  svf_coeffs_t* coeffs;
+  float inputGain;
+};
+
+/* The SVF version of LadderBatch: each group of lanes
+ * gathers its coefficients and state into registers, runs
+ * the block with one channel per SIMD lane and writes the
+ * state back. Changed coefficients get ramped across the
+ * block the same way.
+ * */
+class SVFBatch {
+private:
+  svf_lane_t lanes[SVF_BATCH_MAX];
+  int numLanes = 0;
+#if JUCE_USE_SIMD
+  alignas(32) float interleaved[MAX_VOICE_BLOCK * SIMD::lanes];
+#endif
+  template <FilterTypeE mode>
+  void processLanes(int numSamples);
+
+public:
+  SVFBatch() = default;
+  void clear() { numLanes = 0; }
+  int getNumLanes() const { return numLanes; }
+  void addLane(float* samples,
+               float* state,
+               svf_coeffs_t* coeffs,
+               float inputGain);
+  // every lane in the batch needs to be using the same mode
+  void process(FilterTypeE type, int numSamples);
+};
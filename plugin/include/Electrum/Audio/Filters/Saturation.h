@@ -0,0 +1,151 @@
+#pragma once
+#include "Electrum/Audio/SIMD.h"
+
+/* The nonlinearities for the saturating filters. Each one is
+ * a struct with a static 'process' template that works on
+ * plain floats and SIMD registers alike, so the filter
+ * kernels can take them as a template argument and compile to
+ * one tight loop per filter type and saturation mode.
+ *
+ * 'state' points to SATURATION_STATE_SIZE values per channel
+ * for the modes that need memory, the rest ignore it.
+ * */
+#define SATURATION_STATE_SIZE 2
+
+enum SaturationModeE {
+  // std::tanh, mostly here as a reference for the benchmarks
+  TanhStd,
+  // 7/6 Pade approximant, same as juce's FastMathApproximations
+  TanhPade,
+  // clamped polynomial that's cheap to integrate
+  TanhPoly,
+  // the polynomial with first-order antiderivative anti-aliasing
+  TanhPolyADAA
+};
+
+// what the saturating ladders use unless told otherwise. The
+// Pade curve sounds the same as the std::tanh the ladders
+// have always used. ADAA changes the curve and puts half a
+// sample of delay in the feedback loop, which moves the
+// resonance, so patches have to ask for it with the
+// filterSaturationADAA parameter
+#define SATURATION_DEFAULT_MODE TanhPade
+
+namespace Saturation {
+
+struct Std {
+  static float process(float x, float*) { return std::tanh(x); }
+#if JUCE_USE_SIMD
+  static SIMD::vec_t process(SIMD::vec_t x, SIMD::vec_t*) {
+    for (size_t i = 0; i < SIMD::vec_t::SIMDNumElements; ++i)
+      x.set(i, std::tanh(x.get(i)));
+    return x;
+  }
+#endif
+};
+
+struct Pade {
+  template <typename T>
+  static T process(T x, T*) {
+    // the approximation is within 0.0001% of tanh up to
+    // about +-5 and goes past 1 after that
+    x = SIMD::clamp(x, -5.0f, 5.0f);
+    const T x2 = x * x;
+    const T num = x * (((x2 + 378.0f) * x2 + 17325.0f) * x2 + 135135.0f);
+    const T den = ((x2 * 28.0f + 3150.0f) * x2 + 62370.0f) * x2 + 135135.0f;
+    return SIMD::divide(num, den);
+  }
+};
+
+/* A degree 9 odd polynomial fit to tanh on [-2.5, 2.5] with
+ * p'(0) = 1, p(2.5) = 1 and p'(2.5) = 0, so clamping the input
+ * to that range gives a smooth curve within about 1.5% of tanh
+ * everywhere. The point of using this over the Pade version is
+ * that its antiderivative is also a polynomial, which the ADAA
+ * version needs.
+ * */
+#define SATURATION_POLY_LIMIT 2.5f
+struct Poly {
+  static constexpr float a3 = -0.28809285537f;
+  static constexpr float a5 = 0.06364315808f;
+  static constexpr float a7 = -0.00725147929f;
+  static constexpr float a9 = 0.00031778418f;
+  // and for the antiderivative
+  static constexpr float b4 = a3 / 4.0f;
+  static constexpr float b6 = a5 / 6.0f;
+  static constexpr float b8 = a7 / 8.0f;
+  static constexpr float b10 = a9 / 10.0f;
+
+  template <typename T>
+  static T curve(T x) {
+    x = SIMD::clamp(x, -SATURATION_POLY_LIMIT, SATURATION_POLY_LIMIT);
+    const T x2 = x * x;
+    return ((((x2 * a9 + a7) * x2 + a5) * x2 + a3) * x2 + 1.0f) * x;
+  }
+
+  // the antiderivative of the above, outside the clamped
+  // range the curve is flat so this continues as |x|
+  template <typename T>
+  static T antiderivative(T x) {
+    const T xc =
+        SIMD::clamp(x, -SATURATION_POLY_LIMIT, SATURATION_POLY_LIMIT);
+    const T x2 = xc * xc;
+    const T inner = ((((x2 * b10 + b8) * x2 + b6) * x2 + b4) * x2 + 0.5f) * x2;
+    return inner + (SIMD::abs(x) - SIMD::abs(xc));
+  }
+
+  template <typename T>
+  static T process(T x, T*) {
+    return curve(x);
+  }
+};
+
+/* First-order ADAA: instead of p(x[n]) we output
+ * (F(x[n]) - F(x[n-1])) / (x[n] - x[n-1]), the average of
+ * the curve between the last two inputs. Where the inputs
+ * are too close for that division to be accurate we use the
+ * curve at their midpoint instead. The state holds x[n-1]
+ * and F(x[n-1]).
+ * */
+#define SATURATION_ADAA_EPSILON 0.001f
+struct PolyADAA {
+  template <typename T>
+  static T process(T x, T* state) {
+    const T F = Poly::antiderivative(x);
+    const T dx = x - state[0];
+    const T adx = SIMD::abs(dx);
+    const T eps = SIMD::splat<T>(SATURATION_ADAA_EPSILON);
+    const T safeDx = SIMD::selectGreater(adx, eps, dx, SIMD::splat<T>(1.0f));
+    const T averaged = SIMD::divide(F - state[1], safeDx);
+    const T midpoint = Poly::curve((x + state[0]) * 0.5f);
+    state[0] = x;
+    state[1] = F;
+    return SIMD::selectGreater(adx, eps, averaged, midpoint);
+  }
+};
+
+// the struct for each SaturationModeE
+template <SaturationModeE mode>
+struct for_mode_t;
+template <>
+struct for_mode_t<TanhStd> {
+  typedef Std type;
+};
+template <>
+struct for_mode_t<TanhPade> {
+  typedef Pade type;
+};
+template <>
+struct for_mode_t<TanhPoly> {
+  typedef Poly type;
+};
+template <>
+struct for_mode_t<TanhPolyADAA> {
+  typedef PolyADAA type;
+};
+
+// the scalar Ladder classes always run this one, so they
+// sound the same as a LadderBatch that's left on its default
+typedef for_mode_t<SATURATION_DEFAULT_MODE>::type Default;
+
+}  // namespace Saturation
@@ -2,14 +2,36 @@
 #include "Electrum/Identifiers.h"
 #include "Electrum/Shared/CommonAudioData.h"
 #include "Ladder.h"
+#include "LadderSIMD.h"
+#include "SVFSIMD.h"
+#include <variant>
+
+// once every value in a filter's state is below this it can't
+// ring loud enough to hear, this is well above the denormal range
+#define FILTER_SILENT_LEVEL 0.00001f
+
+// one alternative for each FilterTypeE, in the same order
+typedef std::variant<LadderLPBasic,
+                     LadderLP,
+                     LadderHighPass,
+                     LadderBandPass,
+                     StateVariable<SVFLowPass>,
+                     StateVariable<SVFBandPass>,
+                     StateVariable<SVFHighPass>,
+                     StateVariable<SVFNotch>,
+                     StateVariable<SVFPeak>>
+    filter_variant_t;
 
 class VoiceFilter {
 private:
   shared_filter_params* params;
-  LadderLPBasic ladderBasic;
-  LadderLP ladderLoPass;
-  LadderHighPass ladderHP;
-  LadderBandPass ladderBP;
+  // only the filter for the current type exists, so changing
+  // the type picks which code runs once rather than every
+  // sample, and the others aren't taking up cache
+  filter_variant_t filter;
+  // the prewarp tables for the current sample rate, every
+  // filter type that gets swapped in looks its cutoff up here
+  const Prewarp::prewarp_tables_t* prewarp;
 
   // holds the current modulation state for this voice's filter
   // same idea as 'osc_mod_t' in Voice.h
@@ -29,14 +51,13 @@ private:
   float baseRes;
   float baseGain;
   FilterTypeE currentFilterType = FilterTypeE::LadderLPLinear;
+  OversamplingE oversampling = OversampleOff;
   // runs whatever relevant code prepares coefficients
   // for the current filter parameters
   void prepareCutoff();
   void prepareResonance();
   void prepareGain();
-
-  float processChannel(float input, int channel);
-
+  // swaps in the filter for currentFilterType
   void reinitForType();
 
 public:
@@ -48,6 +69,18 @@ public:
   void setResonanceMod(float val);
   void setGainMod(float val);
   void updateForBlock();
-  // the main processing callback
-  void processStereo(float& left, float& right);
+  // sets the rate the saturating ladders run at, the linear
+  // filters can't alias so they always stay at the host rate
+  void setOversampling(OversamplingE rate);
+  // hands this voice's left and right channels to whichever
+  // batch runs the current filter type, the samples get
+  // processed in place when the batch does
+  void addToBatch(LadderBatch& ladders,
+                  SVFBatch& svfs,
+                  float* left,
+                  float* right);
+  // true if the filter has rung out below FILTER_SILENT_LEVEL,
+  // the state gets set to exactly zero so that a silent input
+  // will give a silent output and the filter can be skipped
+  bool flushIfSilent();
 };
@@ -10,6 +10,10 @@ private:
 
 public:
   WavetableOscillator(Wavetable* w, int idx);
+  // true if the level is too low for this to make any sound,
+  // the level only gets modulated once per block so the voice
+  // can check this once and skip the oscillator until the next
+  bool isSilent(float levelMod) const;
   float getNextSample(int midiNote,
                       float levelMod,
                       float posMod,
@@ -46,11 +46,17 @@ private:
   handle_vector_t handles;
 
   bool needsData = true;
+  // set from when updateData() asks for a decode until the
+  // message thread has finished swapping it in
+  std::atomic<bool> decoding{false};
 
   float lfoHz = 0.5f;
   float phaseDelt = 0.00001f;
 
   float globalPhase = 0.0f;
+  // the global phase at every sample of the block being
+  // rendered
+  float phaseHistory[MAX_VOICE_BLOCK] = {};
 
   LFOTriggerE trigMode = LFOTriggerE::Global;
 
@@ -60,12 +66,20 @@ public:
   void handleAsyncUpdate() override;
   void timerCallback() override;
   float getSample(float normPhase) const;
-  float processSample(float& currentPhase) const;
+  // sampleInBlock picks the global phase for that sample
+  float processSample(float& currentPhase, int sampleInBlock) const;
   float getGlobalPhase() const { return globalPhase; }
   // call this in per-block update
   void updateData(apvts& tree, int lfoIDX);
-  // call this once per sample to advance the global phase
-  void tick();
+  // audio thread, swaps in a table that was decoded
+  // somewhere else. Returns false if a decode of its own is
+  // already on the way, check canCommitTable() first to
+  // avoid that
+  bool commitTable(const lfo_table_t& table, size_t hash);
+  bool canCommitTable() const { return !decoding.load(); }
+  // call this once per block to advance the global phase
+  // through it, before any voices render
+  void tickChunk(int numSamples);
   void setHz(float freq) {
     lfoHz = freq;
     phaseDelt = (float)((double)lfoHz / SampleRate::get());
@@ -92,7 +106,7 @@ private:
 
 public:
   VoiceLFO(LowFrequencyLUT* l);
-  void tick();
+  void tick(int sampleInBlock);
   void gateStarted();
   float getCurrentSample() const { return lastOutput; }
   float getCurrentPhase() const;
@@ -6,29 +6,52 @@ float getNoise(float x);
 float getFractal(float x, size_t octaves, float frequency, float lacunarity);
 }  // namespace Perlin
 
+// the generators only get evaluated once every this many
+// samples, the output is linearly interpolated in between
+#define PERLIN_CONTROL_INTERVAL 32
+
+/* Positions along the noise function are stored as 8.24
+ * fixed point. The permutation table repeats every 256
+ * units, so letting these overflow is seamless and we
+ * never lose precision the way a float accumulator would
+ * over a long session
+ * */
+typedef uint32_t perlin_phase_t;
+
 class PerlinGenerator {
 private:
+  uint8_t seed;
   size_t currentOctaves;
   float currentFreq;
   float currentLacunarity;
-  float currentX;
-  float xDelta;
-  float lastOutput = 0.0f;
+  double currentSampleRate = 0.0;
+  bool perVoice = false;
+  // each octave gets its own position and increment per control tick
+  perlin_phase_t octavePhases[PERLIN_OCTAVES_MAX];
+  perlin_phase_t octaveDeltas[PERLIN_OCTAVES_MAX];
+  // amplitude of each octave divided by the sum of
+  // amplitudes, octaves we aren't using get a weight of zero
+  alignas(32) float octaveWeights[PERLIN_OCTAVES_MAX];
+  // interpolation state
+  int samplesUntilUpdate = 0;
+  float lastOutput = 0.5f;
+  float outputDelta = 0.0f;
 
-  float getNextValue() {
-    currentX += (currentFreq / ((float)SampleRate::get() * 6.0f));
-    return Perlin::getFractal(currentX, currentOctaves, currentFreq,
-                              currentLacunarity);
-  }
+  void updateDeltas();
+  // advances each octave by one control tick and evaluates all of them
+  float computeNextValue();
 
 public:
-  PerlinGenerator()
-      : currentOctaves(1),
-        currentFreq(1.0f),
-        currentLacunarity(2.0f),
-        currentX(0.0f) {}
+  PerlinGenerator(uint32_t seed = 0);
   void setParams(size_t octaves, float frequency, float lacunarity);
+  void setPerVoice(bool shouldBePerVoice) { perVoice = shouldBePerVoice; }
+  // copy the parameters from another generator, voices use this
+  // to follow the shared generators
+  void copyParams(const PerlinGenerator& other);
   void tick();
   float getValue() const { return lastOutput; }
+  bool isPerVoice() const { return perVoice; }
+  size_t getOctaves() const { return currentOctaves; }
+  float getFrequency() const { return currentFreq; }
+  float getLacunarity() const { return currentLacunarity; }
 };
-
@@ -0,0 +1,137 @@
+#pragma once
+#include <juce_dsp/juce_dsp.h>
+#include <algorithm>
+#include <cmath>
+
+/* A few helpers on top of juce's SIMDRegister for the
+ * multi-voice DSP kernels. The register is 4 floats wide
+ * with SSE/NEON and 8 wide with AVX, and the kernels are
+ * written in terms of SIMD::lanes so they work either way.
+ * Every helper also has a plain float overload so templated
+ * kernels can be compiled for either type.
+ * */
+namespace SIMD {
+template <typename T>
+inline T splat(float v);
+
+template <>
+inline float splat<float>(float v) {
+  return v;
+}
+
+inline float divide(float a, float b) {
+  return a / b;
+}
+
+inline float abs(float v) {
+  return std::fabs(v);
+}
+
+inline float clamp(float v, float lo, float hi) {
+  return std::clamp(v, lo, hi);
+}
+
+template <typename T>
+inline T load(const float* src);
+
+template <>
+inline float load<float>(const float* src) {
+  return *src;
+}
+
+inline void store(float v, float* dest) {
+  *dest = v;
+}
+
+// returns ifTrue where a > b and ifFalse everywhere else
+inline float selectGreater(float a, float b, float ifTrue, float ifFalse) {
+  return (a > b) ? ifTrue : ifFalse;
+}
+
+#if JUCE_USE_SIMD
+typedef juce::dsp::SIMDRegister<float> vec_t;
+constexpr int lanes = (int)vec_t::SIMDNumElements;
+
+template <>
+inline vec_t splat<vec_t>(float v) {
+  return vec_t::expand(v);
+}
+
+// these need 'src' and 'dest' to be aligned for the register
+template <>
+inline vec_t load<vec_t>(const float* src) {
+  return vec_t::fromRawArray(src);
+}
+
+inline void store(vec_t v, float* dest) {
+  v.copyToRawArray(dest);
+}
+
+/* SIMDRegister doesn't have division or blending so we go to
+ * the native intrinsics for those. These are templates just so
+ * that the branch for the register width we aren't using never
+ * gets compiled, V is always vec_t
+ * */
+template <typename V>
+inline V divide(V a, V b) {
+#if JUCE_INTEL
+  if constexpr (sizeof(typename V::vSIMDType) == 32)
+    return V::fromNative(_mm256_div_ps(a.value, b.value));
+  else
+    return V::fromNative(_mm_div_ps(a.value, b.value));
+#elif JUCE_ARM
+  // reciprocal estimate + two Newton-Raphson steps
+  // gets us to within a bit or two of a real division
+  auto r = vrecpeq_f32(b.value);
+  r = vmulq_f32(vrecpsq_f32(b.value, r), r);
+  r = vmulq_f32(vrecpsq_f32(b.value, r), r);
+  return V::fromNative(vmulq_f32(a.value, r));
+#else
+  V out;
+  for (size_t i = 0; i < V::SIMDNumElements; ++i)
+    out.set(i, a.get(i) / b.get(i));
+  return out;
+#endif
+}
+
+template <typename V>
+inline V selectGreater(V a, V b, V ifTrue, V ifFalse) {
+#if JUCE_INTEL
+  if constexpr (sizeof(typename V::vSIMDType) == 32) {
+    const auto mask = _mm256_cmp_ps(a.value, b.value, _CMP_GT_OQ);
+    return V::fromNative(_mm256_blendv_ps(ifFalse.value, ifTrue.value, mask));
+  } else {
+    const auto mask = _mm_cmpgt_ps(a.value, b.value);
+    return V::fromNative(_mm_or_ps(_mm_and_ps(mask, ifTrue.value),
+                                   _mm_andnot_ps(mask, ifFalse.value)));
+  }
+#elif JUCE_ARM
+  return V::fromNative(
+      vbslq_f32(vcgtq_f32(a.value, b.value), ifTrue.value, ifFalse.value));
+#else
+  V out;
+  for (size_t i = 0; i < V::SIMDNumElements; ++i)
+    out.set(i, (a.get(i) > b.get(i)) ? ifTrue.get(i) : ifFalse.get(i));
+  return out;
+#endif
+}
+
+inline vec_t abs(vec_t v) {
+  return vec_t::abs(v);
+}
+
+inline vec_t clamp(vec_t v, vec_t lo, vec_t hi) {
+  return vec_t::min(vec_t::max(v, lo), hi);
+}
+#else
+// no registers, so the kernels go one lane at a time
+constexpr int lanes = 1;
+#endif
+
+// same as the above with the bounds as scalars
+template <typename T>
+inline T clamp(T v, float lo, float hi) {
+  return clamp(v, splat<T>(lo), splat<T>(hi));
+}
+
+}  // namespace SIMD
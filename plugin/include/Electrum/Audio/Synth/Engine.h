@@ -19,10 +19,31 @@ private:
   // state
   juce::OwnedArray<ElectrumVoice> voices;
   uint32_t destUpdateIdx = 0;
+  // when the host is bouncing the voices update their
+  // oscillators' modulation every sample
+  bool modsEverySample = false;
+  // the filters for all the active voices get run together
+  LadderBatch ladderBatch;
+  SVFBatch svfBatch;
+  ElectrumVoice* activeVoices[NUM_VOICES];
+  // stands in for the right channel when the host gives us mono
+  float monoScratch[MAX_VOICE_BLOCK];
+  // the oversampling rate the voices' filters are set up for
+  OversamplingE filterRate = OversampleOff;
+  // from bank select (CC 0), each bank is 128 programs
+  int programBank = 0;
+  // picks the filter oversampling, wavetable interpolation
+  // and modulation rate depending on whether we're offline,
+  // and the ladders' saturation
+  void updateRenderQuality();
   // functions
   void noteOn(int note, float velocity);
   void noteOff(int note);
-  void renderNextSample(float& left, float& right, bool updateDests);
+  void tickGlobalModulators(int numSamples);
+  void renderVoices(float* left,
+                    float* right,
+                    int numSamples,
+                    bool updateDests);
 
   ElectrumVoice* getFreeVoice();
   ElectrumVoice* getVoicePlayingNote(int note);
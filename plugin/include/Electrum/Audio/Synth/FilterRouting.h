@@ -0,0 +1,61 @@
+#pragma once
+#include "Electrum/Identifiers.h"
+
+// each voice sums its oscillators into one buffer per
+// filter and a dry buffer
+#define ROUTING_DRY_BUFFER NUM_FILTERS
+#define ROUTING_NUM_BUFFERS (NUM_FILTERS + 1)
+// a buffer with this destination goes to the voice's output
+#define ROUTING_OUTPUT -1
+
+// everything the routing depends on
+struct routing_params_t {
+  FilterRoutingE mode = FilterParallel;
+  bool filterActive[NUM_FILTERS] = {};
+  bool oscToFilter[NUM_OSCILLATORS][NUM_FILTERS] = {};
+  bool oscActive[NUM_OSCILLATORS] = {};
+  bool operator==(const routing_params_t& other) const = default;
+};
+
+// one filter's worth of the plan
+struct filter_step_t {
+  int filter;
+  // inactive filters don't run, their input just gets
+  // passed along to wherever the filter would send it
+  bool process;
+  // another filter's buffer or ROUTING_OUTPUT
+  int dest;
+};
+
+/* The routing compiled down to a flat list of what goes
+ * where, so the voices and the engine can just run through
+ * it over their buffers without checking any parameters:
+ * 1. each oscillator adds into its destination buffers
+ * 2. the steps run in order, each one runs its filter on
+ * its buffer and then adds the result into its destination
+ * 3. the output buffers get summed for the voice's output
+ * Buffers that nothing gets routed to have no steps.
+ * */
+struct routing_plan_t {
+  int oscDests[NUM_OSCILLATORS][ROUTING_NUM_BUFFERS] = {};
+  int numOscDests[NUM_OSCILLATORS] = {};
+  filter_step_t steps[NUM_FILTERS] = {};
+  int numSteps = 0;
+  int outputs[ROUTING_NUM_BUFFERS] = {};
+  int numOutputs = 0;
+};
+
+// holds the current plan and recompiles it when the
+// routing changes. Call update() once per block
+class FilterRouter {
+private:
+  routing_params_t params;
+  routing_plan_t plan;
+  static routing_plan_t compile(const routing_params_t& p);
+
+public:
+  FilterRouter();
+  // returns true if the plan changed
+  bool update(const routing_params_t& p);
+  const routing_plan_t& getPlan() const { return plan; }
+};
@@ -4,6 +4,8 @@
 #include "Electrum/Audio/Generator/Oscillator.h"
 #include "Electrum/Audio/Modulator/AHDSR.h"
 #include "Electrum/Audio/Modulator/LFO.h"
+#include "Electrum/Audio/Modulator/Perlin.h"
+#include "Electrum/Audio/Synth/FilterRouting.h"
 #include "Electrum/Common.h"
 #include "Electrum/Identifiers.h"
 #include "Electrum/Shared/ElectrumState.h"
@@ -43,30 +45,27 @@ private:
 
 class FilterSumHandler {
 private:
-  std::array<float, 6> data = {};
+  // accessed like [filter 1, filter 2, dry][channel][sample]
+  float data[ROUTING_NUM_BUFFERS][2][MAX_VOICE_BLOCK];
+  // buffers that nothing has written to this block, these
+  // are known to be all zeroes
+  bool silent[ROUTING_NUM_BUFFERS];
 
 public:
   FilterSumHandler() = default;
-  // clear all the sums for the next sample
-  void clear() { std::fill(data.begin(), data.end(), 0.0f); }
-  void addToFilter1(float l, float r) {
-    data[0] += l;
-    data[1] += r;
+  // clear all the sums for the next block
+  void clear(int numSamples);
+  // call this for any buffer that's going to be written to
+  void markSounding(int buffer) { silent[buffer] = false; }
+  bool isSilent(int buffer) const { return silent[buffer]; }
+  void add(int buffer, int idx, float l, float r) {
+    data[buffer][0][idx] += l;
+    data[buffer][1][idx] += r;
   }
-  void addToFilter2(float l, float r) {
-    data[2] += l;
-    data[3] += r;
-  }
-  void addToDry(float l, float r) {
-    data[4] += l;
-    data[5] += r;
-  }
-  float* filterLeft(int f);
-  float* filterRight(int f);
-  // call this with the references to the passed in samples
-  void addCurrentSumTo(float& left, float& right) const;
-  float getLeftSum() const { return data[0] + data[2] + data[4]; }
-  float getRightSum() const { return data[1] + data[3] + data[5]; }
+  // adds one buffer's samples into another
+  void addInto(int src, int dest, int numSamples);
+  float* bufferLeft(int buffer) { return data[buffer][0]; }
+  float* bufferRight(int buffer) { return data[buffer][1]; }
 };
 
 //========================================================
@@ -91,18 +90,36 @@ private:
   float queuedVelocity = 0.0f;
   VoiceGateEnvelope vge;
   bool wasBusy = false;
+  // set when a released voice's output is known to be silent
+  // for good, this ends the voice without waiting for the
+  // envelopes to finish
+  bool endedSilent = false;
   // oscillators
   juce::OwnedArray<WavetableOscillator> oscs;
   osc_mod_t oscModState[NUM_OSCILLATORS];
+  // every mod dest's value as of the last update, kept
+  // around for the telemetry
+  float modDestValues[MOD_DESTS] = {};
+  // scratch for looking up a dest's sources. Each voice has
+  // its own since several processors can be rendering at once
+  mod_src_t currentMods[MOD_SOURCES];
   // envelopes
   juce::OwnedArray<AHDSREnvelope> envs;
   // LFOs
   juce::OwnedArray<VoiceLFO> lfos;
+  // per-voice Perlin generators, these only run when the
+  // shared generator is set to per-voice mode
+  juce::OwnedArray<PerlinGenerator> perlins;
   // filters
   juce::OwnedArray<VoiceFilter> filters;
   FilterSumHandler filterSums;
+  // the output of the gate envelope for the current block
+  float gateLevels[MAX_VOICE_BLOCK];
   // RMS meter
   RollingRMS rms;
+  // where renderOscillators() is in the block, for reading
+  // the shared modulators
+  int blockSample = 0;
 
 public:
   const int voiceIndex;
@@ -112,6 +129,8 @@ public:
   void updateForBlock();
   // sample rate update callback
   void sampleRateSet(double sr);
+  // passes the oversampling setting on to the filters
+  void setFilterOversampling(OversamplingE rate);
   bool gateIsOn() const { return gate; }
   bool isBusy() const;
   void startNote(int note, float velocity);
@@ -119,12 +138,37 @@ public:
 
   void stopNote();
   int getCurrentNote() const { return currentNote; }
-  void renderNextSample(float& left, float& right, bool updateDests);
-  // callback for gripping graph data
-  void updateGraphData(GraphingData* gd);
+  /* The engine renders each block of audio in three
+   * stages so that it can run the filters for every voice
+   * together in SIMD batches:
+   * 1. beginBlock() and renderOscillators() tick the
+   * modulators and sum the oscillators into the buffers the
+   * routing plan sends them to
+   * 2. for each step of the plan the filters process their
+   * inputs after the engine collects them with
+   * addFilterLanes(), and routeFilterOutput() passes the
+   * result on to the next filter if there is one
+   * 3. renderOutput() applies the gate and adds the voice
+   * to the output buffers
+   * */
+  // returns false if this voice has nothing to render
+  bool beginBlock();
+  // everySample updates the oscillators' mod dests on every
+  // sample rather than just the first, for offline renders
+  void renderOscillators(int numSamples, bool updateDests, bool everySample);
+  void addFilterLanes(int filterIdx, LadderBatch& ladders, SVFBatch& svfs);
+  void routeFilterOutput(const filter_step_t& step, int numSamples);
+  void renderOutput(float* left, float* right, int numSamples);
+  // fills in this voice's part of the GUI's telemetry
+  void writeTelemetry(telemetry_snapshot_t& snap) const;
 
 private:
-  void addToFilterSums(float oscL, float oscR, int oscID);
+  // finds the oscillators that have somewhere to go and are
+  // loud enough to hear this block, and marks their buffers
+  void findAudibleOscillators(bool* audible);
+  // true if no oscillator's level can come back up now that
+  // the gate is off
+  bool oscLevelsCanOnlyFall();
 
   // this gets called on the state pointer's ModMap for every
   // sample that we want to update the modulated parameters
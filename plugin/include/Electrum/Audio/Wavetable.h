@@ -1,6 +1,7 @@
 #pragma once
 #include "../Common.h"
 #include "Electrum/Audio/AudioUtil.h"
+#include "Electrum/Shared/SPSCRing.h"
 #include "juce_core/juce_core.h"
 #include "juce_core/system/juce_PlatformDefs.h"
 #include "juce_events/juce_events.h"
@@ -71,30 +72,64 @@ String getDefaultTableString(int idx);
 // via pointer by the rest of our
 // oscillator code
 
-class BandLimitedWave {
+class BandLimitedWave : public juce::ReferenceCountedObject {
 private:
   banded_wave_set data;
 
 public:
+  // ref-counted so sets can share the frames they have in
+  // common
+  typedef juce::ReferenceCountedObjectPtr<BandLimitedWave> Ptr;
   BandLimitedWave(float* firstWave);
   float getSample(float phase, float phaseDelt) const;
-  String toString();
+  // the version with every harmonic, for drawing
+  const float* getFullBandWave() const { return data[0].wave; }
 };
 
 //=========================================================
+// one fully built set of band-limited waves. These never
+// change after they're built so the audio thread and the
+// GUI can share them through WaveSet::Ptr handles
+#define MAX_WAVES_PER_TABLE 256
+class WaveSet : public juce::ReferenceCountedObject {
+private:
+  juce::ReferenceCountedArray<BandLimitedWave> waves;
+
+public:
+  typedef juce::ReferenceCountedObjectPtr<WaveSet> Ptr;
+  // decodes and band-limits each wave in the string
+  WaveSet(const String& str);
+  // for waves that have already been band-limited
+  WaveSet(const juce::ReferenceCountedArray<BandLimitedWave>& w);
+  int size() const { return waves.size(); }
+  // no ref counting here, the audio thread calls this
+  const BandLimitedWave* getWave(int idx) const {
+    return waves.getObjectPointerUnchecked(idx);
+  }
+  BandLimitedWave::Ptr getWavePtr(int idx) const { return waves[idx]; }
+  // roughly how many bytes the built waves take up
+  size_t getMemoryUsage() const {
+    return (size_t)waves.size() * sizeof(BandLimitedWave);
+  }
+  JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(WaveSet)
+};
+
 // represents the data about a set of wavetables that our
 // oscilators will access via pointer
-#define MAX_WAVES_PER_TABLE 256
-typedef juce::OwnedArray<BandLimitedWave> wave_set_t;
 class Wavetable : public juce::AsyncUpdater {
 private:
-  wave_set_t setA;
-  wave_set_t setB;
-  wave_set_t* pActive = &setA;
-  wave_set_t* pWaiting = &setB;
-  float fSize;
-
-  static String getDefaultSetString(int idx);
+  // the audio thread reads liveSet, which holds a reference
+  // of its own. New sets only get swapped in by the audio
+  // thread at the start of a block, and the ones they replace
+  // go back through retiredSets so they only ever get
+  // released on the message thread. activeSet is the message
+  // thread's handle on whatever's live, for the GUI
+  std::atomic<WaveSet*> liveSet;
+  SPSCRing<WaveSet*, 16> retiredSets;
+  WaveSet::Ptr activeSet;
+  // a set from loadWaveSet() waiting for the next block,
+  // also holding a reference
+  std::atomic<WaveSet*> pendingSet{nullptr};
 
   // the GUI parameters for each oscillator
   // since these are shared across voices they'll
@@ -105,11 +140,29 @@ private:
   float coarse = 0.0f;
   float fine = 0.0f;
   bool active = true;
+  // blend between the two nearest frames instead of snapping
+  // to one, for offline renders
+  bool smooth = false;
 
 public:
   Wavetable();
-  int size() const { return pActive->size(); }
-  void loadWaveData(const String& str);
+  ~Wavetable() override;
+  int size() const { return activeSet->size(); }
+  // queues a set that's already been built, the audio thread
+  // picks it up in commitPendingSet()
+  void loadWaveSet(WaveSet::Ptr set);
+  // audio thread only, at the start of a block. These return
+  // false if the set couldn't be swapped in yet, which only
+  // happens if the message thread has fallen a long way
+  // behind on releasing old ones. Committing the set that's
+  // already live does nothing
+  bool commitWaveSet(WaveSet* set);
+  bool commitPendingSet();
+  // audio thread, whether commitWaveSet() would go through
+  bool canCommitWaveSet(const WaveSet* set) const {
+    return set == liveSet.load(std::memory_order_relaxed) ||
+           retiredSets.canPush();
+  }
   void handleAsyncUpdate() override;
   inline void setPos(float value) { position = value; }
   inline void setLevel(float value) { level = value; }
@@ -117,6 +170,7 @@ public:
   inline void setCoarse(float value) { coarse = value; }
   inline void setFine(float value) { fine = value; }
   inline void setActive(bool shouldBeOn) { active = shouldBeOn; }
+  inline void setSmooth(bool shouldSmooth) { smooth = shouldSmooth; }
   //  these do the main work for the oscillators
   float getSampleFixed(float phase, float phaseDelt, float pos) const;
   float getSampleSmooth(float phase, float phaseDelt, float pos) const;
@@ -128,9 +182,15 @@ public:
   inline float getCoarse() const { return coarse; }
   inline float getFine() const { return fine; }
   inline bool isActive() const { return active; }
+  inline bool isSmooth() const { return smooth; }
   // and these help render the graphs
   std::vector<float> normVectorForWave(int wave, int numPoints = 512) const;
-  String toString() const noexcept;
+  // read-only access for the GUI, only call this on the
+  // message thread. A new handle means the table has changed
+  WaveSet::Ptr getWaveSet() const { return activeSet; }
   static String getDefaultWavesetString();
+  // the same waves, already built and shared by every
+  // oscillator in the process
+  static WaveSet::Ptr getDefaultWaveSet();
   JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(Wavetable)
 };
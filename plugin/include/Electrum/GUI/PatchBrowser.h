@@ -42,7 +42,7 @@ public:
 // a list
 class PatchListEntry : public ClickableComponent {
 private:
-  patch_meta_t* const patch;
+  patch_meta_t* patch;
   bool isSelected = false;
   AttString nameText;
   AttString authorText;
@@ -50,6 +50,11 @@ private:
 public:
   PatchListEntry(patch_meta_t* p);
   patch_meta_t* getPatch() { return patch; }
+  // entries get recycled as the list scrolls
+  void setPatch(patch_meta_t* p) {
+    patch = p;
+    repaint();
+  }
   void paint(juce::Graphics& g) override;
   void setSelected(bool sel) {
     isSelected = sel;
@@ -82,38 +87,78 @@ public:
 //===================================================================
 typedef juce::OwnedArray<PatchListEntry> patch_list_t;
 
-class PatchList : public Component, public ElectrumUserLib::Listener {
+// one row of the patch list
+struct patch_row_t {
+  int category;
+  // nullptr for a category header
+  patch_meta_t* patch;
+};
+
+/* The list lays out every row's position but only has
+ * components for the rows in view, so it stays cheap with a
+ * huge library. With a search query the category headers
+ * go away and the rows are the search results, best first.
+ * */
+class PatchList : public Component,
+                  public ElectrumUserLib::Listener,
+                  private juce::AsyncUpdater {
 private:
   ElectrumState* const state;
   juce::OwnedArray<PatchCategHeader> categHeaders;
-  patch_list_t patches;
-  void setSelectedPatch(patch_meta_t* p);
+  // only enough entries for the visible rows
+  patch_list_t entryPool;
+  // every patch, by category and then name. Only re-sorted
+  // when the library changes
+  std::vector<patch_meta_t*> sortedPatches;
+  bool sortNeeded = true;
+  std::vector<patch_row_t> rows;
+  // the y position of each row, with one extra for the
+  // bottom of the last row
+  std::vector<int> rowY;
+  String query;
+  juce::Rectangle<int> visibleArea;
   patch_meta_t* selectedPatch = nullptr;
+  void rebuildRows();
+  void libraryChanged();
+  void handleAsyncUpdate() override;
+  void setSelectedPatch(patch_meta_t* p);
 
 public:
   PatchList(ElectrumState* s);
   ~PatchList() override;
   patch_meta_t* getSelected() { return selectedPatch; }
+  void setSearchQuery(const String& q);
+  void categoryToggled() { rebuildRows(); }
+  void updateVisibleRows(const juce::Rectangle<int>& area);
   void patchWasSaved(patch_meta_t* patch) override;
+  void patchWasFound(patch_meta_t* patch) override;
+  void patchWasRemoved(patch_meta_t* patch) override;
+  void libraryScanFinished() override;
   void resized() override;
-
-  // private:
-  // void sortPatchList();
 };
 
 class PatchViewport : public Component {
 private:
+  class ListViewport : public juce::Viewport {
+  private:
+    PatchList* const list;
+
+  public:
+    ListViewport(PatchList* l) : list(l) {}
+    void visibleAreaChanged(const juce::Rectangle<int>& area) override {
+      list->updateVisibleRows(area);
+    }
+  };
   PatchList pl;
-  juce::Viewport vpt;
+  ListViewport vpt;
 
 public:
   PatchList& getPL() { return pl; }
-  PatchViewport(ElectrumState* s) : pl(s) {
+  PatchViewport(ElectrumState* s) : pl(s), vpt(&pl) {
     vpt.setViewedComponent(&pl, false);
     vpt.setViewPosition(0, 0);
     vpt.setInterceptsMouseClicks(true, true);
     addAndMakeVisible(vpt);
-    pl.resized();
   }
   void resized() override { vpt.setBounds(getLocalBounds()); }
 };
@@ -123,6 +168,7 @@ public:
 class PatchBrowser : public Component {
 private:
   ElectrumState* const state;
+  juce::TextEditor searchBox;
   PatchViewport loader;
   PatchSaver saver;
   juce::TextButton loadBtn;
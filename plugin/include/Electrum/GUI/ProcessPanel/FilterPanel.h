@@ -39,6 +39,10 @@ private:
 
   juce::ComboBox typeBox;
   combo_attach_ptr cAttach;
+  // the routing is shared by both filters so each tab
+  // gets a box for it
+  juce::ComboBox routingBox;
+  combo_attach_ptr rAttach;
 
 public:
   FilterComp(ElectrumState* s, int idx);
@@ -14,6 +14,9 @@ DECLARE_ID(waveName)
 DECLARE_ID(WAVE_FRAME)
 DECLARE_ID(frameIndex)
 DECLARE_ID(frameStringData)
+// set when a frame's been edited since its band-limited
+// waves were last built
+DECLARE_ID(frameNeedsResynth)
 
 // each WAVE_FRAME tree can have a number of children to represent
 // various edits
@@ -51,6 +54,9 @@ void saveEditsInWaveTree(ValueTree& wt);
 // just add up all the strings for the full Wavetable
 String getFullWavetableString(const ValueTree& tree);
 
+// the frame's string with any FFT warp applied
+String getEditedFrameString(const ValueTree& frame);
+
 // these functions do the work of applying the various fixed transforms to the
 // wave
 // void randomizeFramePhases(ValueTree& waveTree, int idx);
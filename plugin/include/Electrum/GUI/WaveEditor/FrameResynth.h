@@ -0,0 +1,31 @@
+#pragma once
+#include "Electrum/Audio/Wavetable.h"
+#include "Electrum/GUI/WaveEditor/EditValueTree.h"
+#include "juce_events/juce_events.h"
+
+/* Keeps the band-limited waves for every frame of the table
+ * being edited and only rebuilds the frames marked with
+ * WaveEdit::frameNeedsResynth. Each of those is a job on the
+ * pool, and once they're all done the new WaveSet goes to
+ * onSetReady on the message thread. Unchanged frames are
+ * shared with the last set rather than rebuilt.
+ * */
+class FrameResynth : private juce::AsyncUpdater {
+public:
+  std::function<void(WaveSet::Ptr)> onSetReady;
+  FrameResynth();
+  ~FrameResynth() override;
+  // message thread only. If a batch is still running this
+  // one gets started when it finishes
+  void resynthesize(const ValueTree& waveTree);
+
+private:
+  struct resynth_batch_t;
+  class FrameJob;
+  juce::ThreadPool pool;
+  // message thread only
+  juce::ReferenceCountedArray<BandLimitedWave> frames;
+  std::unique_ptr<resynth_batch_t> running;
+  ValueTree queuedTree;
+  void handleAsyncUpdate() override;
+};
@@ -49,11 +49,32 @@ private:
 
   // this can replace the ugly external call to 'canPointHaveFrequency'
   bool isMovementLegal(warp_point_t* pt, float normMagnitude, float freq) const;
-  warp_point_t* closestEditPoint(size_t bin);
-  float getInfluenceAmt(warp_point_t* point, size_t binIdx);
   size_t minDistanceToNeutral(size_t pointIdx);
-  // helper for actual warping
-  float warpBinMagnitude(size_t binIdx);
+
+  // each point pulls the bins around it toward its magnitude
+  // with a triangular kernel that reaches zero before the
+  // halfway point to its neighbors, so the kernels never
+  // overlap and a moved point only changes the bins under
+  // its own kernel and its neighbors'
+  struct kernel_range_t {
+    size_t first;
+    size_t last;
+  };
+  // the bins each point's kernel was last applied to
+  std::vector<kernel_range_t> appliedKernels;
+  // normalized magnitudes of 'savedBins', these don't change
+  std::array<float, AUDIBLE_BINS> savedNorm;
+  std::array<float, AUDIBLE_BINS> kernelScratch;
+  std::array<float, AUDIBLE_BINS> normScratch;
+  // which points have moved since the last update, adding or
+  // removing a point means redoing all of them
+  bool fullWarpNeeded = true;
+  bool anyPointMoved = false;
+  size_t firstMovedPoint = 0;
+  size_t lastMovedPoint = 0;
+  void markPointMoved(size_t ptIndex);
+  kernel_range_t kernelRangeFor(size_t ptIndex);
+  void applyKernel(size_t ptIndex, const kernel_range_t& range);
 
 public:
   FrameWarp(ValueTree& vt);
@@ -0,0 +1,80 @@
+#pragma once
+#include "Electrum/GUI/GUITypedefs.h"
+#include "juce_core/juce_core.h"
+#include "juce_events/juce_events.h"
+#include <list>
+#include <unordered_map>
+#include <unordered_set>
+
+#define THUMBNAIL_W 100
+#define THUMBNAIL_H 75
+// the atlas is a grid of thumbnail sized slots
+#define THUMB_ATLAS_COLS 8
+#define THUMB_ATLAS_ROWS 8
+#define THUMB_ATLAS_SLOTS (THUMB_ATLAS_COLS * THUMB_ATLAS_ROWS)
+
+/* Renders wave thumbnails on a background thread into one
+ * atlas image. Thumbnails are keyed on a hash of the wave
+ * string and whether they're selected, so identical frames
+ * share a slot and reselecting a frame doesn't re-render it.
+ * Once the atlas is full the least recently drawn slot gets
+ * reused. Grab it through a juce::SharedResourcePointer so
+ * every editor shares the one thread and atlas.
+ * */
+class ThumbnailCache : private juce::Thread, private juce::AsyncUpdater {
+public:
+  class Listener {
+  public:
+    Listener() = default;
+    virtual ~Listener() {}
+    // called on the message thread when new thumbnails are
+    // in the atlas
+    virtual void thumbnailsReady() = 0;
+  };
+  ThumbnailCache();
+  ~ThumbnailCache() override;
+  // hashing a whole wave string isn't free, so callers
+  // should hang on to this
+  static juce::int64 hashWave(const String& waveStr);
+  // message thread only. Draws the thumbnail and returns true
+  // if it's been rendered, otherwise queues it up and returns
+  // false
+  bool draw(juce::Graphics& g,
+            frect_t bounds,
+            juce::int64 waveHash,
+            const String& waveStr,
+            bool selected);
+  void addListener(Listener* l) { listeners.push_back(l); }
+  void removeListener(Listener* l);
+
+private:
+  struct render_job_t {
+    juce::int64 key;
+    String waveStr;
+    bool selected;
+  };
+  struct atlas_slot_t {
+    int index;
+    std::list<juce::int64>::iterator lruPos;
+  };
+  // guards the atlas and everything below it
+  juce::CriticalSection lock;
+  juce::Image atlas;
+  // front is the most recently drawn
+  std::list<juce::int64> lru;
+  std::unordered_map<juce::int64, atlas_slot_t> slots;
+  // newest requests are at the back and get rendered first
+  std::vector<render_job_t> queue;
+  std::unordered_set<juce::int64> queued;
+  // message thread only
+  std::vector<Listener*> listeners;
+
+  void run() override;
+  void handleAsyncUpdate() override;
+  // call with the lock held
+  int claimSlot(juce::int64 key);
+  static juce::Rectangle<int> slotBounds(int index);
+  static void renderThumbnail(juce::Image& img,
+                              const String& waveStr,
+                              bool selected);
+};
@@ -1,5 +1,6 @@
 #pragma once
 #include "../Util/ModalParent.h"
+#include "Electrum/GUI/WaveEditor/FrameResynth.h"
 #include "Electrum/GUI/WaveEditor/WaveEdiorContext.h"
 #include "Electrum/GUI/WaveEditor/WaveThumbnail.h"
 #include "Electrum/Shared/FileSystem.h"
@@ -31,6 +32,8 @@ private:
   std::unique_ptr<WaveThumbnailBar> thumbBar;
   // various editor views
   std::unique_ptr<WaveViewerTabs> tabs;
+  // rebuilds the edited frames for previewing
+  FrameResynth resynth;
 
 public:
   WaveEditor(ElectrumState* s, Wavetable* wt, int idx);
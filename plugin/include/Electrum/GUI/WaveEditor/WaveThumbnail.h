@@ -1,33 +1,25 @@
 #pragma once
 #include "Electrum/GUI/GUITypedefs.h"
+#include "Electrum/GUI/WaveEditor/ThumbnailCache.h"
 #include "Electrum/Identifiers.h"
 #include "juce_core/juce_core.h"
 
-#define THUMBNAIL_W 100
-#define THUMBNAIL_H 75
-
+/* Thumbnails only exist for the frames that are on screen
+ * and get recycled as the bar scrolls. The image itself
+ * comes from the ThumbnailCache atlas and the selection
+ * lives in the WaveThumbnailBar
+ * */
 class WaveThumbnail : public Component {
 private:
-  juce::Image img;
-
   AttString aStr;
-  bool drawSelected = false;
-  String waveString;
-  void updateImage();
   bool leftWasDown = false;
 
 public:
-  int frameIndex;
-  WaveThumbnail(const String& waveStr, int i);
+  int frameIndex = -1;
+  WaveThumbnail();
+  void setFrameIndex(int i);
+  bool isSelected() const;
   void paint(juce::Graphics& g) override;
-  void setSelected(bool sel) {
-    if (drawSelected != sel) {
-      drawSelected = sel;
-      updateImage();
-      repaint();
-    }
-  }
-  bool isSelected() const { return drawSelected; }
   // mouse callbacks for selecting/ deselecting frames
   void mouseUp(const juce::MouseEvent& e) override;
   void mouseDown(const juce::MouseEvent& e) override;
@@ -37,7 +29,7 @@ public:
 
 //==========================================================
 
-class WaveThumbnailBar : public Component {
+class WaveThumbnailBar : public Component, public ThumbnailCache::Listener {
 public:
   class Listener {
   public:
@@ -50,23 +42,44 @@ private:
   // this private class will be the view component in our viewport
   class ThumbRow : public Component {
   public:
+    // just enough of these to cover the visible frames
     juce::OwnedArray<WaveThumbnail> thumbnails;
-    ThumbRow(const String& str);
-    void resized() override;
+    // points the thumbnails at the frames in [first, last)
+    void showFrames(int first, int last);
+  };
+  // lets the bar know when it's been scrolled
+  class ThumbViewport : public juce::Viewport {
+  public:
+    WaveThumbnailBar* const bar;
+    ThumbViewport(WaveThumbnailBar* b) : bar(b) {}
+    void visibleAreaChanged(const juce::Rectangle<int>& area) override {
+      bar->updateVisibleFrames(area);
+    }
   };
 
+  juce::SharedResourcePointer<ThumbnailCache> cache;
+  juce::StringArray waveStrings;
+  std::vector<juce::int64> waveHashes;
+  std::vector<bool> selected;
   ThumbRow row;
-  juce::Viewport vpt;
+  ThumbViewport vpt;
   int numSelected = 0;
 
   std::vector<Listener*> tListeners = {};
   void focusFrame(int idx);
+  void updateVisibleFrames(const juce::Rectangle<int>& area);
+  void setFrameSelected(int idx, bool sel);
 
 public:
   WaveThumbnailBar(const String& fullStr);
-  int numFrames() const { return row.thumbnails.size(); }
+  ~WaveThumbnailBar() override;
+  int numFrames() const { return waveStrings.size(); }
   void resized() override;
+  void thumbnailsReady() override { row.repaint(); }
   int getNumSelected() const { return numSelected; }
+  bool isFrameSelected(int idx) const { return selected[(size_t)idx]; }
+  // draws the frame's image or a blank if it isn't rendered yet
+  void drawFrame(juce::Graphics& g, frect_t bounds, int idx);
   // the Thumbnail mouse overrides can call these on their parent
   void selectOnly(int idx);
   void selectUntil(int idx);
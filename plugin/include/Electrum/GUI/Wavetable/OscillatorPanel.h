@@ -48,6 +48,7 @@ public:
   void comboBoxChanged(juce::ComboBox* cb) override;
   void buttonClicked(juce::Button* b) override;
   void waveWasSaved(wave_meta_t* w) override;
+  void waveWasFound(wave_meta_t* w) override;
 
   JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(OscillatorPanel)
 };
@@ -16,21 +16,32 @@
 #define CAMERA_DISTANCE 0.3f
 
 #define WAVE_PATH_POINTS (WAVE_GRAPH_POINTS + 2)
+// the frames' colors depend on how far they are from the
+// current position, the cached stack gets redrawn each time
+// the position crosses into a new step
+#define WAVE_LAYER_COLOR_STEPS 16
 
 typedef std::array<vec3D_f, WAVE_PATH_POINTS> wave_vertices_t;
 typedef std::array<fpoint_t, WAVE_PATH_POINTS> wave_points_t;
 
 class WavetableGraph : public Component,
                        public juce::Timer,
-                       public juce::AsyncUpdater,
-                       public GraphingData::Listener {
+                       public juce::AsyncUpdater {
 private:
   ElectrumState* const state;
   juce::Image imgA;
   juce::Image imgB;
   juce::Image* viewedImg = &imgA;
   juce::Image* idleImg = &imgB;
+  // the stack of frames gets drawn into this once and then
+  // each redraw just copies it and adds the position trace on
+  // top. -1 means it needs drawing
+  juce::Image stackLayer;
+  int stackLayerStep = -1;
   float currentWavePos = 0.002f;
+  // the table we're currently drawing, we get a new handle
+  // whenever the oscillator's table changes
+  WaveSet::Ptr shownSet;
 
   std::vector<wave_vertices_t> waveVertArrays = {};
   std::vector<juce::Path> wavePaths = {};
@@ -51,20 +62,16 @@ public:
   void paint(juce::Graphics& g) override;
   void mouseUp(const juce::MouseEvent& me) override;
   void enablementChanged() override;
-  void graphingDataUpdated(GraphingData* gd) override {
-    if (gd->wavetablesChanged()) {
-      wavesReady = false;
-    }
-  }
 
 private:
-  void updateVertices(const String& wavetableStr);
+  void updateVertices(const WaveSet& waves);
   void updateVirtualVertices();
   void redrawBitmap();
   void redrawBitmapMulti();
   void redrawBitmapSingle();
   void redrawBitmapSingle(juce::Image* img);
   void redrawBitmapMulti(juce::Image* img);
+  void redrawStackLayer(int colorStep);
   size_t waveIndexBelow(float wavePos) const;
   static vec3D_f vertexLerp(const vec3D_f& a, const vec3D_f& b, float t);
 };
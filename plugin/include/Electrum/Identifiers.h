@@ -84,10 +84,35 @@ typedef juce::Component Component;
 typedef juce::ValueTree ValueTree;
 
 // this enum needs to contain every filter type we have
-enum FilterTypeE { LadderLPLinear, LadderLPSaturated, LadderHP, LadderBP };
+enum FilterTypeE {
+  LadderLPLinear,
+  LadderLPSaturated,
+  LadderHP,
+  LadderBP,
+  SVFLowPass,
+  SVFBandPass,
+  SVFHighPass,
+  SVFNotch,
+  SVFPeak
+};
 
 juce::StringArray getFilterTypeNames();
-#define NUM_FILTER_TYPES 4
+#define NUM_FILTER_TYPES 9
+
+// oversampling for the saturating filters, each step doubles
+// the rate
+enum OversamplingE { OversampleOff, Oversample2x, Oversample4x };
+inline juce::StringArray getOversamplingNames() {
+  return {"Off", "2x", "4x"};
+}
+#define NUM_OVERSAMPLING_MODES 3
+
+// how the filters connect: side by side, or with filter 1
+// feeding into filter 2
+enum FilterRoutingE { FilterParallel, FilterSerial };
+inline juce::StringArray getFilterRoutingNames() {
+  return {"Parallel", "Serial"};
+}
 
 // similar thing for LFO trigger types
 enum LFOTriggerE { Global, RetrigStart, RetrigRand };
@@ -115,6 +140,9 @@ inline juce::StringArray getNoteSubdivNames() {
 #define NUM_ENVELOPES 3
 #define NUM_LFOS 3
 #define NUM_FILTERS 2
+// the most samples a voice renders at once, the engine splits
+// each host block at MIDI events and modulation updates
+#define MAX_VOICE_BLOCK 64
 
 // oscillator
 #define OSC_POS_DEFAULT 0.1f
@@ -229,6 +257,14 @@ DECLARE_ID(filterGainDb)
 DECLARE_ID(filterOsc1On)
 DECLARE_ID(filterOsc2On)
 DECLARE_ID(filterOsc3On)
+DECLARE_ID(filterRouting)
+
+// oversampling, with separate settings for playing live
+// and for offline rendering
+DECLARE_ID(oversamplingRealtime)
+DECLARE_ID(oversamplingOffline)
+// anti-aliased saturation for the ladder filters
+DECLARE_ID(filterSaturationADAA)
 
 // LFO
 DECLARE_ID(lfoFrequencyHz)
@@ -240,6 +276,7 @@ DECLARE_ID(lfoBeatSync)
 DECLARE_ID(perlinFrequency)
 DECLARE_ID(perlinOctaves)
 DECLARE_ID(perlinLacunarity)
+DECLARE_ID(perlinPerVoice)
 
 //--------------------------------------------------
 // patch metadata stuff
@@ -258,6 +295,24 @@ DECLARE_ID(waveAuthor)
 DECLARE_ID(waveCategory)
 DECLARE_ID(waveStringData)
 
+// library index stuff
+DECLARE_ID(LIBRARY_INDEX)
+DECLARE_ID(indexVersion)
+DECLARE_ID(INDEX_ENTRY)
+DECLARE_ID(indexFilePath)
+DECLARE_ID(indexModTime)
+DECLARE_ID(indexFileSize)
+DECLARE_ID(indexContentHash)
+DECLARE_ID(indexWaveOrder)
+
+// host state stuff
+DECLARE_ID(WAVE_REFS)
+DECLARE_ID(WAVE_REF)
+DECLARE_ID(waveRefOsc)
+DECLARE_ID(waveRefHash)
+DECLARE_ID(programIndex)
+DECLARE_ID(programPath)
+
 DECLARE_ID(LFO_INFO)
 DECLARE_ID(lfoShapeString)
 DECLARE_ID(lfoShapeHash)
@@ -4,6 +4,7 @@
 #include "Electrum/Audio/Modulator/AHDSR.h"
 #include "Electrum/Audio/Modulator/LFO.h"
 #include "Electrum/Audio/Modulator/Perlin.h"
+#include "Electrum/Audio/Synth/FilterRouting.h"
 #include "Electrum/Audio/Wavetable.h"
 #include "Electrum/Identifiers.h"
 
@@ -22,8 +23,18 @@ public:
   Wavetable wOsc[NUM_OSCILLATORS];
   EnvelopeLUT env[NUM_ENVELOPES];
   shared_filter_params filters[NUM_FILTERS];
+  FilterRouter routing;
+  OversamplingE oversampleRealtime = OversampleOff;
+  OversamplingE oversampleOffline = Oversample4x;
+  bool saturationADAA = false;
   LowFrequencyLUT lfos[NUM_LFOS];
   RollingRMS polyRMS;
-  PerlinGenerator perlinGens[NUM_PERLIN_GENS];
+  // each generator gets its own seed so they don't
+  // move in lockstep with the same settings
+  PerlinGenerator perlinGens[NUM_PERLIN_GENS] = {PerlinGenerator(0),
+                                                 PerlinGenerator(1)};
+  // each generator's value at every sample of the block
+  // being rendered
+  float perlinValues[NUM_PERLIN_GENS][MAX_VOICE_BLOCK] = {};
   CommonAudioData() = default;
 };
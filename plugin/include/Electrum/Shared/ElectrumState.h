@@ -2,6 +2,8 @@
 #include "../Identifiers.h"
 #include "Electrum/Shared/CommonAudioData.h"
 #include "Electrum/Shared/FileSystem.h"
+#include "Electrum/Shared/ModMap.h"
+#include "Electrum/Shared/PatchLoader.h"
 #include "GraphingData.h"
 #include "juce_audio_basics/juce_audio_basics.h"
 #include "juce_data_structures/juce_data_structures.h"
@@ -16,32 +18,6 @@ struct rhythm_state_t {
 };
 //======================================
 
-typedef std::array<std::array<float, MOD_DESTS>, MOD_SOURCES> depth_array_t;
-typedef std::array<std::array<bool, MOD_DESTS>, MOD_SOURCES> toggle_array_t;
-
-struct mod_src_t {
-  int source;
-  float depth;
-};
-
-class ModMap {
-private:
-  depth_array_t depthArr;
-  toggle_array_t boolArr;
-  void clearBoolGrid();
-
-public:
-  ModMap();
-  void updateMap(ValueTree modTree);
-  bool modExists(int src, int dest) const;
-  int numSourcesOnDest(int dest) const;
-  bool destInUse(int dest) const { return numSourcesOnDest(dest) > 0; }
-  std::vector<mod_src_t> getSourcesFor(int dest);
-  void getSourcesSafe(mod_src_t* arr, int* numSources, int destID) const;
-};
-
-//===========================================================
-
 struct timed_midi_msg {
   int timestamp;
   juce::MidiMessage message;
@@ -58,6 +34,9 @@ private:
   bool sustainPedal = false;
   float modWheelValue = 0.0f;
   std::array<int, NUM_OSCILLATORS> lastWaveIndices;
+  // a prepared patch the audio thread couldn't swap in all
+  // of yet
+  PreparedPatch* heldPatch = nullptr;
 
   // time signature/tempo stuff
 
@@ -71,6 +50,7 @@ private:
 
 public:
   ElectrumState(juce::AudioProcessor& proc, juce::UndoManager* undo);
+  ~ElectrumState() override;
   inline ValueTree getModulationTree() {
     return state.getChildWithName(ID::ELECTRUM_MOD_TREE);
   }
@@ -108,11 +88,32 @@ public:
   ElectrumUserLib userLib;
   // the shared LUTs and such four our voices
   CommonAudioData audioData;
+  // builds patches and waves in the background for the
+  // audio thread to swap in
+  PatchLoader patchLoader;
 
   void updateLFOString(const String& shapeString, int lfoID);
 
   void updateCommonAudioData();
+  // message thread, builds any envelope or LFO tables the
+  // last block asked for and lets go of retired wave sets
+  // right away instead of waiting on the message loop. For
+  // rendering without a host
+  void flushAsyncUpdates();
   void ensureLFOTree();
+  // the oscillators' wave parameters are indices into this
+  // machine's wave list, so the host state also records each
+  // wave's content hash and name. These add that to a copy
+  // of the state and point the parameters back at the right
+  // waves when it's loaded
+  void addWaveRefs(ValueTree& stateCopy) const;
+  void resolveWaveRefs(ValueTree& newState) const;
+  // swaps in a patch the loader has finished: waves, LFO
+  // shapes, parameters and modulations together. Audio
+  // thread, or any thread while nothing is being processed.
+  // False if it can't all go in yet, in which case none of
+  // it has and it's worth another try next block
+  bool commitPrepared(const PreparedPatch& p);
 
 private:
   ValueTree findTreeForRouting(const ValueTree& modTree, int src, int dest);
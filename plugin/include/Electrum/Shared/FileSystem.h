@@ -1,6 +1,9 @@
 #pragma once
 #include "../Common.h"
 #include "Electrum/Identifiers.h"
+#include "Electrum/Shared/LibraryWatcher.h"
+#include <map>
+#include <set>
 
 // the categories we'll divide the patch library into
 enum patch_categ_t { Bass, Lead, Keys, Pad, Other };
@@ -45,8 +48,17 @@ const juce::StringArray WaveCategStrings = {"Analog", "Digital", "User"};
 
 const String patchFileExt = ".epf";
 const String waveFileExt = ".ewf";
+// the folder with the patches, waves and index in it. This
+// is ElectrumData in the user's app data folder unless
+// something else was set, which the tests use to get a
+// library of their own. Set it before any ElectrumUserLib
+// exists, or pass File() to go back to the default
+void setDataFolder(const File& folder);
+File getDataFolder();
 File getPatchesFolder();
 File getWavetablesFolder();
+// where the LibraryIndex keeps its cache
+File getLibraryIndexFile();
 // check whether a file is a valid Electrum patch
 bool isValidPatch(const File& file);
 // check for a valid wavetable
@@ -56,23 +68,38 @@ bool isValidWave(const File& file);
 bool attemptPatchSave(ValueTree& state);
 bool attemptWaveSave(const wave_meta_t& wave, const String& waveString);
 String loadTableStringForWave(const String& name);
-
-// this should run on startup to
-// save the list of patches on the system
-std::vector<patch_meta_t> getAvailiblePatches();
-std::vector<wave_meta_t> getAvailableWaves();
+// parses and validates a whole patch file, the tree is
+// invalid if it isn't one. Safe to call from any thread
+ValueTree loadPatchTree(const File& file);
 }  // namespace UserFiles
 
 //====================================================
+class LibraryIndex;
+class PatchSearchIndex;
+
 /* Object for managing and editing the
  * patch and wavetable files. the master
  * ElectrumState should own one of these
- * and let components access it via pointer
+ * and let components access it via pointer.
+ *
+ * Whatever was in the LibraryIndex is available as soon as
+ * this is constructed, the folders then get checked on a
+ * background pool and anything new, changed or missing
+ * gets merged in on the message thread and sent out to the
+ * listeners. After that the shared LibraryWatcher reports
+ * files that other instances or tools add, change or
+ * delete, and those go through the same path. Waves never
+ * get removed or reordered while the plugin is running
+ * since the oscillators refer to them by index.
  * */
-class ElectrumUserLib {
+class ElectrumUserLib : private juce::AsyncUpdater,
+                        private LibraryWatcher::Listener {
 private:
-  std::vector<patch_meta_t> patches;
-  std::vector<wave_meta_t> waves;
+  juce::OwnedArray<patch_meta_t> patches;
+  juce::OwnedArray<wave_meta_t> waves;
+  // the audio thread reads the wave list, so it only changes
+  // under this lock
+  juce::CriticalSection waveLock;
   bool isPatchNameLegal(const String& name) const;
   bool isWaveNameLegal(const String& name) const;
 
@@ -84,21 +111,41 @@ public:
     virtual ~Listener() {}
     virtual void patchWasSaved(patch_meta_t*) {}
     virtual void waveWasSaved(wave_meta_t*) {}
+    // the background scan found a file that wasn't in the
+    // index
+    virtual void patchWasFound(patch_meta_t*) {}
+    virtual void waveWasFound(wave_meta_t*) {}
+    // called just before the patch gets deleted
+    virtual void patchWasRemoved(patch_meta_t*) {}
+    virtual void libraryScanFinished() {}
   };
   ElectrumUserLib();
+  ~ElectrumUserLib() override;
   // GUI should call this to check if
   // the user's entered metadata is legal
   bool validatePatchData(patch_meta_t* patch) const;
   bool validateWaveData(wave_meta_t* patch) const;
-  int numPatches() const { return (int)patches.size(); }
-  int numWavetables() const { return (int)waves.size(); }
+  int numPatches() const { return patches.size(); }
+  int numWavetables() const { return waves.size(); }
+  bool isScanning() const { return scanJobsLeft.load() > 0; }
   bool attemptPatchSave(apvts* tree, const patch_meta_t& patchData);
   bool attemptWaveSave(const wave_meta_t& waveData, const String& waveString);
   patch_meta_t* getPatchAtIndex(int index);
   patch_meta_t* getPatch(const String& name);
+  // type-ahead search over the patches' metadata, best
+  // match first
+  std::vector<patch_meta_t*> searchPatches(const String& query) const;
   wave_meta_t* getWavetableData(const String& name);
   wave_meta_t* getWavetableData(int index);
+  // for the audio thread, returns false without waiting if
+  // the list is being changed or the index is out of range
+  bool tryGetWaveName(int index, String& dest) const;
   int indexOfWaveName(const String& name) const;
+  // the hash of the wave file's contents, or 0 if it hasn't
+  // been indexed yet
+  juce::int64 getWaveHash(int waveIdx) const;
+  // -1 if there's no wave with this hash
+  int indexOfWaveHash(juce::int64 hash) const;
   juce::StringArray getAvailableWaveNames() const;
   // wave getters
 
@@ -117,5 +164,47 @@ public:
 
 private:
   std::vector<Listener*> listeners;
-  //
+  // background scan stuff
+  class FolderScanJob;
+  class FileParseJob;
+  struct scan_result_t {
+    bool isPatch;
+    // a freshly read INDEX_ENTRY, or invalid if this is a
+    // folder's listing or a deleted file
+    ValueTree entry;
+    std::set<String> found;
+    // full path of a file that was deleted
+    String removed;
+  };
+  std::unique_ptr<LibraryIndex> index;
+  std::unique_ptr<PatchSearchIndex> searchIndex;
+  // lowercase names, for checking new names and getPatch()
+  std::multimap<String, patch_meta_t*> patchNames;
+  juce::CriticalSection resultLock;
+  std::vector<scan_result_t> scanResults;
+  // jobs whose results haven't been merged yet
+  std::atomic<int> scanJobsLeft;
+  // by full path
+  std::map<String, patch_meta_t*> patchFiles;
+  std::map<String, wave_meta_t*> waveFiles;
+  juce::SharedResourcePointer<LibraryWatcher> watcher;
+
+  // declared last so that it's destroyed first, the jobs
+  // use everything above
+  juce::ThreadPool scanPool;
+
+  void postScanResult(scan_result_t&& result);
+  void handleAsyncUpdate() override;
+  void libraryFilesChanged(bool isPatch,
+                           const juce::StringArray& paths) override;
+  void libraryFolderChanged(bool isPatch) override;
+  void mergeEntry(const scan_result_t& result);
+  void mergeFolderListing(const scan_result_t& result);
+  void mergeRemoval(const scan_result_t& result);
+  void addWave(const wave_meta_t& wave, const String& path);
+  // these keep the path/name maps and search index in sync
+  patch_meta_t* addPatch(const patch_meta_t& patch, const String& path);
+  void updatePatch(patch_meta_t* existing, const patch_meta_t& patch);
+  void eraseName(patch_meta_t* patch);
+  void removePatch(patch_meta_t* patch);
 };
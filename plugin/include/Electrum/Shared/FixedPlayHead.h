@@ -0,0 +1,18 @@
+#pragma once
+#include <juce_audio_basics/juce_audio_basics.h>
+
+/* Stands in for the host when something drives the
+ * processor directly, like the offline renderer or the
+ * benchmarks. processBlock() asks for the tempo on the first
+ * block, so this always reports a playing 4/4 at 'bpm'.
+ * */
+struct fixed_play_head_t : public juce::AudioPlayHead {
+  double bpm = 120.0;
+  juce::Optional<PositionInfo> getPosition() const override {
+    PositionInfo info;
+    info.setBpm(bpm);
+    info.setTimeSignature(TimeSignature{4, 4});
+    info.setIsPlaying(true);
+    return info;
+  }
+};
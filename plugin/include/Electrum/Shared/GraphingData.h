@@ -1,127 +1,108 @@
 #pragma once
 #include "Electrum/Identifiers.h"
+#include "SPSCRing.h"
 #include "juce_core/juce_core.h"
 #include "juce_core/system/juce_PlatformDefs.h"
 
 // handy type aliases
-typedef std::atomic<float> float_at;
-typedef std::atomic<int> int_at;
-typedef std::atomic<uint32_t> uint32_at;
 typedef std::atomic<bool> bool_at;
 
 #define WAVE_GRAPH_POINTS 70
 
 typedef std::array<float, WAVE_GRAPH_POINTS> graph_wave_t;
 
-class AtomicIntStack {
+// only the audio thread touches this
+class VoiceIndexStack {
 private:
-  std::array<int_at, 32> data = {};
-  int_at head;
+  std::array<int, 32> data = {};
+  int head = -1;
 
 public:
-  AtomicIntStack() : head(-1) {}
+  VoiceIndexStack() = default;
   bool empty() const { return head < 0; }
-  int top() const { return data[(size_t)head].load(); }
+  int top() const { return data[(size_t)head]; }
   void pop() { head--; }
   void push(int val) {
-    if (head == 32) {
-      head = 0;
+    if (head == 31) {
+      head = -1;
     }
     data[(size_t)++head] = val;
   }
 };
 
-/* This class atomically stores data
- * about the audio thread that our
- * various GUI components need to access
+// one frame's worth of everything the GUI graphs from the
+// audio thread, the audio thread fills one of these in and
+// publishes it with a single copy
+struct telemetry_snapshot_t {
+  uint32_t voicesState = 0;
+  int newestVoice = -1;
+  float oscPositions[NUM_OSCILLATORS] = {};
+  float envLevels[NUM_ENVELOPES] = {};
+  float lfoPhases[NUM_LFOS] = {};
+  float perlinLevels[NUM_PERLIN_GENS] = {};
+  float modDestValues[MOD_DESTS] = {};
+  float polyLevel = 0.0f;
+  float monoLevel = 0.0f;
+};
+
+// the GUI asks for one snapshot per frame, so this only
+// needs room for a few in case it falls behind
+#define TELEMETRY_RING_SIZE 8
+
+/* This class passes data about the audio thread to the
+ * various GUI components that need it. Each frame the
+ * timer asks the audio thread for a snapshot, and the next
+ * block pushes one onto the ring. The timer picks it up on
+ * the message thread and sends it to the listeners.
  * */
 class GraphingData : public juce::Timer {
 private:
-  // just in case we need to lock maybe
-  juce::CriticalSection criticalSection;
-  int_at voicesState;
-  int_at newestVoice;
-  AtomicIntStack voiceIndeces;
-
-  std::array<float_at, NUM_OSCILLATORS> newestOscPositions;
-  std::array<float_at, NUM_ENVELOPES> newestEnvLevels;
-  std::array<float_at, NUM_LFOS> newestLfoPhases;
-  std::array<float_at, NUM_PERLIN_GENS> newestPerlinLevels;
-  std::array<float_at, MOD_DESTS> newestModDestValues;
-  float_at polyLevel;
-  float_at monoLevel;
+  // audio thread only
+  uint32_t voicesState = 0;
+  int newestVoice = 0;
+  VoiceIndexStack voiceIndeces;
+  SPSCRing<telemetry_snapshot_t, TELEMETRY_RING_SIZE> ring;
+  // message thread only, the newest snapshot we've got
+  telemetry_snapshot_t latest;
 
   // keep track of when we want updates
   bool_at updateRequested;
 
-  // string-encoded versions of our wavetables
-  // that our graphics code can (god willing) safely
-  // access
-  std::array<String, NUM_OSCILLATORS> waveStrings;
-  bool_at needsWaveStrings;
-  bool_at waveStringsHaveChanged;
-
   // get some performance by skipping updates here when the editor isn't open
   bool_at editorOpen;
 
 public:
   GraphingData();
-  void timerCallback() override { updateRequested = true; }
+  void timerCallback() override;
   bool wantsUpdate() const {
-    // return updateRequested.load() && newestVoice != -1;
     return updateRequested.load() && editorOpen.load();
   }
-  void updateFinished() {
-    _notifyListeners();
-    updateRequested = false;
-    waveStringsHaveChanged = false;
-    needsWaveStrings = false;
-  }
+  // call this on the audio thread once the snapshot is
+  // filled in, the voice state gets added here
+  void publish(telemetry_snapshot_t& snap);
 
   void setEditorOpen(bool open) { editorOpen = open; }
   // call this so we can keep track of which voice to be tracking from
   void voiceStarted(int idx);
   void voiceEnded(int idx);
-  int getNewestVoiceIndex() const { return newestVoice.load(); }
-  // call these on the 'newestVoice' at update time to do the actual
-  // data copying
-  void updateOscPos(int oscID, float value) {
-    newestOscPositions[(size_t)oscID] = value;
-  }
+  int getNewestVoiceIndex() const { return newestVoice; }
+  // the GUI side, these read the latest snapshot
   float getOscPos(int oscID) const {
-    return newestOscPositions[(size_t)oscID].load();
-  }
-  void updateEnvLevel(int envID, float value) {
-    newestEnvLevels[(size_t)envID] = value;
+    return latest.oscPositions[(size_t)oscID];
   }
   float getEnvLevel(int envID) const {
-    return newestEnvLevels[(size_t)envID].load();
+    return latest.envLevels[(size_t)envID];
   }
-  void updateLFOPhase(int lfoID, float value) {
-    newestLfoPhases[(size_t)lfoID] = value;
-  }
-
   float getLFOPhase(int lfoID) const {
-    return newestLfoPhases[(size_t)lfoID].load();
-  }
-  void setPolyLevel(float val) { polyLevel = val; }
-  float getPolyLevel() const { return polyLevel.load(); }
-  void setMonoLevel(float val) { monoLevel = val; }
-  float getMonoLevel() const { return monoLevel.load(); }
-  void updatePerlinLevel(int idx, float level) {
-    newestPerlinLevels[(size_t)idx] = level;
+    return latest.lfoPhases[(size_t)lfoID];
   }
+  float getPolyLevel() const { return latest.polyLevel; }
+  float getMonoLevel() const { return latest.monoLevel; }
   float getPerlinLevel(int idx) const {
-    return newestPerlinLevels[(size_t)idx].load();
+    return latest.perlinLevels[(size_t)idx];
   }
-
-  // wave string stuff
-  bool needsWavetableData() const { return needsWaveStrings; }
-  bool wavetablesChanged() const { return waveStringsHaveChanged; }
-  void requestWavetableString(int) { needsWaveStrings = true; }
-  void updateWavetableString(const String& wave, int oscID);
-  String getWavetableString(int oscID) const noexcept {
-    return waveStrings[(size_t)oscID];
+  float getModulationDest(int destID) const {
+    return latest.modDestValues[(size_t)destID];
   }
 
   // Graphing components should inherit from this to get
@@ -137,13 +118,6 @@ public:
   //-----------------------
   void addListener(Listener* l) { graphListeners.push_back(l); }
   void removeListener(Listener* l);
-  // modulation dests------------------
-  void updateModulationDest(int destID, float value) {
-    newestModDestValues[(size_t)destID] = value;
-  }
-  float getModulationDest(int destID) const {
-    return newestModDestValues[(size_t)destID].load();
-  }
 
 private:
   std::vector<Listener*> graphListeners = {};
@@ -0,0 +1,59 @@
+#pragma once
+#include "Electrum/Shared/FileSystem.h"
+#include <map>
+#include <set>
+
+// bump this when the entry format changes, older indexes
+// just get rebuilt
+#define LIBRARY_INDEX_VERSION 1
+
+/* Persistent cache of the metadata for every patch and
+ * wavetable file. Each entry holds a file's modification
+ * time, size, a hash of its contents and its PATCH_INFO or
+ * WAVE_INFO tree. Checking the index against the folders
+ * only needs a directory listing, and a file is read and
+ * parsed only when it's new or has changed. The rest of a
+ * patch or wave is loaded when something actually uses it.
+ *
+ * isUpToDate() and readEntry() can be called from the scan
+ * threads, everything else belongs to the message thread.
+ * */
+class LibraryIndex {
+public:
+  // loads the index file, if there is one
+  LibraryIndex();
+  // copies of the entries whose metadata is of the given
+  // type (PATCH_INFO or WAVE_INFO) as of the last scan,
+  // without touching the files
+  std::vector<ValueTree> getCachedEntries(const juce::Identifier& type) const;
+  // true if the file's size and mod time match its entry
+  bool isUpToDate(const File& file) const;
+  // reads the file and builds a new entry for it, reusing
+  // the old metadata if the contents haven't changed
+  ValueTree readEntry(const File& file, bool isPatch) const;
+  // keeps the old entry's wave order if the new one doesn't
+  // have one
+  void setEntry(const ValueTree& entry);
+  // where a wave sits in the wave list. Patches refer to
+  // waves by index, so the list gets put back in this order
+  // on the next launch
+  void setWaveOrder(const String& path, int order);
+  // 0 if the file isn't in the index
+  juce::int64 getContentHash(const String& path) const;
+  void removeEntry(const String& path);
+  // drops the entries in the folder that weren't found and
+  // returns their paths
+  juce::StringArray removeMissing(const File& folder,
+                                  const std::set<String>& found);
+  // writes the index back out if anything changed
+  bool save();
+
+private:
+  juce::CriticalSection lock;
+  // entries by full path
+  std::map<String, ValueTree> entries;
+  bool changed = false;
+  // the metadata tree or an invalid tree if the file isn't
+  // a valid patch/wave
+  static ValueTree parseMetadata(const String& fileText, bool isPatch);
+};
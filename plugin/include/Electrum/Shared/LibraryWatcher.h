@@ -0,0 +1,68 @@
+#pragma once
+#include "Electrum/Common.h"
+#include <map>
+#include <set>
+
+// how long the folders need to be quiet before a batch of
+// changes goes out, so a file being written in pieces is
+// only parsed once
+#define WATCHER_SETTLE_MS 250
+// how often the fallback checks the folders
+#define WATCHER_POLL_MS 2000
+
+/* Watches the patch and wavetable folders for files being
+ * created, changed or deleted by other instances or tools.
+ * On Linux this uses inotify, anywhere else (or if inotify
+ * isn't available) it falls back to listing the folders
+ * every few seconds and diffing against the last listing.
+ * Grab it through a juce::SharedResourcePointer so every
+ * instance in the process shares the one thread.
+ * */
+class LibraryWatcher : private juce::Thread {
+public:
+  class Listener {
+  public:
+    Listener() = default;
+    virtual ~Listener() {}
+    // called on the watcher thread with the full paths of
+    // files that were created, changed or deleted
+    virtual void libraryFilesChanged(bool isPatch,
+                                     const juce::StringArray& paths) = 0;
+    // called on the watcher thread when the changes couldn't
+    // be tracked file by file and the whole folder needs
+    // checking
+    virtual void libraryFolderChanged(bool isPatch) = 0;
+  };
+  LibraryWatcher();
+  ~LibraryWatcher() override;
+  // once this returns the listener won't get any more
+  // callbacks
+  void addListener(Listener* l);
+  void removeListener(Listener* l);
+
+private:
+  // guards the listeners so removeListener() can wait out a
+  // callback in progress
+  juce::CriticalSection listenerLock;
+  std::vector<Listener*> listeners;
+  // modification time and size by full path
+  typedef std::map<String, std::pair<juce::int64, juce::int64>> snapshot_t;
+  snapshot_t patchSnapshot;
+  snapshot_t waveSnapshot;
+  // paths waiting for the folders to settle
+  std::set<String> pendingPatches;
+  std::set<String> pendingWaves;
+
+  void run() override;
+  // returns false if inotify couldn't be set up
+  bool watchWithInotify();
+  void watchWithPolling();
+  // lists the folder and adds anything that differs from the
+  // snapshot to the pending set
+  static void pollFolder(const File& folder,
+                         const String& ext,
+                         snapshot_t& snapshot,
+                         std::set<String>& pending);
+  void sendPending();
+  void sendFolderChanged(bool isPatch);
+};
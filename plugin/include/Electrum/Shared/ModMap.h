@@ -0,0 +1,26 @@
+#pragma once
+#include "../Identifiers.h"
+
+typedef std::array<std::array<float, MOD_DESTS>, MOD_SOURCES> depth_array_t;
+typedef std::array<std::array<bool, MOD_DESTS>, MOD_SOURCES> toggle_array_t;
+
+struct mod_src_t {
+  int source;
+  float depth;
+};
+
+class ModMap {
+private:
+  depth_array_t depthArr;
+  toggle_array_t boolArr;
+  void clearBoolGrid();
+
+public:
+  ModMap();
+  void updateMap(ValueTree modTree);
+  bool modExists(int src, int dest) const;
+  int numSourcesOnDest(int dest) const;
+  bool destInUse(int dest) const { return numSourcesOnDest(dest) > 0; }
+  std::vector<mod_src_t> getSourcesFor(int dest);
+  void getSourcesSafe(mod_src_t* arr, int* numSources, int destID) const;
+};
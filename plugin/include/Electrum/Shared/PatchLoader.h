@@ -0,0 +1,277 @@
+#pragma once
+#include "Electrum/Shared/CommonAudioData.h"
+#include "Electrum/Shared/FileSystem.h"
+#include "Electrum/Shared/ModMap.h"
+
+// how often the loader checks for waves and programs the
+// audio thread has asked for. Patch loads from the browser
+// wake it up straight away
+#define PATCH_LOADER_POLL_MS 10
+// how many built wave sets the loader hangs on to so
+// switching back and forth doesn't rebuild them
+#define PATCH_LOADER_CACHE_SIZE 16
+// default memory budget for the prepared patch cache
+#define PATCH_CACHE_BUDGET_MB 128
+// how many programs either side of the current one get
+// prepared ahead of time
+#define PATCH_PREFETCH_RADIUS 2
+// how many patches can be with the audio thread or on their
+// way back from it at once
+#define PATCH_LOADER_RING_SIZE 16
+// how many prepared programs the audio thread keeps on hand,
+// the current one and its neighbors
+#define PATCH_AUDIO_PROGRAMS (PATCH_PREFETCH_RADIUS * 2 + 1)
+
+// a parameter value from a patch, normalized, by the
+// parameter's index in the processor's list
+struct prepared_param_t {
+  int index;
+  float value;
+};
+
+/* Everything about a patch, built ahead of time so the
+ * audio thread can swap the lot in at the start of one
+ * block: the parameter values and modulations along with
+ * the waves and LFO shapes. Anything that isn't changing is
+ * left empty. These don't change once they're built, so the
+ * same one can be cached and sent again.
+ * */
+class PreparedPatch : public juce::ReferenceCountedObject {
+public:
+  typedef juce::ReferenceCountedObjectPtr<PreparedPatch> Ptr;
+  PreparedPatch();
+  // the full state, invalid if this is just some waves. The
+  // message thread swaps a copy in once the audio thread has
+  // committed the rest, so the cached one stays as it was in
+  // the file
+  ValueTree tree;
+  // the tree's parameters and modulations in a form the
+  // audio thread can apply. Parameters the patch doesn't
+  // have are left as they are
+  std::vector<prepared_param_t> params;
+  ModMap modulations;
+  bool hasModulations = false;
+  // the built set for each oscillator, the index of the wave
+  // it came from and that wave's content hash
+  std::array<WaveSet::Ptr, NUM_OSCILLATORS> waves;
+  std::array<int, NUM_OSCILLATORS> waveIndices;
+  std::array<juce::int64, NUM_OSCILLATORS> waveHashes;
+  // decoded LFO shapes and the hashes of the strings they
+  // came from
+  std::array<lfo_table_t, NUM_LFOS> lfoTables;
+  std::array<size_t, NUM_LFOS> lfoHashes;
+  std::array<bool, NUM_LFOS> hasLfo;
+  JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(PreparedPatch)
+};
+
+class ElectrumState;
+
+/* Loads patches in two phases. A background thread parses
+ * the file into a PreparedPatch, with its parameter values,
+ * modulations, built wave sets and decoded LFO shapes, and
+ * hands it straight to the audio thread. That commits all of
+ * it at the start of one block, so nothing ever plays with
+ * half of a patch. The message thread then catches the
+ * tree up with replaceState(), which finds the parameters
+ * already set. Wave changes that don't come from a patch
+ * (the oscillator menus, automation, a host loading its
+ * state) go through the same path so the audio thread never
+ * touches the disk.
+ *
+ * This also maps the library onto the host's programs,
+ * sorted by category and then name. Prepared patches are
+ * kept in an LRU cache under a memory budget and the
+ * programs either side of the current one get prepared
+ * while the loader is idle. Those get passed to the audio
+ * thread too, so a program change to one of them is just a
+ * pointer it already has, committed in the next block
+ * without waiting on this thread or the message thread.
+ * */
+class PatchLoader : private juce::Thread,
+                    private juce::AsyncUpdater,
+                    private ElectrumUserLib::Listener {
+public:
+  PatchLoader(ElectrumState* s);
+  ~PatchLoader() override;
+  // message thread. If a load is already in progress this
+  // one replaces it once it's done
+  void loadPatch(patch_meta_t* patch);
+  // message thread, loads and commits a patch before
+  // returning, for running without a host. Only safe while
+  // nothing is being processed. False if it couldn't be read
+  bool loadPatchNow(const File& file);
+  // any thread, including the audio thread for MIDI program
+  // changes. Never blocks
+  void requestProgram(int program);
+  // message thread, for the host
+  int getNumPrograms() const;
+  int getCurrentProgram() const { return currentProgram.load(); }
+  String getProgramName(int program) const;
+  // message thread. The host state records the current
+  // program along with its file, since the numbers shift
+  // when the library changes. Resolving it takes it back out
+  // and sets the current program without loading anything,
+  // so a host setting the same program again right after
+  // doesn't throw the restored state away
+  void addProgramRef(ValueTree& stateCopy) const;
+  void resolveProgramRef(ValueTree& newState);
+  // message thread, evicts down to the new budget on the
+  // next load
+  void setCacheBudget(size_t bytes) { cacheBudget.store(bytes); }
+  // audio thread, asks for a wave to be built for an
+  // oscillator. Never blocks
+  void requestWave(int osc, int waveIdx);
+  // audio thread, the next finished patch or null. A
+  // program change it has the patch for comes first. Call
+  // finishedWith() once it's committed
+  PreparedPatch* nextPrepared();
+  void finishedWith(PreparedPatch* p);
+  // audio thread. From when a patch is committed until the
+  // message thread has swapped its tree in, the tree's
+  // modulations and LFO shapes are older than what's
+  // playing and shouldn't be read
+  bool stateIsBehind() const { return numBehind.load() > 0; }
+
+private:
+  ElectrumState* const state;
+  // held while preparing anything, so loadPatchNow() can use
+  // the caches from another thread
+  juce::CriticalSection prepareLock;
+  // the file for the next patch load, guarded by loadLock
+  juce::CriticalSection loadLock;
+  File wantedPatch;
+  std::atomic<int> wantedProgram{-1};
+  std::atomic<int> currentProgram{0};
+  // counts calls to requestProgram(), so a program this
+  // thread took a while to load doesn't undo a later one
+  // the audio thread had on hand
+  std::atomic<int> programRequests{0};
+  // what the audio thread has asked for, and what this
+  // thread has most recently built for each oscillator
+  std::array<std::atomic<int>, NUM_OSCILLATORS> wantedWaves;
+  std::array<int, NUM_OSCILLATORS> builtWaves;
+  // built sets by content hash, most recent last. Only
+  // touched by this thread
+  std::vector<std::pair<juce::int64, WaveSet::Ptr>> waveCache;
+
+  // the library in program order. Rebuilt on the message
+  // thread when the library changes, guarded by programLock
+  struct program_t {
+    String name;
+    File file;
+  };
+  juce::CriticalSection programLock;
+  std::vector<program_t> programs;
+  bool programsChanged = false;
+  // set when the list is rebuilt, the numbers the audio
+  // thread has its programs under may be wrong now
+  std::atomic<bool> programsMoved{false};
+
+  // prepared patches by file, most recent last. Only touched
+  // by this thread
+  struct cached_patch_t {
+    File file;
+    juce::Time modified;
+    PreparedPatch::Ptr patch;
+  };
+  std::vector<cached_patch_t> patchCache;
+  std::atomic<size_t> cacheBudget{(size_t)PATCH_CACHE_BUDGET_MB << 20};
+  // programs to prepare when there's nothing else to do,
+  // nearest first, and the one they're around
+  std::vector<int> prefetchQueue;
+  int prefetchCenter = -1;
+
+  // finished by this thread and waiting for room in
+  // toAudio. Only touched by this thread
+  std::vector<PreparedPatch::Ptr> unsent;
+  // this thread to the audio thread, and back out to the
+  // message thread once they're committed. Each patch in
+  // either ring holds a reference of its own, which the
+  // message thread lets go of
+  struct returned_patch_t {
+    PreparedPatch* patch;
+    // false if the audio thread is just done holding on to
+    // it
+    bool committed;
+  };
+  SPSCRing<PreparedPatch*, PATCH_LOADER_RING_SIZE> toAudio;
+  SPSCRing<returned_patch_t, PATCH_LOADER_RING_SIZE> fromAudio;
+  // references handed over and not let go of yet, kept
+  // under the ring size so fromAudio never fills up. This
+  // thread and the audio thread both take them
+  std::atomic<int> numOutstanding{0};
+  // prepared programs for the audio thread to keep on hand,
+  // each holding a reference like the patches in toAudio.
+  // One with no patch means let go of all of them
+  struct program_patch_t {
+    int program;
+    PreparedPatch* patch;
+  };
+  SPSCRing<program_patch_t, PATCH_LOADER_RING_SIZE> programsToAudio;
+  // the audio thread's programs, oldest first. Only touched
+  // by the audio thread
+  std::array<program_patch_t, PATCH_AUDIO_PROGRAMS> audioPrograms;
+  int numAudioPrograms = 0;
+  // what this thread has sent it, in the same order so the
+  // two drop the same oldest one. Only touched by this
+  // thread
+  std::vector<std::pair<int, PreparedPatch::Ptr>> sentPrograms;
+  bool clearSentPrograms = false;
+  // committed patches the message thread hasn't swapped the
+  // trees of in yet
+  std::atomic<int> numBehind{0};
+
+  void run() override;
+  void handleAsyncUpdate() override;
+  // ElectrumUserLib::Listener, any of these can change the
+  // program order
+  void patchWasSaved(patch_meta_t*) override;
+  void patchWasFound(patch_meta_t*) override;
+  void patchWasRemoved(patch_meta_t*) override;
+  void libraryScanFinished() override;
+  void updatePrograms();
+  // -1 if the file isn't in the program list
+  int indexOfProgram(const File& file) const;
+  File getProgramFile(int program) const;
+
+  // the cached version if it's still good, otherwise a
+  // freshly prepared one that then gets cached
+  PreparedPatch::Ptr getPreparedPatch(const File& file);
+  // just the cached version, null if it isn't there or
+  // isn't still good
+  PreparedPatch::Ptr findCached(const File& file) const;
+  PreparedPatch::Ptr preparePatch(const File& file);
+  // the tree's parameter values, as the audio thread sets
+  // them
+  void prepareParams(PreparedPatch& p) const;
+  PreparedPatch::Ptr prepareWaves();
+  // whether the waves a cached patch was built with are the
+  // ones the library has now
+  bool wavesAreCurrent(const PreparedPatch& p) const;
+  void addToCache(const File& file, PreparedPatch::Ptr p);
+  size_t getCacheMemoryUsage() const;
+  // prepares the next program in the prefetch queue, false
+  // if there's nothing left to do
+  bool prefetchNext();
+  // builds the set for a wave or grabs it from the cache,
+  // null if the wave list is busy or the index is bad
+  WaveSet::Ptr buildWaveSet(int waveIdx);
+  // so an older wave request doesn't undo a patch's waves
+  void claimWaves(const PreparedPatch& p);
+  // sends a whole patch and queues up its neighbors
+  void sendPatch(const File& file, PreparedPatch::Ptr p);
+  void sendToAudio(PreparedPatch::Ptr p);
+  // pushes as much of unsent as there's room for
+  void sendUnsent();
+  // any thread that hands over a reference, false if that
+  // would be more than fromAudio can take back
+  bool claimOutstanding();
+  // prefetches around a new current program
+  void lineUpNeighbors(int program);
+  // sends the current program and its neighbors to the
+  // audio thread as they get cached
+  void sendPrograms();
+  // audio thread, takes in what sendPrograms() sent
+  void receivePrograms();
+  void returnFromAudio(PreparedPatch* p, bool committed);
+};
@@ -0,0 +1,99 @@
+#pragma once
+#include "Electrum/Shared/FileSystem.h"
+#include <map>
+
+// query terms at least this long that don't match anything
+// fall back to tokens one edit away, so typos still turn
+// something up
+#define SEARCH_FUZZY_MIN_LENGTH 3
+
+// which parts of a patch's metadata a token came from
+enum search_field_t : uint8_t {
+  SearchName = 1,
+  SearchAuthor = 2,
+  SearchDescription = 4,
+  SearchCategory = 8
+};
+
+/* In-memory search index over the patch library for the
+ * browser's type-ahead search. The metadata is split into
+ * lowercase alphanumeric tokens, each distinct token gets an
+ * id in a prefix trie, and each token id has a posting list
+ * of the patches it appears in along with which fields it
+ * came from.
+ *
+ * A query is split the same way and every term has to match
+ * for a patch to come up. The last term is treated as a
+ * prefix since it's probably still being typed. A term
+ * that matches nothing falls back to tokens one edit away,
+ * found by walking the trie with a Levenshtein row per
+ * node. Matches are scored by field (a name hit beats a
+ * description hit) and by how close the match is.
+ *
+ * Message thread only, ElectrumUserLib keeps it in sync
+ * with the library.
+ * */
+class PatchSearchIndex {
+public:
+  PatchSearchIndex();
+  void add(patch_meta_t* patch);
+  void remove(patch_meta_t* patch);
+  // re-index a patch whose metadata has changed
+  void update(patch_meta_t* patch);
+  int size() const { return numPatches; }
+  // the matching patches, best match first
+  std::vector<patch_meta_t*> search(const String& query) const;
+  // sorts the names for breaking ties between results.
+  // search() does this itself when it needs to, but it's
+  // the slow part so it's worth doing after a batch of
+  // changes rather than on the next keystroke
+  void updateNameRanks() const;
+  // lowercase alphanumeric runs
+  static juce::StringArray tokenize(const String& text);
+
+private:
+  struct trie_node_t {
+    // kept sorted by character
+    std::vector<std::pair<juce::juce_wchar, int>> children;
+    int token = -1;
+  };
+  struct posting_t {
+    int doc;
+    uint8_t fields;
+  };
+  struct doc_t {
+    patch_meta_t* patch = nullptr;
+    // the token ids this doc is in the posting lists of
+    std::vector<int> tokens;
+  };
+  std::vector<trie_node_t> nodes;
+  // posting lists by token id, sorted by doc
+  std::vector<std::vector<posting_t>> postings;
+  std::vector<doc_t> docs;
+  std::vector<int> freeDocs;
+  std::map<patch_meta_t*, int> docIds;
+  int numPatches = 0;
+
+  // scratch for search(), one slot per doc
+  mutable std::vector<float> termScores;
+  mutable std::vector<float> totalScores;
+  mutable std::vector<int> termsMatched;
+  // each doc's place in alphabetical order, for breaking ties
+  mutable std::vector<int> nameRanks;
+  mutable bool ranksDirty = true;
+
+  int findOrAddToken(const String& token);
+  int findNode(const String& prefix) const;
+  // calls fn(tokenId) for every token at or below the node
+  template <typename Fn>
+  void forEachTokenBelow(int node, Fn&& fn) const;
+  // calls fn(tokenId, distance) for every token within
+  // maxDist edits of the term, or starting with something
+  // within maxDist edits of it if asPrefix
+  template <typename Fn>
+  void forEachFuzzyMatch(const String& term,
+                         int maxDist,
+                         bool asPrefix,
+                         Fn&& fn) const;
+  static float fieldWeight(uint8_t fields);
+};
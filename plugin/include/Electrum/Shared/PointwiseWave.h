@@ -51,6 +51,9 @@ wave_pt_vec valueTreeToWavePoints(const ValueTree& warpTree);
 //---------------------------------------
 wave_pt_vec parseWaveLinear(float* wave);
 void parseWaveLinear(float* wave, wave_pt_vec& dest);
+// writes TABLE_SIZE samples of the curve through these sorted
+// points, the first at index 0 and the last at TABLE_SIZE - 1
+void renderWavePoints(const wave_pt_vec& points, float* dest);
 
 // manages and edits the state of a single pointwise wave
 class Warp {
@@ -74,6 +77,9 @@ public:
 
   // encode the editor contents back to a wave string----------------
   String encodeFrameString() const;
+  // or write TABLE_SIZE samples straight into a buffer, walks
+  // the points once and evaluates each segment as a run
+  void renderFrame(float* dest) const;
   // parse the pointwise wave into a valueTree-----------------------
 
   // create, delete, move single points------------------------------
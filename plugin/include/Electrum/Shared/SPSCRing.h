@@ -0,0 +1,64 @@
+#pragma once
+#include <array>
+#include <atomic>
+#include <cstring>
+#include <type_traits>
+
+/* Lock-free single producer/single consumer ring of fixed
+ * size items. Pushing and popping are one memcpy each and
+ * never allocate, so this is safe to push to from the audio
+ * thread. Only one thread may push and only one may pop.
+ * */
+template <typename T, size_t capacity>
+class SPSCRing {
+  static_assert((capacity & (capacity - 1)) == 0,
+                "capacity needs to be a power of two");
+  static_assert(std::is_trivially_copyable_v<T>,
+                "items get copied with memcpy");
+
+private:
+  static constexpr size_t mask = capacity - 1;
+  std::array<T, capacity> slots;
+  // these only ever count up, the slot is the count masked
+  // to the capacity. Separate cache lines so the two threads
+  // don't fight over them
+  alignas(64) std::atomic<size_t> writeCount{0};
+  alignas(64) std::atomic<size_t> readCount{0};
+
+public:
+  SPSCRing() = default;
+  // producer only, returns false and drops the item if the
+  // consumer has fallen behind
+  bool push(const T& item) {
+    const size_t w = writeCount.load(std::memory_order_relaxed);
+    if (w - readCount.load(std::memory_order_acquire) == capacity)
+      return false;
+    std::memcpy(&slots[w & mask], &item, sizeof(T));
+    writeCount.store(w + 1, std::memory_order_release);
+    return true;
+  }
+  // producer only, whether the next push will go through.
+  // Only the producer fills slots so this can't go stale
+  bool canPush() const {
+    return writeCount.load(std::memory_order_relaxed) -
+               readCount.load(std::memory_order_acquire) <
+           capacity;
+  }
+  // consumer only, returns false if there's nothing new
+  bool pop(T& item) {
+    const size_t r = readCount.load(std::memory_order_relaxed);
+    if (r == writeCount.load(std::memory_order_acquire))
+      return false;
+    std::memcpy(&item, &slots[r & mask], sizeof(T));
+    readCount.store(r + 1, std::memory_order_release);
+    return true;
+  }
+  // consumer only, skips ahead to the newest item
+  bool popLatest(T& item) {
+    bool found = false;
+    while (pop(item)) {
+      found = true;
+    }
+    return found;
+  }
+};
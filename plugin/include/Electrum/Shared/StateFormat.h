@@ -0,0 +1,29 @@
+#pragma once
+#include "Electrum/Common.h"
+
+// "ELST" at the start of every binary state, XML can't start
+// with this so it's enough to tell the two apart
+#define STATE_MAGIC 0x54534c45
+// bump this when the layout after the header changes
+#define STATE_VERSION 1
+// bits in the header's flags
+#define STATE_FLAG_GZIP 1
+// hosts save state constantly, and on a tree this size the
+// fastest level gets nearly all of the size savings
+#define STATE_GZIP_LEVEL 1
+
+/* The plugin state as handed to the host. The header is the
+ * magic number, the version and the flags as little-endian
+ * int32s, followed by the ValueTree in JUCE's binary format,
+ * GZIP'd if the flag is set. Older versions of the plugin
+ * saved the tree as an XML string, read() still handles
+ * those.
+ * */
+namespace StateFormat {
+void write(const ValueTree& state,
+           juce::MemoryBlock& dest,
+           bool compress = true);
+// returns an invalid tree if the data isn't either format
+ValueTree read(const void* data, size_t size);
+bool isBinary(const void* data, size_t size);
+}  // namespace StateFormat
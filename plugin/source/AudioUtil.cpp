@@ -12,19 +12,35 @@ size_t fastFloor64(float fValue) {
 }
 
 #define FAST_SINE_POINTS 2048
-static std::array<float, FAST_SINE_POINTS> generateSine() {
-  std::array<float, FAST_SINE_POINTS> arr;
-  const float dPhase = twoPi_f / (float)FAST_SINE_POINTS;
-  float phase = 0.0f;
+// std::sin isn't constexpr, but over [-pi, pi] a dozen
+// terms of the Taylor series is well past float precision
+static constexpr double constexprSine(double x) {
+  const double x2 = x * x;
+  double term = x;
+  double sum = x;
+  for (int n = 1; n < 12; ++n) {
+    term *= -x2 / (double)((2 * n) * ((2 * n) + 1));
+    sum += term;
+  }
+  return sum;
+}
+
+static constexpr std::array<float, FAST_SINE_POINTS> generateSine() {
+  constexpr double pi = juce::MathConstants<double>::pi;
+  std::array<float, FAST_SINE_POINTS> arr = {};
   for (size_t i = 0; i < FAST_SINE_POINTS; ++i) {
-    arr[i] = std::sinf(phase);
-    phase += dPhase;
+    double phase = (2.0 * pi * (double)i) / (double)FAST_SINE_POINTS;
+    if (phase >= pi)
+      phase -= 2.0 * pi;
+    arr[i] = (float)constexprSine(phase);
   }
   return arr;
 }
 //---------------------------------------------------
 
-static std::array<float, FAST_SINE_POINTS> sinePoints = generateSine();
+// built at compile time
+static constexpr std::array<float, FAST_SINE_POINTS> sinePoints =
+    generateSine();
 float fastSine(float phaseNorm) {
   return sinePoints[fastFloor64(phaseNorm * 2048.0f)];
 }
@@ -36,26 +52,20 @@ float fastSine(float phaseNorm) {
 #define FNOTE_MIN 20.0f
 #define FNOTE_MAX 109.0f
 
-static std::array<double, TUNING_CURVE_POINTS> _generateHzCurve() {
+static std::array<float, TUNING_CURVE_POINTS> _phaseDeltCurve = {};
+
+// the curve gets worked out here rather than kept around in
+// hz from a static initializer, this only runs when the
+// sample rate changes
+void updateTuningTables(double sampleRate) {
   constexpr double fNoteDelt =
       (double)(FNOTE_MAX - FNOTE_MIN) / (double)TUNING_CURVE_POINTS;
-  std::array<double, TUNING_CURVE_POINTS> arr;
   double fNote = (double)FNOTE_MIN;
   for (size_t i = 0; i < TUNING_CURVE_POINTS; ++i) {
-    arr[i] = 440.0 * std::pow(SEMITONE_RATIO, fNote - 69.0);
+    const double hz = 440.0 * std::pow(SEMITONE_RATIO, fNote - 69.0);
+    _phaseDeltCurve[i] = (float)(hz / sampleRate);
     fNote += fNoteDelt;
   }
-  return arr;
-}
-
-static std::array<double, TUNING_CURVE_POINTS> _hzCurveDouble =
-    _generateHzCurve();
-static std::array<float, TUNING_CURVE_POINTS> _phaseDeltCurve = {};
-
-void updateTuningTables(double sampleRate) {
-  for (size_t i = 0; i < TUNING_CURVE_POINTS; ++i) {
-    _phaseDeltCurve[i] = (float)(_hzCurveDouble[i] / sampleRate);
-  }
 }
 static size_t _idxForNote(int note, float semis, float cents) {
   constexpr float fNoteRange = (float)(FNOTE_MAX - FNOTE_MIN);
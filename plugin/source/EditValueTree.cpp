@@ -37,6 +37,17 @@ String getFullWavetableString(const ValueTree& tree) {
   return fullStr;
 }
 
+String getEditedFrameString(const ValueTree& frame) {
+  jassert(frame.hasType(WAVE_FRAME));
+  auto warp = frame.getChildWithName(FFT_WARP);
+  if (warp.isValid()) {
+    String waveStr = warp[warpedWaveStringData];
+    jassert(waveStr != "null");
+    return waveStr;
+  }
+  return frame[frameStringData];
+}
+
 void saveEditsInWaveTree(ValueTree& wt) {
   jassert(wt.hasType(WAVETABLE));
   for (auto it = wt.begin(); it != wt.end(); ++it) {
@@ -152,7 +152,8 @@ static ValueTree s_makeLfoInfoTree() {
 
 ElectrumState::ElectrumState(juce::AudioProcessor& proc,
                              juce::UndoManager* undo)
-    : apvts(proc, undo, ID::ELECTRUM_STATE, ID::getParameterLayout()) {
+    : apvts(proc, undo, ID::ELECTRUM_STATE, ID::getParameterLayout()),
+      patchLoader(this) {
   // 1. add the default modulation tree
   ValueTree mod(ID::ELECTRUM_MOD_TREE);
   state.appendChild(mod, undo);
@@ -169,6 +170,12 @@ ElectrumState::ElectrumState(juce::AudioProcessor& proc,
   ensureLFOTree();
 }
 
+ElectrumState::~ElectrumState() {
+  // it still has the reference the loader gave it
+  if (heldPatch != nullptr)
+    heldPatch->decReferenceCount();
+}
+
 void ElectrumState::ensureLFOTree() {
   auto existing = state.getChildWithName(ID::LFO_INFO);
   if (!existing.isValid()) {
@@ -178,6 +185,49 @@ void ElectrumState::ensureLFOTree() {
   }
 }
 
+void ElectrumState::addWaveRefs(ValueTree& stateCopy) const {
+  ValueTree refs(ID::WAVE_REFS);
+  for (int i = 0; i < NUM_OSCILLATORS; ++i) {
+    const String waveID = ID::oscillatorWaveIndex.toString() + String(i);
+    const int waveIdx = (int)getRawParameterValue(waveID)->load();
+    String name;
+    if (!userLib.tryGetWaveName(waveIdx, name))
+      continue;
+    ValueTree ref(ID::WAVE_REF);
+    ref.setProperty(ID::waveRefOsc, i, nullptr);
+    ref.setProperty(ID::waveRefHash, userLib.getWaveHash(waveIdx), nullptr);
+    ref.setProperty(ID::waveName, name, nullptr);
+    refs.appendChild(ref, nullptr);
+  }
+  stateCopy.appendChild(refs, nullptr);
+}
+
+void ElectrumState::resolveWaveRefs(ValueTree& newState) const {
+  auto refs = newState.getChildWithName(ID::WAVE_REFS);
+  if (!refs.isValid())
+    return;
+  const auto names = userLib.getAvailableWaveNames();
+  for (auto ref : refs) {
+    // 1. find the wave by its contents, or by name if it's
+    // been edited since
+    int waveIdx = userLib.indexOfWaveHash((juce::int64)ref[ID::waveRefHash]);
+    if (waveIdx < 0)
+      waveIdx = names.indexOf(ref[ID::waveName].toString());
+    if (waveIdx < 0)
+      continue;
+    // 2. point the parameter at it
+    const String waveID =
+        ID::oscillatorWaveIndex.toString() + ref[ID::waveRefOsc].toString();
+    for (auto param : newState) {
+      if (param.hasType("PARAM") && param["id"].toString() == waveID) {
+        param.setProperty("value", waveIdx, nullptr);
+        break;
+      }
+    }
+  }
+  newState.removeChild(refs, nullptr);
+}
+
 float ElectrumState::getModulatedDestValue(int destID,
                                            float baseValue,
                                            float modNorm) const {
@@ -272,7 +322,66 @@ float ElectrumState::noteSubdivToHz(float quarterNotes) const {
 
 //============================================================
 
+bool ElectrumState::commitPrepared(const PreparedPatch& p) {
+  // 1. it all goes in or none of it does, so check first
+  for (size_t i = 0; i < NUM_OSCILLATORS; ++i) {
+    auto* set = p.waves[i].get();
+    if (set != nullptr && !audioData.wOsc[i].canCommitWaveSet(set))
+      return false;
+  }
+  for (size_t i = 0; i < NUM_LFOS; ++i) {
+    if (p.hasLfo[i] && !audioData.lfos[i].canCommitTable())
+      return false;
+  }
+  // 2. the waves and LFO shapes
+  for (size_t i = 0; i < NUM_OSCILLATORS; ++i) {
+    auto* set = p.waves[i].get();
+    if (set == nullptr)
+      continue;
+    audioData.wOsc[i].commitWaveSet(set);
+    lastWaveIndices[i] = p.waveIndices[i];
+  }
+  for (size_t i = 0; i < NUM_LFOS; ++i) {
+    if (p.hasLfo[i])
+      audioData.lfos[i].commitTable(p.lfoTables[i], p.lfoHashes[i]);
+  }
+  // 3. the parameters and modulations, so the rest of this
+  // block reads them along with the new waves
+  auto& allParams = processor.getParameters();
+  for (auto& param : p.params) {
+    auto* ap = allParams[param.index];
+    if (ap->getValue() != param.value)
+      ap->setValueNotifyingHost(param.value);
+  }
+  if (p.hasModulations)
+    modulations = p.modulations;
+  return true;
+}
+
+void ElectrumState::flushAsyncUpdates() {
+  for (auto& osc : audioData.wOsc) {
+    osc.handleUpdateNowIfNeeded();
+  }
+  for (auto& env : audioData.env) {
+    env.handleUpdateNowIfNeeded();
+  }
+  for (auto& lfo : audioData.lfos) {
+    lfo.handleUpdateNowIfNeeded();
+  }
+}
+
 void ElectrumState::updateCommonAudioData() {
+  // prepared patches-----------------------------
+  // whatever the loader has finished goes in all at once
+  // before anything reads the parameters. One that couldn't
+  // go in yet stays held and gets another go next block,
+  // its reference keeps it alive until then
+  if (heldPatch == nullptr)
+    heldPatch = patchLoader.nextPrepared();
+  while (heldPatch != nullptr && commitPrepared(*heldPatch)) {
+    patchLoader.finishedWith(heldPatch);
+    heldPatch = patchLoader.nextPrepared();
+  }
   // oscillators----------------------------------
   for (int i = 0; i < NUM_OSCILLATORS; ++i) {
     String iStr(i);
@@ -294,15 +403,11 @@ void ElectrumState::updateCommonAudioData() {
     const float _fine = getRawParameterValue(fineID)->load();
     const float _pan = getRawParameterValue(panID)->load();
     const int _waveIdx = (int)getRawParameterValue(waveID)->load();
-    // 3. replace the wavetable data if needed
-    if (_waveIdx != lastWaveIndices[(size_t)i] &&
-        _waveIdx < userLib.numWavetables()) {
-      lastWaveIndices[(size_t)i] = _waveIdx;
-      auto* data = userLib.getWavetableData((int)_waveIdx);
-      jassert(data != nullptr);
-      auto waveStr = UserFiles::loadTableStringForWave(data->name);
-      audioData.wOsc[i].loadWaveData(waveStr);
-    }
+    // 3. if the wave has changed the loader builds it and it
+    // gets swapped in at the start of a later block
+    if (_waveIdx != lastWaveIndices[(size_t)i])
+      patchLoader.requestWave(i, _waveIdx);
+    audioData.wOsc[i].commitPendingSet();
     // 4. assign to the DSP objects
     audioData.wOsc[i].setPos(_pos);
     audioData.wOsc[i].setActive(_active > 0.5f);
@@ -370,9 +475,40 @@ void ElectrumState::updateCommonAudioData() {
       audioData.filters[i].oscActive[o] = _route > 0.5f;
     }
   }
+  // compile the routing plan for this block, this only does
+  // any work when something about the routing has changed
+  routing_params_t routing;
+  const float _routing =
+      getRawParameterValue(ID::filterRouting.toString())->load();
+  routing.mode = (FilterRoutingE)(int)_routing;
+  for (int o = 0; o < NUM_OSCILLATORS; ++o) {
+    routing.oscActive[o] = audioData.wOsc[o].isActive();
+  }
+  for (int i = 0; i < NUM_FILTERS; ++i) {
+    routing.filterActive[i] = audioData.filters[i].active;
+    for (int o = 0; o < NUM_OSCILLATORS; ++o) {
+      routing.oscToFilter[o][i] = audioData.filters[i].oscActive[o];
+    }
+  }
+  audioData.routing.update(routing);
+  // oversampling--------------------------------------------
+  // the raw value of a choice parameter is just its index
+  const float _osRealtime =
+      getRawParameterValue(ID::oversamplingRealtime.toString())->load();
+  const float _osOffline =
+      getRawParameterValue(ID::oversamplingOffline.toString())->load();
+  audioData.oversampleRealtime = (OversamplingE)(int)_osRealtime;
+  audioData.oversampleOffline = (OversamplingE)(int)_osOffline;
+  const float _satADAA =
+      getRawParameterValue(ID::filterSaturationADAA.toString())->load();
+  audioData.saturationADAA = _satADAA > 0.5f;
   // LFOs----------------------------------------------------
+  // the tree's shapes are older than the committed ones
+  // until the message thread catches it up
+  const bool stateIsBehind = patchLoader.stateIsBehind();
   for (int i = 0; i < NUM_LFOS; ++i) {
-    audioData.lfos[i].updateData(*this, i);
+    if (!stateIsBehind)
+      audioData.lfos[i].updateData(*this, i);
     String iStr(i);
     const String freqID = ID::lfoFrequencyHz.toString() + iStr;
     const String trigModeId = ID::lfoTriggerMode.toString() + iStr;
@@ -391,11 +527,14 @@ void ElectrumState::updateCommonAudioData() {
     const String freqID = ID::perlinFrequency.toString() + iStr;
     const String octaveID = ID::perlinOctaves.toString() + iStr;
     const String lacID = ID::perlinLacunarity.toString() + iStr;
+    const String perVoiceID = ID::perlinPerVoice.toString() + iStr;
 
     const float _freq = getRawParameterValue(freqID)->load();
     const float _octaves = getRawParameterValue(octaveID)->load();
     const float _lac = getRawParameterValue(lacID)->load();
+    const float _perVoice = getRawParameterValue(perVoiceID)->load();
     audioData.perlinGens[i].setParams((size_t)_octaves, _freq, _lac);
+    audioData.perlinGens[i].setPerVoice(_perVoice > 0.5f);
   }
 }
 
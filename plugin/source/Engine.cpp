@@ -90,6 +90,13 @@ void SynthEngine::handleMidiMessage(juce::MidiMessage& message) {
   {
     float modVal = (float)message.getControllerValue() / 127.0f;
     state->setModWheel(modVal);
+  } else if (message.isController() && message.getControllerNumber() == 0) {
+    programBank = message.getControllerValue();
+  } else if (message.isProgramChange()) {
+    // the loader does the actual work, this just tells it
+    // which one
+    const int program = (programBank * 128) + message.getProgramChangeNumber();
+    state->patchLoader.requestProgram(program);
   } else if (message.isPitchWheel()) {
     // state->setPitchBend(Math::toPitchBendValue(message.getPitchWheelValue()));
   } else {
@@ -97,19 +104,89 @@ void SynthEngine::handleMidiMessage(juce::MidiMessage& message) {
   }
 }
 
-void SynthEngine::renderNextSample(float& left,
-                                   float& right,
-                                   bool updateDests) {
-  for (auto& lfo : state->audioData.lfos) {
-    lfo.tick();
+void SynthEngine::tickGlobalModulators(int numSamples) {
+  auto& data = state->audioData;
+  for (auto& lfo : data.lfos) {
+    lfo.tickChunk(numSamples);
   }
-  for (auto& perlin : state->audioData.perlinGens) {
-    perlin.tick();
+  for (int i = 0; i < NUM_PERLIN_GENS; ++i) {
+    for (int s = 0; s < numSamples; ++s) {
+      data.perlinGens[i].tick();
+      data.perlinValues[i][s] = data.perlinGens[i].getValue();
+    }
+  }
+}
+
+void SynthEngine::updateRenderQuality() {
+  // hosts tell us when they're bouncing, and we can afford
+  // to use a higher rate then
+  auto& data = state->audioData;
+  const bool offline = state->processor.isNonRealtime();
+  const OversamplingE rate =
+      offline ? data.oversampleOffline : data.oversampleRealtime;
+  if (rate != filterRate) {
+    filterRate = rate;
+    for (auto* v : voices) {
+      v->setFilterOversampling(rate);
+    }
+  }
+  // same goes for blending between wave frames and updating
+  // the modulation every sample
+  for (auto& osc : data.wOsc) {
+    osc.setSmooth(offline);
   }
+  modsEverySample = offline;
+  // anti-aliased saturation is up to the patch either way
+  ladderBatch.setSaturationMode(data.saturationADAA ? TanhPolyADAA
+                                                    : SATURATION_DEFAULT_MODE);
+}
+
+void SynthEngine::renderVoices(float* left,
+                               float* right,
+                               int numSamples,
+                               bool updateDests) {
+  // the shared modulators run through the whole block first
+  // and keep their value at each sample, so the voices read
+  // the right one whenever they update their mod dests
+  tickGlobalModulators(numSamples);
+  // 1. oscillators and voice modulation
+  int numActive = 0;
   for (auto* v : voices) {
-    v->renderNextSample(left, right, updateDests);
+    if (v->beginBlock()) {
+      v->renderOscillators(numSamples, updateDests, modsEverySample);
+      activeVoices[numActive] = v;
+      ++numActive;
+    }
+  }
+  // 2. filters, in the order the routing plan gives them
+  const auto& plan = state->audioData.routing.getPlan();
+  for (int p = 0; p < plan.numSteps; ++p) {
+    const filter_step_t& step = plan.steps[p];
+    if (step.process) {
+      auto& params = state->audioData.filters[step.filter];
+      ladderBatch.clear();
+      svfBatch.clear();
+      for (int i = 0; i < numActive; ++i) {
+        activeVoices[i]->addFilterLanes(step.filter, ladderBatch, svfBatch);
+      }
+      // every voice is on the same type so only one of these
+      // has any lanes, the other does nothing
+      ladderBatch.process(params.filterType, numSamples);
+      svfBatch.process(params.filterType, numSamples);
+    }
+    if (step.dest != ROUTING_OUTPUT) {
+      for (int i = 0; i < numActive; ++i) {
+        activeVoices[i]->routeFilterOutput(step, numSamples);
+      }
+    }
+  }
+  // 3. gate and output
+  for (int i = 0; i < numActive; ++i) {
+    activeVoices[i]->renderOutput(left, right, numSamples);
+  }
+  for (int i = 0; i < numSamples; ++i) {
+    state->audioData.polyRMS.tick(left[i], right[i]);
   }
-  state->audioData.polyRMS.tick(left, right);
 }
 
 //===================================================
@@ -137,25 +214,18 @@ void SynthEngine::processBlock(juce::AudioBuffer<float>& audioBuf,
                                juce::MidiBuffer& midiBuf) {
   // 1. grab any needed updates from the GUI
   updateParamsForBlock();
+  updateRenderQuality();
   // 1b. check if the GUI wants graphing data updates
   if (state->graph.wantsUpdate()) {
-    state->graph.setPolyLevel(state->audioData.polyRMS.currentLevel());
+    telemetry_snapshot_t snap;
+    snap.polyLevel = state->audioData.polyRMS.currentLevel();
     for (int i = 0; i < NUM_PERLIN_GENS; ++i) {
-      state->graph.updatePerlinLevel(i,
-                                     state->audioData.perlinGens[i].getValue());
+      snap.perlinLevels[i] = state->audioData.perlinGens[i].getValue();
     }
     auto* v = voices[state->graph.getNewestVoiceIndex()];
-    jassert(v != nullptr);
-    v->updateGraphData(&state->graph);
-    // update the wavetable strings if necessary
-    if (state->graph.needsWavetableData()) {
-      for (int i = 0; i < NUM_OSCILLATORS; ++i) {
-        auto str = state->audioData.wOsc[i].toString();
-        state->graph.updateWavetableString(str, i);
-      }
-      DLog::log("Wavetable strings updated");
-    }
-    state->graph.updateFinished();
+    if (v != nullptr)
+      v->writeTelemetry(snap);
+    state->graph.publish(snap);
   }
 
   // 2. load midi events into the queue (and load any events from the GUI
@@ -164,31 +234,34 @@ void SynthEngine::processBlock(juce::AudioBuffer<float>& audioBuf,
                                             audioBuf.getNumSamples(), true);
   loadMidiEvents(midiBuf, audioBuf.getNumSamples());
   // 3. determine if we're stereo or mono
-  if (audioBuf.getNumChannels() >= 2) {
-    // 4. render the audio
-    float* lSample = audioBuf.getWritePointer(0);
-    float* rSample = audioBuf.getWritePointer(1);
-    for (int i = 0; i < audioBuf.getNumSamples(); ++i) {
-      // process any midi events for this sample
-      while (!midiQueue.empty() && midiQueue.front().timestamp <= i) {
-        handleMidiMessage(midiQueue.front().message);
-        midiQueue.pop();
-      }
-      renderNextSample(lSample[i], rSample[i], destUpdateIdx == 0);
-      destUpdateIdx = (destUpdateIdx + 1) % DEST_UPDATE_INTERVAL;
+  const bool isStereo = audioBuf.getNumChannels() >= 2;
+  float* lSample = audioBuf.getWritePointer(0);
+  float* rSample = isStereo ? audioBuf.getWritePointer(1) : nullptr;
+  // 4. render the audio, in chunks that end wherever the next
+  // MIDI event or modulation update happens
+  const int numSamples = audioBuf.getNumSamples();
+  int pos = 0;
+  while (pos < numSamples) {
+    // process any midi events for this sample
+    while (!midiQueue.empty() && midiQueue.front().timestamp <= pos) {
+      handleMidiMessage(midiQueue.front().message);
+      midiQueue.pop();
     }
-  } else {
-    float* lSample = audioBuf.getWritePointer(0);
-    float dummy;
-    for (int i = 0; i < audioBuf.getNumSamples(); ++i) {
-      // process any midi events for this sample
-      while (!midiQueue.empty() && midiQueue.front().timestamp <= i) {
-        handleMidiMessage(midiQueue.front().message);
-        midiQueue.pop();
-      }
-      renderNextSample(lSample[i], dummy, destUpdateIdx == 0);
-      destUpdateIdx = (destUpdateIdx + 1) % DEST_UPDATE_INTERVAL;
+    int length = std::min(numSamples - pos, MAX_VOICE_BLOCK);
+    // offline the voices update every sample anyway, so there's
+    // no need to break the block up for them
+    if (!modsEverySample)
+      length = std::min(length, (int)(DEST_UPDATE_INTERVAL - destUpdateIdx));
+    if (!midiQueue.empty()) {
+      length = std::min(length, midiQueue.front().timestamp - pos);
+    }
+    float* right = isStereo ? rSample + pos : monoScratch;
+    if (!isStereo) {
+      std::fill(monoScratch, monoScratch + length, 0.0f);
     }
+    renderVoices(lSample + pos, right, length, destUpdateIdx == 0);
+    destUpdateIdx = (destUpdateIdx + (uint32_t)length) % DEST_UPDATE_INTERVAL;
+    pos += length;
   }
   // validateKeyboardState();
 }
@@ -126,12 +126,13 @@ void FrameSpectrum::frameWasFocused(int frame) {
 void FrameSpectrum::waveTreeUpdateRequested() {
   if (waveTreeNeedsUpdate) {
     auto frame = waveTree.getChild(currentFrame);
-    auto oldWarpTree = waveTree.getChildWithName(WaveEdit::FFT_WARP);
+    auto oldWarpTree = frame.getChildWithName(WaveEdit::FFT_WARP);
     if (oldWarpTree.isValid()) {
       frame.removeChild(oldWarpTree, nullptr);
     }
     auto newChild = warp->getWarpTree(true);
     frame.appendChild(newChild, nullptr);
+    frame.setProperty(WaveEdit::frameNeedsResynth, true, nullptr);
     waveTreeNeedsUpdate = false;
   }
 }
@@ -1,6 +1,8 @@
 #include "Electrum/Shared/FileSystem.h"
 #include "Electrum/Audio/Wavetable.h"
 #include "Electrum/Identifiers.h"
+#include "Electrum/Shared/LibraryIndex.h"
+#include "Electrum/Shared/PatchSearchIndex.h"
 #include "juce_data_structures/juce_data_structures.h"
 
 ValueTree patch_meta_t::toValueTree(const patch_meta_t& patch) {
@@ -44,11 +46,21 @@ wave_meta_t wave_meta_t::fromValueTree(ValueTree& vt) {
 //===================================================
 namespace UserFiles {
 
+static File dataFolderOverride;
+
+void setDataFolder(const File& folder) {
+  dataFolderOverride = folder;
+}
+
+File getDataFolder() {
+  if (dataFolderOverride != File())
+    return dataFolderOverride;
+  return File::getSpecialLocation(juce::File::userApplicationDataDirectory)
+      .getChildFile("ElectrumData");
+}
+
 File getPatchesFolder() {
-  File folder =
-      File::getSpecialLocation(juce::File::userApplicationDataDirectory)
-          .getChildFile("ElectrumData")
-          .getChildFile("Patches");
+  File folder = getDataFolder().getChildFile("Patches");
   if (!folder.exists() || !folder.isDirectory())
     folder.createDirectory();
   return folder;
@@ -90,11 +102,13 @@ static void createDefaultWaveFile(const File& waveFolder) {
   file3.replaceWithText(xml3);
 }
 
+File getLibraryIndexFile() {
+  return getPatchesFolder().getParentDirectory().getChildFile(
+      "LibraryIndex.bin");
+}
+
 File getWavetablesFolder() {
-  File folder =
-      File::getSpecialLocation(juce::File::userApplicationDataDirectory)
-          .getChildFile("ElectrumData")
-          .getChildFile("Wavetables");
+  File folder = getDataFolder().getChildFile("Wavetables");
   if (!folder.exists() || !folder.isDirectory()) {
     folder.createDirectory();
     createDefaultWaveFile(folder);
@@ -162,54 +176,324 @@ String loadTableStringForWave(const String& name) {
   return waveData;
 }
 
-std::vector<patch_meta_t> getAvailiblePatches() {
-  std::vector<patch_meta_t> vec;
-  auto patches = getPatchesFolder();
-  auto files = patches.findChildFiles(File::findFiles, true);
-  for (auto& f : files) {
-    auto str = f.loadFileAsString();
-    auto parent = juce::ValueTree::fromXml(str);
-    auto child = parent.getChildWithName(ID::PATCH_INFO);
-    if (child.isValid()) {
-      vec.push_back(patch_meta_t::fromValueTree(child));
-    }
-  }
-  return vec;
+ValueTree loadPatchTree(const File& file) {
+  if (!file.existsAsFile())
+    return ValueTree();
+  // this is the first time the whole file gets parsed, so
+  // validate it here rather than parsing it twice
+  auto tree = ValueTree::fromXml(file.loadFileAsString());
+  if (!tree.isValid() || !tree.getChildWithName(ID::PATCH_INFO).isValid())
+    return ValueTree();
+  return tree;
 }
 
-std::vector<wave_meta_t> getAvailableWaves() {
-  std::vector<wave_meta_t> vec;
-  auto folder = getWavetablesFolder();
-  auto waves = folder.findChildFiles(File::findFiles, true);
-  for (auto& wave : waves) {
-    auto str = wave.loadFileAsString();
-    auto parent = ValueTree::fromXml(str);
-    if (parent.isValid()) {
-      vec.push_back(wave_meta_t::fromValueTree(parent));
+}  // namespace UserFiles
+//===================================================
+
+// lists one folder and queues a FileParseJob for each file
+// that's new or has changed since it was indexed
+class ElectrumUserLib::FolderScanJob : public juce::ThreadPoolJob {
+public:
+  FolderScanJob(ElectrumUserLib* l, bool patches)
+      : juce::ThreadPoolJob("FolderScanJob"), lib(l), isPatch(patches) {}
+  JobStatus runJob() override;
+
+private:
+  ElectrumUserLib* const lib;
+  const bool isPatch;
+};
+
+class ElectrumUserLib::FileParseJob : public juce::ThreadPoolJob {
+public:
+  FileParseJob(ElectrumUserLib* l, const File& f, bool patch)
+      : juce::ThreadPoolJob("FileParseJob"), lib(l), file(f), isPatch(patch) {}
+  JobStatus runJob() override {
+    if (shouldExit())
+      return jobHasFinished;
+    lib->postScanResult({isPatch, lib->index->readEntry(file, isPatch), {}});
+    return jobHasFinished;
+  }
+
+private:
+  ElectrumUserLib* const lib;
+  const File file;
+  const bool isPatch;
+};
+
+juce::ThreadPoolJob::JobStatus ElectrumUserLib::FolderScanJob::runJob() {
+  const File folder = isPatch ? UserFiles::getPatchesFolder()
+                              : UserFiles::getWavetablesFolder();
+  const String ext = isPatch ? UserFiles::patchFileExt : UserFiles::waveFileExt;
+  auto files = folder.findChildFiles(File::findFiles, false, "*" + ext);
+  scan_result_t listing = {isPatch, ValueTree(), {}};
+  if (isPatch) {
+    // patches can be parsed in any order, so they get
+    // spread over the pool
+    for (auto& f : files) {
+      if (shouldExit())
+        return jobHasFinished;
+      listing.found.insert(f.getFullPathName());
+      if (!lib->index->isUpToDate(f)) {
+        ++lib->scanJobsLeft;
+        lib->scanPool.addJob(new FileParseJob(lib, f, true), true);
+      }
+    }
+  } else {
+    // new waves get appended to the list in the order they
+    // arrive, so read them here in name order to keep
+    // their indices the same every time
+    files.sort();
+    for (auto& f : files) {
+      if (shouldExit())
+        return jobHasFinished;
+      listing.found.insert(f.getFullPathName());
+      if (!lib->index->isUpToDate(f)) {
+        ++lib->scanJobsLeft;
+        lib->postScanResult({false, lib->index->readEntry(f, false), {}});
+      }
     }
   }
-  // alphabetize the list of names
-  std::sort(vec.begin(), vec.end(), [](wave_meta_t a, wave_meta_t b) {
-    return b.name.compare(a.name) > 0;
-  });
-  return vec;
+  lib->postScanResult(std::move(listing));
+  return jobHasFinished;
 }
 
-}  // namespace UserFiles
 //===================================================
 
 ElectrumUserLib::ElectrumUserLib()
-    : patches(UserFiles::getAvailiblePatches()),
-      waves(UserFiles::getAvailableWaves()) {}
+    : index(new LibraryIndex()),
+      searchIndex(new PatchSearchIndex()),
+      scanJobsLeft(2),
+      scanPool(juce::ThreadPoolOptions{}
+                   .withThreadName("LibraryScan")
+                   .withNumberOfThreads(
+                       std::max(1, juce::SystemStats::getNumCpus() / 2))) {
+  // 1. everything in the index is available right away
+  for (auto& entry : index->getCachedEntries(ID::PATCH_INFO)) {
+    auto meta = entry.getChild(0);
+    addPatch(patch_meta_t::fromValueTree(meta),
+             entry[ID::indexFilePath].toString());
+  }
+  auto waveEntries = index->getCachedEntries(ID::WAVE_INFO);
+  // waves go back in the order they were first found since
+  // patches refer to them by index. Any without an order
+  // (from an older index) go after those, by name
+  auto waveOrder = [](const ValueTree& entry) {
+    return entry.hasProperty(ID::indexWaveOrder)
+               ? (int)entry[ID::indexWaveOrder]
+               : std::numeric_limits<int>::max();
+  };
+  std::sort(waveEntries.begin(), waveEntries.end(),
+            [&](const ValueTree& a, const ValueTree& b) {
+              const int orderA = waveOrder(a);
+              const int orderB = waveOrder(b);
+              if (orderA != orderB)
+                return orderA < orderB;
+              return a.getChild(0)[ID::waveName].toString().compare(
+                         b.getChild(0)[ID::waveName].toString()) < 0;
+            });
+  for (auto& entry : waveEntries) {
+    auto meta = entry.getChild(0);
+    addWave(wave_meta_t::fromValueTree(meta),
+            entry[ID::indexFilePath].toString());
+  }
+  searchIndex->updateNameRanks();
+  // 2. check the folders for anything that's changed since
+  scanPool.addJob(new FolderScanJob(this, true), true);
+  scanPool.addJob(new FolderScanJob(this, false), true);
+  // 3. and keep an eye on them from here on
+  watcher->addListener(this);
+}
+
+ElectrumUserLib::~ElectrumUserLib() {
+  // this waits for any callback in progress, so no new jobs
+  // get added after it
+  watcher->removeListener(this);
+  // the jobs all check shouldExit() between files, so this
+  // only waits on whatever file is being read
+  scanPool.removeAllJobs(true, 5000);
+  cancelPendingUpdate();
+  // whatever did get merged is still worth keeping
+  index->save();
+}
+
+void ElectrumUserLib::postScanResult(scan_result_t&& result) {
+  {
+    const juce::ScopedLock sl(resultLock);
+    scanResults.push_back(std::move(result));
+  }
+  triggerAsyncUpdate();
+}
+
+void ElectrumUserLib::handleAsyncUpdate() {
+  std::vector<scan_result_t> results;
+  {
+    const juce::ScopedLock sl(resultLock);
+    results.swap(scanResults);
+  }
+  for (auto& r : results) {
+    if (r.entry.isValid()) {
+      mergeEntry(r);
+    } else if (r.removed.isNotEmpty()) {
+      mergeRemoval(r);
+    } else {
+      mergeFolderListing(r);
+    }
+    --scanJobsLeft;
+  }
+  if (!results.empty() && scanJobsLeft.load() == 0) {
+    index->save();
+    searchIndex->updateNameRanks();
+    for (auto* l : listeners) {
+      l->libraryScanFinished();
+    }
+  }
+}
+
+void ElectrumUserLib::libraryFilesChanged(bool isPatch,
+                                          const juce::StringArray& paths) {
+  for (auto& path : paths) {
+    const File file(path);
+    if (!file.existsAsFile()) {
+      ++scanJobsLeft;
+      postScanResult({isPatch, ValueTree(), {}, path});
+    } else if (!index->isUpToDate(file)) {
+      // this skips the files we just saved ourselves
+      ++scanJobsLeft;
+      scanPool.addJob(new FileParseJob(this, file, isPatch), true);
+    }
+  }
+}
+
+void ElectrumUserLib::libraryFolderChanged(bool isPatch) {
+  ++scanJobsLeft;
+  scanPool.addJob(new FolderScanJob(this, isPatch), true);
+}
+
+void ElectrumUserLib::mergeEntry(const scan_result_t& result) {
+  index->setEntry(result.entry);
+  const String path = result.entry[ID::indexFilePath];
+  auto meta = result.entry.getChild(0);
+  if (result.isPatch) {
+    auto existing = patchFiles.find(path);
+    // 1. the file's no longer a valid patch
+    if (!meta.isValid()) {
+      if (existing != patchFiles.end())
+        removePatch(existing->second);
+      return;
+    }
+    auto patch = patch_meta_t::fromValueTree(meta);
+    // 2. it changed, so just update it in place. The
+    // listeners pick this up when they repaint
+    if (existing != patchFiles.end()) {
+      updatePatch(existing->second, patch);
+      return;
+    }
+    // 3. a new patch
+    auto* p = addPatch(patch, path);
+    for (auto* l : listeners) {
+      l->patchWasFound(p);
+    }
+    return;
+  }
+  if (!meta.isValid())
+    return;
+  auto wave = wave_meta_t::fromValueTree(meta);
+  auto existing = waveFiles.find(path);
+  if (existing != waveFiles.end()) {
+    const juce::ScopedLock sl(waveLock);
+    *existing->second = wave;
+    return;
+  }
+  addWave(wave, path);
+  for (auto* l : listeners) {
+    l->waveWasFound(waveFiles[path]);
+  }
+}
+
+void ElectrumUserLib::mergeFolderListing(const scan_result_t& result) {
+  const File folder = result.isPatch ? UserFiles::getPatchesFolder()
+                                     : UserFiles::getWavetablesFolder();
+  auto removed = index->removeMissing(folder, result.found);
+  if (!result.isPatch)
+    return;
+  for (auto& path : removed) {
+    auto existing = patchFiles.find(path);
+    if (existing != patchFiles.end()) {
+      removePatch(existing->second);
+    }
+  }
+}
+
+void ElectrumUserLib::mergeRemoval(const scan_result_t& result) {
+  index->removeEntry(result.removed);
+  if (!result.isPatch)
+    return;
+  auto existing = patchFiles.find(result.removed);
+  if (existing != patchFiles.end()) {
+    removePatch(existing->second);
+  }
+}
+
+void ElectrumUserLib::addWave(const wave_meta_t& wave, const String& path) {
+  const juce::ScopedLock sl(waveLock);
+  auto* w = waves.add(new wave_meta_t(wave));
+  waveFiles[path] = w;
+  // new waves only ever go on the end, and the index keeps
+  // track of where so they come back in the same place
+  index->setWaveOrder(path, waves.size() - 1);
+}
+
+patch_meta_t* ElectrumUserLib::addPatch(const patch_meta_t& patch,
+                                        const String& path) {
+  auto* p = patches.add(new patch_meta_t(patch));
+  patchFiles[path] = p;
+  patchNames.insert({p->name.toLowerCase(), p});
+  searchIndex->add(p);
+  return p;
+}
+
+void ElectrumUserLib::updatePatch(patch_meta_t* existing,
+                                  const patch_meta_t& patch) {
+  eraseName(existing);
+  *existing = patch;
+  patchNames.insert({existing->name.toLowerCase(), existing});
+  searchIndex->update(existing);
+}
+
+void ElectrumUserLib::eraseName(patch_meta_t* patch) {
+  auto range = patchNames.equal_range(patch->name.toLowerCase());
+  for (auto it = range.first; it != range.second; ++it) {
+    if (it->second == patch) {
+      patchNames.erase(it);
+      return;
+    }
+  }
+}
+
+void ElectrumUserLib::removePatch(patch_meta_t* patch) {
+  for (auto* l : listeners) {
+    l->patchWasRemoved(patch);
+  }
+  for (auto it = patchFiles.begin(); it != patchFiles.end(); ++it) {
+    if (it->second == patch) {
+      patchFiles.erase(it);
+      break;
+    }
+  }
+  eraseName(patch);
+  searchIndex->remove(patch);
+  patches.removeObject(patch);
+}
+
+std::vector<patch_meta_t*> ElectrumUserLib::searchPatches(
+    const String& query) const {
+  return searchIndex->search(query);
+}
 
 bool ElectrumUserLib::isPatchNameLegal(const String& name) const {
   if (name.length() < 4 || name.length() > 20)
     return false;
-  for (auto& p : patches) {
-    if (name.compareIgnoreCase(p.name) == 0)
-      return false;
-  }
-  return true;
+  return !patchNames.contains(name.toLowerCase());
 }
 
 bool ElectrumUserLib::isWaveNameLegal(const String& name) const {
@@ -245,36 +529,61 @@ bool ElectrumUserLib::validateWaveData(wave_meta_t* patch) const {
   return true;
 }
 patch_meta_t* ElectrumUserLib::getPatchAtIndex(int index) {
-  if (index >= numPatches())
-    return nullptr;
-  return &patches[(size_t)index];
+  return patches[index];
 }
 
 patch_meta_t* ElectrumUserLib::getPatch(const String& name) {
-  for (auto& p : patches) {
-    if (p.name == name)
-      return &p;
+  auto range = patchNames.equal_range(name.toLowerCase());
+  for (auto it = range.first; it != range.second; ++it) {
+    if (it->second->name == name)
+      return it->second;
   }
   return nullptr;
 }
 
 wave_meta_t* ElectrumUserLib::getWavetableData(const String& name) {
-  for (auto& w : waves) {
-    if (w.name == name)
-      return &w;
+  for (auto* w : waves) {
+    if (w->name == name)
+      return w;
   }
   jassert(false);
   return nullptr;
 }
 
 wave_meta_t* ElectrumUserLib::getWavetableData(int index) {
-  return &waves[(size_t)index];
+  return waves[index];
+}
+
+juce::int64 ElectrumUserLib::getWaveHash(int waveIdx) const {
+  const juce::ScopedLock sl(waveLock);
+  auto* wave = waves[waveIdx];
+  for (auto& [path, w] : waveFiles) {
+    if (w == wave)
+      return index->getContentHash(path);
+  }
+  return 0;
+}
+
+int ElectrumUserLib::indexOfWaveHash(juce::int64 hash) const {
+  const juce::ScopedLock sl(waveLock);
+  for (auto& [path, w] : waveFiles) {
+    if (index->getContentHash(path) == hash)
+      return waves.indexOf(w);
+  }
+  return -1;
+}
+
+bool ElectrumUserLib::tryGetWaveName(int index, String& dest) const {
+  const juce::ScopedTryLock stl(waveLock);
+  if (!stl.isLocked() || !juce::isPositiveAndBelow(index, waves.size()))
+    return false;
+  dest = waves[index]->name;
+  return true;
 }
 
 bool ElectrumUserLib::attemptPatchSave(apvts* tree,
                                        const patch_meta_t& patchData) {
   auto state = tree->copyState();
-  patches.push_back(patchData);
   // 1. remove the existing PATCH_INFO child and
   // replace it with a new one
   auto oldPI = state.getChildWithName(ID::PATCH_INFO);
@@ -285,9 +594,15 @@ bool ElectrumUserLib::attemptPatchSave(apvts* tree,
   state.appendChild(newPI, nullptr);
   bool success = UserFiles::attemptPatchSave(state);
   if (success) {
+    // the save sets the path on newPI
+    auto saved = patch_meta_t::fromValueTree(newPI);
+    const File file = UserFiles::getPatchesFolder().getChildFile(saved.path);
+    // index it now so the watcher doesn't parse it again
+    index->setEntry(index->readEntry(file, true));
+    auto* p = addPatch(saved, file.getFullPathName());
     // notify the listeners
     for (auto* l : listeners) {
-      l->patchWasSaved(&patches[patches.size() - 1]);
+      l->patchWasSaved(p);
     }
     return true;
   }
@@ -296,17 +611,17 @@ bool ElectrumUserLib::attemptPatchSave(apvts* tree,
 
 juce::StringArray ElectrumUserLib::getAvailableWaveNames() const {
   juce::StringArray names;
-  for (size_t i = 0; i < waves.size(); ++i) {
-    names.add(waves[i].name);
+  for (auto* w : waves) {
+    names.add(w->name);
   }
   // DLog::log("Found " + String(waves.size()) + " wavetable files");
   return names;
 }
 
 int ElectrumUserLib::indexOfWaveName(const String& name) const {
-  for (size_t i = 0; i < waves.size(); ++i) {
-    if (waves[i].name == name) {
-      return (int)i;
+  for (int i = 0; i < waves.size(); ++i) {
+    if (waves[i]->name == name) {
+      return i;
     }
   }
   jassert(false);
@@ -320,8 +635,19 @@ bool ElectrumUserLib::attemptWaveSave(const wave_meta_t& waveData,
 
   bool success = UserFiles::attemptWaveSave(waveData, waveString);
   if (success) {
-    waves.push_back(waveData);
-    auto* ptr = &waves[waves.size() - 1];
+    const File file = UserFiles::getWavetablesFolder().getChildFile(
+        waveData.name + UserFiles::waveFileExt);
+    const String path = file.getFullPathName();
+    index->setEntry(index->readEntry(file, false));
+    // an overwritten wave keeps its place in the list
+    auto existing = waveFiles.find(path);
+    if (existing != waveFiles.end()) {
+      const juce::ScopedLock sl(waveLock);
+      *existing->second = waveData;
+    } else {
+      addWave(waveData, path);
+    }
+    auto* ptr = waveFiles[path];
     for (auto* l : listeners) {
       l->waveWasSaved(ptr);
     }
@@ -331,10 +657,7 @@ bool ElectrumUserLib::attemptWaveSave(const wave_meta_t& waveData,
 
 ValueTree ElectrumUserLib::getMasterTreeForPatch(patch_meta_t* patch) {
   File patchFile = UserFiles::getPatchesFolder().getChildFile(patch->path);
-  if (!patchFile.existsAsFile() || !UserFiles::isValidPatch(patchFile)) {
-    jassert(false);
-    return ValueTree();
-  }
-  auto str = patchFile.loadFileAsString();
-  return ValueTree::fromXml(str);
+  auto tree = UserFiles::loadPatchTree(patchFile);
+  jassert(tree.isValid());
+  return tree;
 }
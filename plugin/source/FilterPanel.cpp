@@ -87,6 +87,12 @@ FilterComp::FilterComp(ElectrumState* s, int filterIdx)
   typeBox.setSelectedItemIndex(0);
   const String typeID = ID::filterType.toString() + String(filterIdx);
   cAttach.reset(new apvts::ComboBoxAttachment(*s, typeID, typeBox));
+  // 5. set up the routing box
+  addAndMakeVisible(routingBox);
+  routingBox.addItemList(getFilterRoutingNames(), 1);
+  routingBox.setSelectedItemIndex(0);
+  const String routingID = ID::filterRouting.toString();
+  rAttach.reset(new apvts::ComboBoxAttachment(*s, routingID, routingBox));
 }
 
 void FilterComp::resized() {
@@ -114,6 +120,9 @@ void FilterComp::resized() {
   sCutoff.setBounds(cutoffBounds.toNearestInt());
   sResonance.setBounds(resBounds.toNearestInt());
   sGain.setBounds(gainBounds.toNearestInt());
+  auto routingBounds = fBounds.withSizeKeepingCentre(
+      std::min(fBounds.getWidth(), comboWidth), upperBar);
+  routingBox.setBounds(routingBounds.reduced(3.0f).toNearestInt());
 }
 
 void FilterComp::paint(juce::Graphics& g) {
@@ -0,0 +1,61 @@
+#include "Electrum/Audio/Synth/FilterRouting.h"
+
+routing_plan_t FilterRouter::compile(const routing_params_t& p) {
+  routing_plan_t out;
+  const bool serial = p.mode == FilterSerial;
+  bool used[ROUTING_NUM_BUFFERS] = {};
+  // 1. oscillators go into every filter they're routed to,
+  // or in serial mode just the first one since the rest get
+  // its output anyway. Anything unrouted is dry
+  for (int o = 0; o < NUM_OSCILLATORS; ++o) {
+    if (!p.oscActive[o])
+      continue;
+    int& numDests = out.numOscDests[o];
+    for (int f = 0; f < NUM_FILTERS; ++f) {
+      if (p.oscToFilter[o][f]) {
+        out.oscDests[o][numDests] = f;
+        ++numDests;
+        used[f] = true;
+        if (serial)
+          break;
+      }
+    }
+    if (numDests == 0) {
+      out.oscDests[o][0] = ROUTING_DRY_BUFFER;
+      numDests = 1;
+      used[ROUTING_DRY_BUFFER] = true;
+    }
+  }
+  // 2. each filter with any input gets a step, in serial
+  // mode they feed into the next filter
+  for (int f = 0; f < NUM_FILTERS; ++f) {
+    if (!used[f])
+      continue;
+    const bool last = f == NUM_FILTERS - 1;
+    const int dest = (serial && !last) ? f + 1 : ROUTING_OUTPUT;
+    out.steps[out.numSteps] = {f, p.filterActive[f], dest};
+    ++out.numSteps;
+    if (dest == ROUTING_OUTPUT) {
+      out.outputs[out.numOutputs] = f;
+      ++out.numOutputs;
+    } else {
+      used[dest] = true;
+    }
+  }
+  // 3. dry goes straight out
+  if (used[ROUTING_DRY_BUFFER]) {
+    out.outputs[out.numOutputs] = ROUTING_DRY_BUFFER;
+    ++out.numOutputs;
+  }
+  return out;
+}
+
+FilterRouter::FilterRouter() : plan(compile(params)) {}
+
+bool FilterRouter::update(const routing_params_t& p) {
+  if (p == params)
+    return false;
+  params = p;
+  plan = compile(params);
+  return true;
+}
@@ -0,0 +1,96 @@
+#include "Electrum/GUI/WaveEditor/FrameResynth.h"
+
+struct FrameResynth::resynth_batch_t {
+  std::vector<BandLimitedWave::Ptr> waves;
+  std::atomic<int> remaining{0};
+};
+
+// band-limits one frame into its slot in the batch
+class FrameResynth::FrameJob : public juce::ThreadPoolJob {
+private:
+  FrameResynth* const owner;
+  resynth_batch_t* const batch;
+  const size_t index;
+  const String waveStr;
+
+public:
+  FrameJob(FrameResynth* o, resynth_batch_t* b, size_t idx, const String& str)
+      : juce::ThreadPoolJob("FrameJob"),
+        owner(o),
+        batch(b),
+        index(idx),
+        waveStr(str) {}
+  JobStatus runJob() override {
+    float temp[TABLE_SIZE];
+    stringDecodeWave(waveStr, temp);
+    batch->waves[index] = new BandLimitedWave(temp);
+    // the last job to finish hands the batch back to the
+    // message thread
+    if (batch->remaining.fetch_sub(1) == 1) {
+      owner->triggerAsyncUpdate();
+    }
+    return jobHasFinished;
+  }
+};
+
+//===================================================
+
+FrameResynth::FrameResynth()
+    : pool(juce::ThreadPoolOptions{}.withThreadName("FrameResynth")) {}
+
+FrameResynth::~FrameResynth() {
+  pool.removeAllJobs(true, 5000);
+  cancelPendingUpdate();
+}
+
+void FrameResynth::resynthesize(const ValueTree& waveTree) {
+  jassert(waveTree.hasType(WaveEdit::WAVETABLE));
+  if (running != nullptr) {
+    queuedTree = waveTree;
+    return;
+  }
+  // 1. everything needs building the first time through or
+  // if the number of frames has changed
+  const int numFrames = waveTree.getNumChildren();
+  const bool rebuildAll = frames.size() != numFrames;
+  auto batch = std::make_unique<resynth_batch_t>();
+  batch->waves.resize((size_t)numFrames);
+  std::vector<std::pair<size_t, String>> edited = {};
+  for (int i = 0; i < numFrames; ++i) {
+    auto frame = waveTree.getChild(i);
+    if (rebuildAll || (bool)frame[WaveEdit::frameNeedsResynth]) {
+      edited.push_back({(size_t)i, WaveEdit::getEditedFrameString(frame)});
+      frame.removeProperty(WaveEdit::frameNeedsResynth, nullptr);
+    } else {
+      batch->waves[(size_t)i] = frames[i];
+    }
+  }
+  if (edited.empty())
+    return;
+  // 2. start a job for each edited frame
+  batch->remaining = (int)edited.size();
+  running = std::move(batch);
+  for (auto& e : edited) {
+    pool.addJob(new FrameJob(this, running.get(), e.first, e.second), true);
+  }
+}
+
+void FrameResynth::handleAsyncUpdate() {
+  if (running == nullptr || running->remaining.load() > 0)
+    return;
+  // 1. hang on to the new frames for next time
+  frames.clear();
+  for (auto& w : running->waves) {
+    frames.add(w);
+  }
+  running.reset();
+  if (onSetReady != nullptr) {
+    onSetReady(new WaveSet(frames));
+  }
+  // 2. start anything that was requested in the meantime
+  if (queuedTree.isValid()) {
+    auto tree = queuedTree;
+    queuedTree = ValueTree();
+    resynthesize(tree);
+  }
+}
@@ -8,8 +8,6 @@
 #include "juce_core/juce_core.h"
 #include "juce_graphics/juce_graphics.h"
 
-#define NAIVE_NEIGHBORS
-
 warp_point_t warp_point_t::fromValueTree(const ValueTree& vt) {
   warp_point_t pt;
   jassert(vt.hasType(WaveEdit::FFT_GAIN_POINT));
@@ -65,6 +63,7 @@ FrameWarp::FrameWarp(ValueTree& vt) : loadedWaveTree(vt.createCopy()) {
   // copy these into the warped array to start
   for (size_t i = 0; i < AUDIBLE_BINS; ++i) {
     workingBins[i] = savedBins[i];
+    savedNorm[i] = magnitudeToNorm(savedBins[i].magnitude);
   }
 
   // find and/or create the Warp child
@@ -82,6 +81,8 @@ FrameWarp::FrameWarp(ValueTree& vt) : loadedWaveTree(vt.createCopy()) {
   // and as always make sure points are sorted by frequency
   sortPoints();
   binsReady = true;
+  // apply any points we loaded
+  handleAsyncUpdate();
 }
 
 void FrameWarp::sortPoints() {
@@ -102,6 +103,7 @@ void FrameWarp::createWarpPoint(float normMag, float normFreq) {
   }
   points.push_back(pt);
   sortPoints();
+  fullWarpNeeded = true;
   triggerAsyncUpdate();
 }
 
@@ -122,14 +124,43 @@ bool FrameWarp::isNearEditLine(float normMagnitude, float freq) const {
 void FrameWarp::handleAsyncUpdate() {
   juce::ScopedLock sl(criticalSection);
   // this is where the 'workingBins' values get updated
-  if (!points.empty()) {
-    for (size_t i = 0; i < AUDIBLE_BINS; ++i) {
-      workingBins[i].magnitude = warpBinMagnitude(i);
+  if (fullWarpNeeded) {
+    // 1. start over from the saved bins and apply every kernel
+    workingBins = savedBins;
+    appliedKernels.resize(points.size());
+    for (size_t i = 0; i < points.size(); ++i) {
+      appliedKernels[i] = kernelRangeFor(i);
+      applyKernel(i, appliedKernels[i]);
     }
-  } else {
-    for (size_t i = 0; i < AUDIBLE_BINS; ++i) {
-      workingBins[i] = savedBins[i];
+    fullWarpNeeded = false;
+    anyPointMoved = false;
+  } else if (anyPointMoved) {
+    // 2. moving a point moves the neutral points on either
+    // side, so its neighbors' kernels change too
+    const size_t first = firstMovedPoint > 0 ? firstMovedPoint - 1 : 0;
+    const size_t last = std::min(lastMovedPoint + 1, points.size() - 1);
+    for (size_t i = first; i <= last; ++i) {
+      auto& old = appliedKernels[i];
+      for (size_t b = old.first; b <= old.last; ++b) {
+        workingBins[b].magnitude = savedBins[b].magnitude;
+      }
     }
+    for (size_t i = first; i <= last; ++i) {
+      appliedKernels[i] = kernelRangeFor(i);
+      applyKernel(i, appliedKernels[i]);
+    }
+    anyPointMoved = false;
+  }
+}
+
+void FrameWarp::markPointMoved(size_t ptIndex) {
+  if (!anyPointMoved) {
+    firstMovedPoint = ptIndex;
+    lastMovedPoint = ptIndex;
+    anyPointMoved = true;
+  } else {
+    firstMovedPoint = std::min(firstMovedPoint, ptIndex);
+    lastMovedPoint = std::max(lastMovedPoint, ptIndex);
   }
 }
 
@@ -139,6 +170,7 @@ void FrameWarp::placePoint(warp_point_t* point,
   if (isMovementLegal(point, normMagnitude, freq)) {
     point->frequency = snapToBinCenter(freq);
     point->magnitude = magnitudeRange.convertFrom0to1(normMagnitude);
+    markPointMoved(indexOf(point));
     triggerAsyncUpdate();
   }
 }
@@ -178,26 +210,6 @@ fpoint_t FrameWarp::warpPointToBounds(const frect_t& bounds,
   return {xPos, yPos};
 }
 
-warp_point_t* FrameWarp::closestEditPoint(size_t bin) {
-  if (points.empty()) {
-    return nullptr;
-  }
-  const float binFreq = binCenters[bin];
-  // TODO: maybe binary search here
-  // but I'll brute force for now to see if it
-  //  works
-  warp_point_t* closest = &points[0];
-  float minDifference = 5000.0f;
-  for (auto& point : points) {
-    float diff = std::fabs(point.frequency - binFreq);
-    if (diff < minDifference) {
-      minDifference = diff;
-      closest = &point;
-    }
-  }
-  return closest;
-}
-
 size_t FrameWarp::minDistanceToNeutral(size_t ptIndex) {
   // 1. find the neutral point below
   size_t lNeutralBin;
@@ -223,35 +235,55 @@ size_t FrameWarp::minDistanceToNeutral(size_t ptIndex) {
   return std::min<size_t>(lDist, rDist);
 }
 
-float FrameWarp::getInfluenceAmt(warp_point_t* point, size_t binIdx) {
-  jassert(point != nullptr);
-  const float binFreq = binCenters[binIdx];
-  // 1. If we's at the same bin as the edit point,
-  // the 'influence' is 100%
-  if (fequal(binFreq, point->frequency)) {
-    return 1.0f;
+FrameWarp::kernel_range_t FrameWarp::kernelRangeFor(size_t ptIndex) {
+  const float freq = points[ptIndex].frequency;
+  const size_t ptBin = freqToBinIdx(freq);
+  const size_t halfWidth = minDistanceToNeutral(ptIndex);
+  // the bin whose center the point is snapped to always gets
+  // the full magnitude, this can be one above 'ptBin'
+  const size_t lastBin = AUDIBLE_BINS - 1;
+  const size_t centerBin =
+      std::min((size_t)(freq * (float)AUDIBLE_BINS + 0.5f), lastBin);
+  kernel_range_t range = {ptBin, ptBin};
+  if (halfWidth > 0) {
+    range.first = ptBin - std::min(ptBin, halfWidth - 1);
+    range.last = std::min(ptBin + halfWidth - 1, lastBin);
   }
+  range.first = std::min(range.first, centerBin);
+  range.last = std::max(range.last, centerBin);
+  return range;
+}
 
-  const size_t ptIndex = indexOf(point);
-  const float fPointBin = (float)freqToBinIdx(point->frequency);
+void FrameWarp::applyKernel(size_t ptIndex, const kernel_range_t& range) {
+  using FVO = juce::FloatVectorOperations;
+  const float freq = points[ptIndex].frequency;
+  const size_t ptBin = freqToBinIdx(freq);
   const float fNeutralDist = (float)minDistanceToNeutral(ptIndex);
-  const float fBinDist = std::fabs((float)binIdx - fPointBin);
-  if (fBinDist >= fNeutralDist) {
-    return 0.0f;
+  const int length = (int)(range.last - range.first) + 1;
+  // 1. fill in the kernel's weights
+  for (size_t b = range.first; b <= range.last; ++b) {
+    float amt = 0.0f;
+    const float fBinDist = std::fabs((float)b - (float)ptBin);
+    if (fequal(binCenters[b], freq)) {
+      amt = 1.0f;
+    } else if (fBinDist < fNeutralDist) {
+      amt = 1.0f - (fBinDist / fNeutralDist);
+    }
+    kernelScratch[b - range.first] = amt;
   }
-  return 1.0f - (fBinDist / fNeutralDist);
-}
-
-float FrameWarp::warpBinMagnitude(size_t binIdx) {
-  auto* editPoint = closestEditPoint(binIdx);
-  if (editPoint == nullptr) {
-    return savedBins[binIdx].magnitude;
-  } else {
-    const float warpAmt = getInfluenceAmt(editPoint, binIdx);
-    const float savedNMag = magnitudeToNorm(savedBins[binIdx].magnitude);
-    const float ptNMag = magnitudeToNorm(editPoint->magnitude);
-    const float newNMag = flerp(savedNMag, ptNMag, warpAmt);
-    return magnitudeRange.convertFrom0to1(newNMag);
+  // 2. lerp the normalized magnitudes toward the point's
+  // magnitude by the kernel's weights
+  const float ptNMag = magnitudeToNorm(points[ptIndex].magnitude);
+  const float* saved = savedNorm.data() + range.first;
+  float* norm = normScratch.data();
+  FVO::fill(norm, ptNMag, length);
+  FVO::subtract(norm, saved, length);
+  FVO::multiply(norm, kernelScratch.data(), length);
+  FVO::add(norm, saved, length);
+  // 3. and back into actual magnitudes
+  for (int i = 0; i < length; ++i) {
+    const size_t b = range.first + (size_t)i;
+    workingBins[b].magnitude = magnitudeRange.convertFrom0to1(norm[i]);
   }
 }
 
@@ -287,6 +319,7 @@ static void s_removePoint(std::vector<warp_point_t>& vec, warp_point_t* point) {
 void FrameWarp::deletePoint(warp_point_t* point) {
   s_removePoint(points, point);
   sortPoints();
+  fullWarpNeeded = true;
   triggerAsyncUpdate();
 }
 //===================================================
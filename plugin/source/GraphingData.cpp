@@ -2,32 +2,36 @@
 #include "Electrum/Audio/AudioUtil.h"
 
 GraphingData::GraphingData()
-    : voicesState(0),
-      newestVoice(0),
-      updateRequested(false),
-      needsWaveStrings(true),
-      waveStringsHaveChanged(false),
-      editorOpen(false) {
-  for (int i = 0; i < NUM_ENVELOPES; i++) {
-    newestEnvLevels[(size_t)i] = 0.0f;
-  }
+    : updateRequested(false), editorOpen(false) {
   for (int i = 0; i < NUM_OSCILLATORS; i++) {
-    newestOscPositions[(size_t)i] = OSC_POS_DEFAULT;
+    latest.oscPositions[(size_t)i] = OSC_POS_DEFAULT;
   }
   startTimerHz(30);
 }
 
-void GraphingData::updateWavetableString(const String& wave, int oscID) {
-  waveStrings[(size_t)oscID] = wave;
-  waveStringsHaveChanged = true;
-  DLog::log("Updated wavetable string for osc " + String(oscID));
+void GraphingData::timerCallback() {
+  // 1. pick up whatever the audio thread has sent since the
+  // last frame and pass it on
+  if (ring.popLatest(latest)) {
+    _notifyListeners();
+  }
+  // 2. ask for the next one
+  updateRequested = true;
+}
+
+void GraphingData::publish(telemetry_snapshot_t& snap) {
+  snap.voicesState = voicesState;
+  snap.newestVoice = newestVoice;
+  // if the GUI has fallen behind this one just gets dropped
+  ring.push(snap);
+  updateRequested = false;
 }
 
 //-----------------------
 void GraphingData::voiceStarted(int idx) {
   newestVoice = idx;
   voiceIndeces.push(idx);
-  const int mask = 1 << idx;
+  const uint32_t mask = 1u << idx;
   voicesState |= mask;
 }
 
@@ -38,7 +42,7 @@ void GraphingData::voiceEnded(int idx) {
       // make sure that the new 'newestVoice'
       // is actually still active
       newestVoice = voiceIndeces.top();
-      while (!_isVoiceActive(newestVoice.load()) && !voiceIndeces.empty()) {
+      while (!_isVoiceActive(newestVoice) && !voiceIndeces.empty()) {
         voiceIndeces.pop();
         newestVoice = voiceIndeces.top();
       }
@@ -46,12 +50,12 @@ void GraphingData::voiceEnded(int idx) {
         newestVoice = -1;
     }
   }
-  const int mask = ~(1 << idx);
+  const uint32_t mask = ~(1u << idx);
   voicesState &= mask;
 }
 
 bool GraphingData::_isVoiceActive(int idx) {
-  const int mask = 1 << idx;
+  const uint32_t mask = 1u << idx;
   return (voicesState & mask) > 0;
 }
 
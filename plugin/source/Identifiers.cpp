@@ -4,8 +4,15 @@
 #include "juce_audio_processors/juce_audio_processors.h"
 
 juce::StringArray getFilterTypeNames() {
-  return {"Ladder Low Pass (basic)", "Ladder Low Pass", "Ladder High Pass",
-          "Ladder Bandpass"};
+  return {"Ladder Low Pass (basic)",
+          "Ladder Low Pass",
+          "Ladder High Pass",
+          "Ladder Bandpass",
+          "SVF Low Pass",
+          "SVF Bandpass",
+          "SVF High Pass",
+          "SVF Notch",
+          "SVF Peak"};
 }
 // helper
 static void addFloatParam(apvts::ParameterLayout* layout,
@@ -172,6 +179,23 @@ apvts::ParameterLayout ID::getParameterLayout() {
                                                             i < 1));
     }
   }
+  layout.add(std::make_unique<juce::AudioParameterChoice>(
+      juce::ParameterID{filterRouting.toString(), 1}, "Filter routing",
+      getFilterRoutingNames(), FilterParallel));
+  // oversampling--------------------------------------
+  // off while playing live so the default CPU cost stays
+  // the same, and as clean as possible for bounces
+  layout.add(std::make_unique<juce::AudioParameterChoice>(
+      juce::ParameterID{oversamplingRealtime.toString(), 1},
+      "Oversampling (realtime)", getOversamplingNames(), OversampleOff));
+  layout.add(std::make_unique<juce::AudioParameterChoice>(
+      juce::ParameterID{oversamplingOffline.toString(), 1},
+      "Oversampling (offline)", getOversamplingNames(), Oversample4x));
+  // off so older patches keep the resonance they were made
+  // with
+  layout.add(std::make_unique<juce::AudioParameterBool>(
+      juce::ParameterID{filterSaturationADAA.toString(), 1},
+      "Anti-aliased filter saturation", false));
   // LFO params--------------------------------------
   frange_t lfoHzRange = rangeWithCenter(LFO_HZ_MIN, LFO_HZ_MAX, LFO_HZ_CENTER);
   for (int i = 0; i < NUM_LFOS; ++i) {
@@ -212,12 +236,16 @@ apvts::ParameterLayout ID::getParameterLayout() {
     const String octaveName = "Perlin gen. " + iStr + " octaves";
     const String lacID = perlinLacunarity.toString() + iStr;
     const String lacName = "Perlin gen. " + iStr + " lacunarity";
+    const String perVoiceID = perlinPerVoice.toString() + iStr;
+    const String perVoiceName = "Perlin gen. " + iStr + " per voice";
     addFloatParam(&layout, freqID, freqName, perlinFreqRange,
                   PERLIN_FREQ_DEFAULT);
     addFloatParam(&layout, lacID, lacName, perlinLacRange, PERLIN_LAC_DEAULT);
     layout.add(std::make_unique<juce::AudioParameterInt>(
         juce::ParameterID{octaveID, 1}, octaveName, PERLIN_OCTAVES_MIN,
         PERLIN_OCTAVES_MAX, PERLIN_OCTAVES_DEFAULT));
+    layout.add(std::make_unique<juce::AudioParameterBool>(
+        juce::ParameterID{perVoiceID, 1}, perVoiceName, false));
   }
   return layout;
 }
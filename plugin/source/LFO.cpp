@@ -109,6 +109,7 @@ void LowFrequencyLUT::updateData(apvts& tree, int idx) {
       if (_lfoHash != currentLfoHash) {
         currentLfoHash = _lfoHash;
         currentLfoString = _lfoStr;
+        decoding.store(true);
         triggerAsyncUpdate();
       }
       needsData = false;
@@ -118,6 +119,21 @@ void LowFrequencyLUT::updateData(apvts& tree, int idx) {
   }
 }
 
+bool LowFrequencyLUT::commitTable(const lfo_table_t& table, size_t hash) {
+  // the message thread writes to tIdle while it decodes
+  if (decoding.load())
+    return false;
+  if (hash != currentLfoHash) {
+    *tIdle = table;
+    auto* prevActive = tActive;
+    tActive = tIdle;
+    tIdle = prevActive;
+    // so updateData() doesn't decode the same string again
+    currentLfoHash = hash;
+  }
+  return true;
+}
+
 void LowFrequencyLUT::handleAsyncUpdate() {
   // 1. decode the string into LFO handles
   LFO::stringDecode(currentLfoString, handles);
@@ -127,27 +143,33 @@ void LowFrequencyLUT::handleAsyncUpdate() {
   auto* prevActive = tActive;
   tActive = tIdle;
   tIdle = prevActive;
+  decoding.store(false);
 }
 
-void LowFrequencyLUT::tick() {
-  if (trigMode == LFOTriggerE::Global) {
+void LowFrequencyLUT::tickChunk(int numSamples) {
+  jassert(numSamples <= MAX_VOICE_BLOCK);
+  if (trigMode != LFOTriggerE::Global)
+    return;
+  for (int s = 0; s < numSamples; ++s) {
     globalPhase += phaseDelt;
     if (globalPhase > 1.0f) {
       globalPhase -= 1.0f;
     }
+    phaseHistory[s] = globalPhase;
   }
 }
 
 float LowFrequencyLUT::getSample(float normPhase) const {
-  auto phase = (trigMode == LFOTriggerE::Global) ? globalPhase : normPhase;
-  const size_t idx = (size_t)(phase * (float)(LFO_SIZE - 1));
+  // processSample() picks the phase for the trigger mode
+  const size_t idx = (size_t)(normPhase * (float)(LFO_SIZE - 1));
   const lfo_table_t& arr = *tActive;
   return arr[idx];
 }
 
-float LowFrequencyLUT::processSample(float& currentPhase) const {
+float LowFrequencyLUT::processSample(float& currentPhase,
+                                     int sampleInBlock) const {
   if (trigMode == LFOTriggerE::Global) {
-    return getSample(globalPhase);
+    return getSample(phaseHistory[sampleInBlock]);
   } else {
     currentPhase += phaseDelt;
     if (currentPhase > 1.0f) {
@@ -161,8 +183,8 @@ float LowFrequencyLUT::processSample(float& currentPhase) const {
 
 VoiceLFO::VoiceLFO(LowFrequencyLUT* l) : lut(l) {}
 
-void VoiceLFO::tick() {
-  lastOutput = lut->processSample(phase);
+void VoiceLFO::tick(int sampleInBlock) {
+  lastOutput = lut->processSample(phase, sampleInBlock);
 }
 
 void VoiceLFO::gateStarted() {
@@ -1,28 +1,46 @@
 #include "Electrum/Audio/Filters/Ladder.h"
+#include "Electrum/Audio/Filters/Prewarp.h"
 #include "Electrum/Common.h"
 #include "juce_audio_basics/juce_audio_basics.h"
 #include "juce_core/juce_core.h"
-static const float ladderMakeupGain = juce::Decibels::decibelsToGain(16.0f);
+static const float ladderMakeupGain =
+    juce::Decibels::decibelsToGain(LADDER_MAKEUP_DB);
+
+// after a sample rate or oversampling change the half-band
+// filters' history is from the wrong rate, so they start over
+static void clearOversamplingState(float* z) {
+  std::fill(z + LADDER_CORE_STATE_SIZE, z + LADDER_STATE_SIZE, 0.0f);
+}
+
+void ladder_coeffs_t::setCutoff(float cutoffHz) {
+  Prewarp::lookup(tables, cutoffHz, g, bigG, rate);
+  g2 = g * g;
+  g3 = g2 * g;
+  g4 = g3 * g;
+  invDenom = 1.0f / (1.0f + k * g4);
+}
+
+void ladder_coeffs_t::setK(float val) {
+  k = val;
+  invDenom = 1.0f / (1.0f + k * g4);
+}
 
 void LadderLPBasic::setCutoffHz(float hz) {
   if (!fequal(hz, cutoffHz)) {
     cutoffHz = hz;
-    updateG(SampleRate::get());
+    c.setCutoff(cutoffHz);
   }
 }
 
-void LadderLPBasic::updateG(double sampleRate) {
-  g = (float)std::tan(juce::MathConstants<double>::pi * (double)cutoffHz /
-                      sampleRate);
-
-  g2 = g * g;
-  g3 = g2 * g;
-  g4 = g3 * g;
-  bigG = g / (1.0f + g);
+void LadderLPBasic::prepare() {
+  c.setCutoff(cutoffHz);
+  c.snap();
+  clearOversamplingState(zState[0]);
+  clearOversamplingState(zState[1]);
 }
 
 LadderLPBasic::LadderLPBasic() {
-  for (int i = 0; i < 4; ++i) {
+  for (int i = 0; i < LADDER_STATE_SIZE; ++i) {
     zState[0][i] = 0.0f;
     zState[1][i] = 0.0f;
   }
@@ -31,15 +49,15 @@ LadderLPBasic::LadderLPBasic() {
 float LadderLPBasic::processMono(float input, int channel) {
   // this is the math described on p 63 of the Zavalishin book
   // 1. find S
-  auto S = (g3 * zState[channel][0]) + (g2 * zState[channel][1]) +
-           (g * zState[channel][2]) + zState[channel][3];
+  auto S = (c.g3 * zState[channel][0]) + (c.g2 * zState[channel][1]) +
+           (c.g * zState[channel][2]) + zState[channel][3];
   // 2. now we can find U (input of the low pass series)
-  float x = (input - k * S) / (1.0f + k * g4);
+  float x = (input - c.k * S) * c.invDenom;
   // 3. now we process each filter
   float v;
   for (int i = 0; i < 4; ++i) {
     auto& s = zState[channel][i];
-    v = (x - s) * bigG;
+    v = (x - s) * c.bigG;
     x = v + s;
     zState[channel][i] = x + v;
   }
@@ -52,36 +70,40 @@ void LadderLPBasic::processStereo(float& left, float& right) {
 }
 //===================================================
 
-LadderLP::LadderLP() {
-  for (int i = 0; i < 4; ++i) {
-    zState[0][i] = 0.0f;
-    zState[1][i] = 0.0f;
+void LadderLP::setOversampling(OversamplingE rate) {
+  if (rate != c.rate) {
+    c.rate = rate;
+    prepare();
   }
 }
 
-void LadderLP::updateG(double sampleRate) {
-  g = (float)std::tan(juce::MathConstants<double>::pi * (double)cutoffHz /
-                      sampleRate);
+void LadderLP::prepare() {
+  c.setCutoff(cutoffHz);
+  c.snap();
+  clearOversamplingState(zState[0]);
+  clearOversamplingState(zState[1]);
+}
 
-  g2 = g * g;
-  g3 = g2 * g;
-  g4 = g3 * g;
-  bigG = g / (1.0f + g);
+LadderLP::LadderLP() {
+  for (int i = 0; i < LADDER_STATE_SIZE; ++i) {
+    zState[0][i] = 0.0f;
+    zState[1][i] = 0.0f;
+  }
 }
 
 float LadderLP::processMono(float input, int channel) {
-  auto S = (g3 * zState[channel][0]) + (g2 * zState[channel][1]) +
-           (g * zState[channel][2]) + zState[channel][3];
+  auto S = (c.g3 * zState[channel][0]) + (c.g2 * zState[channel][1]) +
+           (c.g * zState[channel][2]) + zState[channel][3];
   // 2. now we can find U (input of the low pass series)
-  float u = (input - k * S) / (1.0f + k * g4);
+  float u = (input - c.k * S) * c.invDenom;
   // 2.5 put u through a tanh function as a
   // "cheap" means of applying saturation (p. 73 in the Zavalishin book)
-  u = std::tanhf(u);
+  u = Saturation::Default::process(u, zState[channel] + 4);
   // 3. now we process each filter
   float v, s;
   for (int i = 0; i < 4; ++i) {
     s = zState[channel][i];
-    v = (u - s) * bigG;
+    v = (u - s) * c.bigG;
     u = v + s;
     zState[channel][i] = u + v;
   }
@@ -96,44 +118,48 @@ void LadderLP::processStereo(float& left, float& right) {
 void LadderLP::setCutoffHz(float hz) {
   if (!fequal(hz, cutoffHz)) {
     cutoffHz = hz;
-    updateG(SampleRate::get());
+    c.setCutoff(cutoffHz);
   }
 }
 
 //----------------------------------------------------------------------------------------------------
 
-LadderHighPass::LadderHighPass() {
-  for (int i = 0; i < 4; ++i) {
-    zState[0][i] = 0.0f;
-    zState[1][i] = 0.0f;
+void LadderHighPass::setOversampling(OversamplingE rate) {
+  if (rate != c.rate) {
+    c.rate = rate;
+    prepare();
   }
 }
 
-void LadderHighPass::updateG(double sampleRate) {
-  g = (float)std::tan(juce::MathConstants<double>::pi * (double)cutoffHz /
-                      sampleRate);
+void LadderHighPass::prepare() {
+  c.setCutoff(cutoffHz);
+  c.snap();
+  clearOversamplingState(zState[0]);
+  clearOversamplingState(zState[1]);
+}
 
-  g2 = g * g;
-  g3 = g2 * g;
-  g4 = g3 * g;
-  bigG = g / (1.0f + g);
+LadderHighPass::LadderHighPass() {
+  for (int i = 0; i < LADDER_STATE_SIZE; ++i) {
+    zState[0][i] = 0.0f;
+    zState[1][i] = 0.0f;
+  }
 }
 
 float LadderHighPass::processMono(float input, int channel) {
-  auto S = (g3 * zState[channel][0]) + (g2 * zState[channel][1]) +
-           (g * zState[channel][2]) + zState[channel][3];
+  auto S = (c.g3 * zState[channel][0]) + (c.g2 * zState[channel][1]) +
+           (c.g * zState[channel][2]) + zState[channel][3];
   // 2. now we can find U (input of the low pass series)
-  float u = (input - k * S) / (1.0f + k * g4);
+  float u = (input - c.k * S) * c.invDenom;
   // 2.5 put u through a tanh function as a
   // "cheap" means of applying saturation (p. 73 in the Zavalishin book)
-  u = std::tanhf(u);
+  u = Saturation::Default::process(u, zState[channel] + 4);
 
   // 3. now we process each filter
   float hp = u;
   float v, s;
   for (int i = 0; i < 4; ++i) {
     s = zState[channel][i];
-    v = (hp - s) * bigG;
+    v = (hp - s) * c.bigG;
     u = v + s;
     zState[channel][i] = u + v;
     hp = hp - u;
@@ -149,43 +175,47 @@ void LadderHighPass::processStereo(float& left, float& right) {
 void LadderHighPass::setCutoffHz(float hz) {
   if (!fequal(hz, cutoffHz)) {
     cutoffHz = hz;
-    updateG(SampleRate::get());
+    c.setCutoff(cutoffHz);
   }
 }
 
 //----------------------------------------------------------------------------------------------------
 
-LadderBandPass::LadderBandPass() {
-  for (int i = 0; i < 4; ++i) {
-    zState[0][i] = 0.0f;
-    zState[1][i] = 0.0f;
+void LadderBandPass::setOversampling(OversamplingE rate) {
+  if (rate != c.rate) {
+    c.rate = rate;
+    prepare();
   }
 }
 
-void LadderBandPass::updateG(double sampleRate) {
-  g = (float)std::tan(juce::MathConstants<double>::pi * (double)cutoffHz /
-                      sampleRate);
+void LadderBandPass::prepare() {
+  c.setCutoff(cutoffHz);
+  c.snap();
+  clearOversamplingState(zState[0]);
+  clearOversamplingState(zState[1]);
+}
 
-  g2 = g * g;
-  g3 = g2 * g;
-  g4 = g3 * g;
-  bigG = g / (1.0f + g);
+LadderBandPass::LadderBandPass() {
+  for (int i = 0; i < LADDER_STATE_SIZE; ++i) {
+    zState[0][i] = 0.0f;
+    zState[1][i] = 0.0f;
+  }
 }
 
 float LadderBandPass::processMono(float input, int channel) {
-  auto S = (g3 * zState[channel][0]) + (g2 * zState[channel][1]) +
-           (g * zState[channel][2]) + zState[channel][3];
+  auto S = (c.g3 * zState[channel][0]) + (c.g2 * zState[channel][1]) +
+           (c.g * zState[channel][2]) + zState[channel][3];
   // 2. now we can find U (input of the low pass series)
-  float u = (input - k * S) / (1.0f + k * g4);
+  float u = (input - c.k * S) * c.invDenom;
   // 2.5 put u through a tanh function as a
   // "cheap" means of applying saturation (p. 73 in the Zavalishin book)
-  u = std::tanhf(u);
+  u = Saturation::Default::process(u, zState[channel] + 4);
   // 3. now we process each filter
   float hp = u;
   float v, s;
   for (int i = 0; i < 2; ++i) {
     s = zState[channel][i];
-    v = (hp - s) * bigG;
+    v = (hp - s) * c.bigG;
     u = v + s;
     zState[channel][i] = u + v;
     hp = hp - u;
@@ -193,7 +223,7 @@ float LadderBandPass::processMono(float input, int channel) {
   u = hp;
   for (int i = 2; i < 4; ++i) {
     s = zState[channel][i];
-    v = (u - s) * bigG;
+    v = (u - s) * c.bigG;
     u = v + s;
     zState[channel][i] = u + v;
   }
@@ -208,6 +238,6 @@ void LadderBandPass::processStereo(float& left, float& right) {
 void LadderBandPass::setCutoffHz(float hz) {
   if (!fequal(hz, cutoffHz)) {
     cutoffHz = hz;
-    updateG(SampleRate::get());
+    c.setCutoff(cutoffHz);
   }
 }
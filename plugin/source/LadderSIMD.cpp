@@ -0,0 +1,341 @@
+#include "Electrum/Audio/Filters/LadderSIMD.h"
+#include "Electrum/Common.h"
+#include "juce_audio_basics/juce_audio_basics.h"
+
+static const float batchMakeupGain =
+    juce::Decibels::decibelsToGain(LADDER_MAKEUP_DB);
+
+namespace {
+// the coefficients for a lane or a group of lanes
+template <typename T>
+struct ladder_vals_t {
+  T g;
+  T g2;
+  T g3;
+  T bigG;
+  T k;
+  T invDenom;
+  T inputGain;
+};
+
+// the per-sample increments for a block where the
+// coefficients are ramping to new values
+template <typename T>
+struct ladder_ramp_t {
+  T g;
+  T bigG;
+  T k;
+};
+
+// advances the ramp by one sample and works out the
+// values that depend on g and k
+template <typename T>
+inline void stepRamp(ladder_vals_t<T>& c, const ladder_ramp_t<T>& r) {
+  c.g = c.g + r.g;
+  c.bigG = c.bigG + r.bigG;
+  c.k = c.k + r.k;
+  c.g2 = c.g * c.g;
+  c.g3 = c.g2 * c.g;
+  c.invDenom = SIMD::divide(SIMD::splat<T>(1.0f), (c.k * c.g3 * c.g) + 1.0f);
+}
+
+inline bool isRamping(const ladder_coeffs_t* c) {
+  return !fequal(c->g, c->lastG) || !fequal(c->bigG, c->lastBigG) ||
+         !fequal(c->k, c->lastK);
+}
+
+/* One sample of the ladder math from the Ladder classes,
+ * written so it compiles for both plain floats and
+ * SIMD registers. 'z' is the state of the four poles
+ * followed by the state for the nonlinearity
+ * */
+template <FilterTypeE type, typename Sat, typename T>
+inline T tickLadder(T input, T* z, const ladder_vals_t<T>& c) {
+  const T S = (c.g3 * z[0]) + (c.g2 * z[1]) + (c.g * z[2]) + z[3];
+  T u = ((input * c.inputGain) - (c.k * S)) * c.invDenom;
+  if constexpr (type != LadderLPLinear) {
+    u = Sat::process(u, z + 4);
+  }
+  T v;
+  if constexpr (type == LadderHP) {
+    T hp = u;
+    for (int i = 0; i < 4; ++i) {
+      v = (hp - z[i]) * c.bigG;
+      u = v + z[i];
+      z[i] = u + v;
+      hp = hp - u;
+    }
+    return hp * batchMakeupGain;
+  } else if constexpr (type == LadderBP) {
+    T hp = u;
+    for (int i = 0; i < 2; ++i) {
+      v = (hp - z[i]) * c.bigG;
+      u = v + z[i];
+      z[i] = u + v;
+      hp = hp - u;
+    }
+    u = hp;
+    for (int i = 2; i < 4; ++i) {
+      v = (u - z[i]) * c.bigG;
+      u = v + z[i];
+      z[i] = u + v;
+    }
+    return u * batchMakeupGain;
+  } else {
+    for (int i = 0; i < 4; ++i) {
+      v = (u - z[i]) * c.bigG;
+      u = v + z[i];
+      z[i] = u + v;
+    }
+    return u * batchMakeupGain;
+  }
+}
+
+template <FilterTypeE type, typename Sat, typename T>
+inline void runLadder(float* buffer,
+                      int numSamples,
+                      T* z,
+                      ladder_vals_t<T>& c,
+                      const ladder_ramp_t<T>& r,
+                      bool ramping) {
+  constexpr int stride = (int)(sizeof(T) / sizeof(float));
+  if (ramping) {
+    for (int i = 0; i < numSamples; ++i) {
+      float* frame = buffer + (i * stride);
+      stepRamp(c, r);
+      const T in = SIMD::load<T>(frame);
+      SIMD::store(tickLadder<type, Sat>(in, z, c), frame);
+    }
+  } else {
+    for (int i = 0; i < numSamples; ++i) {
+      float* frame = buffer + (i * stride);
+      const T in = SIMD::load<T>(frame);
+      SIMD::store(tickLadder<type, Sat>(in, z, c), frame);
+    }
+  }
+}
+
+// how much of the state array a lane needs at each rate
+inline int stateSizeForRate(OversamplingE rate) {
+  switch (rate) {
+    case Oversample2x:
+      return LADDER_CORE_STATE_SIZE + LADDER_OVERSAMPLE_2X_STATE_SIZE;
+    case Oversample4x:
+      return LADDER_STATE_SIZE;
+    default:
+      return LADDER_CORE_STATE_SIZE;
+  }
+}
+
+/* Runs the ladder on 'base' in place, at the host rate or
+ * between the half-band up and downsamplers. 'half' and
+ * 'over' are scratch space for the 2x and 4x signals.
+ * */
+template <FilterTypeE type, typename Sat, typename T>
+inline void runOversampled(OversamplingE rate,
+                           float* base,
+                           float* half,
+                           float* over,
+                           int numSamples,
+                           T* z,
+                           ladder_vals_t<T>& c,
+                           const ladder_ramp_t<T>& r,
+                           bool ramping) {
+  T* up2x = z + LADDER_CORE_STATE_SIZE;
+  T* down2x = up2x + HALFBAND_STATE_SIZE(HALFBAND_COEFFS_2X);
+  T* up4x = down2x + HALFBAND_STATE_SIZE(HALFBAND_COEFFS_2X);
+  T* down4x = up4x + HALFBAND_STATE_SIZE(HALFBAND_COEFFS_4X);
+  switch (rate) {
+    case Oversample2x:
+      HalfBand::upsample<HALFBAND_COEFFS_2X>(HalfBand::coeffs2x, base, over,
+                                             numSamples, up2x);
+      runLadder<type, Sat>(over, numSamples * 2, z, c, r, ramping);
+      HalfBand::downsample<HALFBAND_COEFFS_2X>(HalfBand::coeffs2x, over, base,
+                                               numSamples, down2x);
+      break;
+    case Oversample4x:
+      HalfBand::upsample<HALFBAND_COEFFS_2X>(HalfBand::coeffs2x, base, half,
+                                             numSamples, up2x);
+      HalfBand::upsample<HALFBAND_COEFFS_4X>(HalfBand::coeffs4x, half, over,
+                                             numSamples * 2, up4x);
+      runLadder<type, Sat>(over, numSamples * 4, z, c, r, ramping);
+      HalfBand::downsample<HALFBAND_COEFFS_4X>(HalfBand::coeffs4x, over, half,
+                                               numSamples * 2, down4x);
+      HalfBand::downsample<HALFBAND_COEFFS_2X>(HalfBand::coeffs2x, half, base,
+                                               numSamples, down2x);
+      break;
+    default:
+      runLadder<type, Sat>(base, numSamples, z, c, r, ramping);
+      break;
+  }
+}
+
+}  // namespace
+
+//===================================================
+
+void LadderBatch::addLane(float* samples,
+                          float* state,
+                          ladder_coeffs_t* coeffs,
+                          float inputGain) {
+  jassert(numLanes < LADDER_BATCH_MAX);
+  lanes[numLanes] = {samples, state, coeffs, inputGain};
+  ++numLanes;
+}
+
+void LadderBatch::process(FilterTypeE type, int numSamples) {
+  jassert(numSamples <= MAX_VOICE_BLOCK);
+  switch (type) {
+    case LadderLPLinear:
+      processLanes<LadderLPLinear, Saturation::Pade>(numSamples);
+      break;
+    case LadderLPSaturated:
+      processWithSaturation<LadderLPSaturated>(numSamples);
+      break;
+    case LadderHP:
+      processWithSaturation<LadderHP>(numSamples);
+      break;
+    case LadderBP:
+      processWithSaturation<LadderBP>(numSamples);
+      break;
+    default:
+      break;
+  }
+}
+
+template <FilterTypeE type>
+void LadderBatch::processWithSaturation(int numSamples) {
+  switch (saturation) {
+    case TanhStd:
+      processLanes<type, Saturation::Std>(numSamples);
+      break;
+    case TanhPade:
+      processLanes<type, Saturation::Pade>(numSamples);
+      break;
+    case TanhPoly:
+      processLanes<type, Saturation::Poly>(numSamples);
+      break;
+    case TanhPolyADAA:
+      processLanes<type, Saturation::PolyADAA>(numSamples);
+      break;
+    default:
+      break;
+  }
+}
+
+template <FilterTypeE type, typename Sat>
+void LadderBatch::processLanes(int numSamples) {
+  if (numLanes < 1)
+    return;
+  // every voice runs its filters at the same rate, and the
+  // coefficients were looked up for it
+  const OversamplingE rate = lanes[0].coeffs->rate;
+  const int innerSamples = numSamples * (1 << rate);
+  const int stateSize = stateSizeForRate(rate);
+  const float rampScale = 1.0f / (float)innerSamples;
+#if JUCE_USE_SIMD
+  using SIMD::vec_t;
+  constexpr int width = SIMD::lanes;
+  alignas(32) float temp[width];
+  for (int first = 0; first < numLanes; first += width) {
+    ladder_lane_t* group = lanes + first;
+    const int count = std::min(width, numLanes - first);
+    // 1. gather the coefficients and state for each lane, any
+    // unused lanes just get zeroes
+    auto gather = [&](auto getValue) {
+      for (int l = 0; l < width; ++l) {
+        temp[l] = (l < count) ? getValue(group[l]) : 0.0f;
+      }
+      return vec_t::fromRawArray(temp);
+    };
+    bool ramping = false;
+    for (int l = 0; l < count; ++l) {
+      jassert(group[l].coeffs->rate == rate);
+      ramping = ramping || isRamping(group[l].coeffs);
+    }
+    ladder_vals_t<vec_t> c = {};
+    ladder_ramp_t<vec_t> r = {};
+    c.inputGain =
+        gather([](const ladder_lane_t& l) { return l.inputGain; });
+    if (ramping) {
+      // start from the values the last block ended on
+      c.g = gather([](const ladder_lane_t& l) { return l.coeffs->lastG; });
+      c.bigG =
+          gather([](const ladder_lane_t& l) { return l.coeffs->lastBigG; });
+      c.k = gather([](const ladder_lane_t& l) { return l.coeffs->lastK; });
+      r.g = gather([=](const ladder_lane_t& l) {
+        return (l.coeffs->g - l.coeffs->lastG) * rampScale;
+      });
+      r.bigG = gather([=](const ladder_lane_t& l) {
+        return (l.coeffs->bigG - l.coeffs->lastBigG) * rampScale;
+      });
+      r.k = gather([=](const ladder_lane_t& l) {
+        return (l.coeffs->k - l.coeffs->lastK) * rampScale;
+      });
+    } else {
+      c.g = gather([](const ladder_lane_t& l) { return l.coeffs->g; });
+      c.g2 = gather([](const ladder_lane_t& l) { return l.coeffs->g2; });
+      c.g3 = gather([](const ladder_lane_t& l) { return l.coeffs->g3; });
+      c.bigG = gather([](const ladder_lane_t& l) { return l.coeffs->bigG; });
+      c.k = gather([](const ladder_lane_t& l) { return l.coeffs->k; });
+      c.invDenom =
+          gather([](const ladder_lane_t& l) { return l.coeffs->invDenom; });
+    }
+    vec_t z[LADDER_STATE_SIZE];
+    for (int p = 0; p < stateSize; ++p) {
+      z[p] = gather([p](const ladder_lane_t& l) { return l.state[p]; });
+    }
+    // 2. interleave the samples so each index is one vector
+    for (int i = 0; i < numSamples; ++i) {
+      float* frame = interleaved + (i * width);
+      for (int l = 0; l < width; ++l) {
+        frame[l] = (l < count) ? group[l].samples[i] : 0.0f;
+      }
+    }
+    // 3. run the filter
+    runOversampled<type, Sat>(rate, interleaved, halfRate, overRate,
+                              numSamples, z, c, r, ramping);
+    // 4. de-interleave and write the state back to the voices
+    for (int i = 0; i < numSamples; ++i) {
+      const float* frame = interleaved + (i * width);
+      for (int l = 0; l < count; ++l) {
+        group[l].samples[i] = frame[l];
+      }
+    }
+    for (int p = 0; p < stateSize; ++p) {
+      z[p].copyToRawArray(temp);
+      for (int l = 0; l < count; ++l) {
+        group[l].state[p] = temp[l];
+      }
+    }
+  }
+#else
+  juce::ignoreUnused(stateSize);
+  for (int l = 0; l < numLanes; ++l) {
+    auto& lane = lanes[l];
+    const ladder_coeffs_t* lc = lane.coeffs;
+    jassert(lc->rate == rate);
+    const bool ramping = isRamping(lc);
+    ladder_vals_t<float> c;
+    ladder_ramp_t<float> r = {0.0f, 0.0f, 0.0f};
+    if (ramping) {
+      c = {lc->lastG, 0.0f, 0.0f, lc->lastBigG, lc->lastK, 0.0f,
+           lane.inputGain};
+      r = {(lc->g - lc->lastG) * rampScale,
+           (lc->bigG - lc->lastBigG) * rampScale,
+           (lc->k - lc->lastK) * rampScale};
+    } else {
+      c = {lc->g, lc->g2, lc->g3, lc->bigG, lc->k, lc->invDenom,
+           lane.inputGain};
+    }
+    runOversampled<type, Sat>(rate, lane.samples, halfRate, overRate,
+                              numSamples, lane.state, c, r, ramping);
+  }
+#endif
+  // both channels of a voice point to the same coefficients,
+  // so we wait until every lane is done before marking the
+  // ramps as finished
+  for (int l = 0; l < numLanes; ++l) {
+    lanes[l].coeffs->snap();
+  }
+}
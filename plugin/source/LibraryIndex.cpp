@@ -0,0 +1,178 @@
+#include "Electrum/Shared/LibraryIndex.h"
+#include "juce_data_structures/juce_data_structures.h"
+
+LibraryIndex::LibraryIndex() {
+  auto file = UserFiles::getLibraryIndexFile();
+  if (!file.existsAsFile())
+    return;
+  juce::MemoryBlock data;
+  if (!file.loadFileAsData(data))
+    return;
+  auto index = ValueTree::readFromData(data.getData(), data.getSize());
+  // anything from an older version gets rebuilt from scratch
+  if (!index.hasType(ID::LIBRARY_INDEX) ||
+      (int)index[ID::indexVersion] != LIBRARY_INDEX_VERSION) {
+    changed = true;
+    return;
+  }
+  for (int i = 0; i < index.getNumChildren(); ++i) {
+    auto entry = index.getChild(i);
+    String path = entry[ID::indexFilePath];
+    entries[path] = entry;
+  }
+}
+
+std::vector<ValueTree> LibraryIndex::getCachedEntries(
+    const juce::Identifier& type) const {
+  const juce::ScopedLock sl(lock);
+  std::vector<ValueTree> found = {};
+  for (auto& [path, entry] : entries) {
+    if (entry.getChild(0).hasType(type)) {
+      found.push_back(entry.createCopy());
+    }
+  }
+  return found;
+}
+
+ValueTree LibraryIndex::parseMetadata(const String& fileText, bool isPatch) {
+  auto tree = ValueTree::fromXml(fileText);
+  if (!tree.isValid())
+    return ValueTree();
+  if (isPatch) {
+    auto info = tree.getChildWithName(ID::PATCH_INFO);
+    return info.isValid() ? info.createCopy() : ValueTree();
+  }
+  if (!tree.hasType(ID::WAVE_INFO))
+    return ValueTree();
+  // rebuild it to leave the wave string behind
+  return wave_meta_t::toValueTree(wave_meta_t::fromValueTree(tree));
+}
+
+bool LibraryIndex::isUpToDate(const File& file) const {
+  const juce::int64 modTime = file.getLastModificationTime().toMilliseconds();
+  const juce::int64 size = file.getSize();
+  const juce::ScopedLock sl(lock);
+  auto existing = entries.find(file.getFullPathName());
+  return existing != entries.end() &&
+         (juce::int64)existing->second[ID::indexFileSize] == size &&
+         (juce::int64)existing->second[ID::indexModTime] == modTime;
+}
+
+ValueTree LibraryIndex::readEntry(const File& file, bool isPatch) const {
+  const String path = file.getFullPathName();
+  // 1. grab a copy of the old entry so we don't hold the
+  // lock while reading
+  ValueTree old;
+  {
+    const juce::ScopedLock sl(lock);
+    auto existing = entries.find(path);
+    if (existing != entries.end()) {
+      old = existing->second.createCopy();
+    }
+  }
+  // 2. read the file
+  const String text = file.loadFileAsString();
+  const juce::int64 hash = text.hashCode64();
+  ValueTree entry(ID::INDEX_ENTRY);
+  entry.setProperty(ID::indexFilePath, path, nullptr);
+  entry.setProperty(ID::indexModTime,
+                    file.getLastModificationTime().toMilliseconds(), nullptr);
+  entry.setProperty(ID::indexFileSize, file.getSize(), nullptr);
+  entry.setProperty(ID::indexContentHash, hash, nullptr);
+  // 3. if it was touched but the contents are the same it
+  // doesn't need parsing again. Invalid files still get an
+  // entry so they don't get parsed every time
+  ValueTree meta;
+  if (old.isValid() && (juce::int64)old[ID::indexContentHash] == hash) {
+    meta = old.getChild(0).createCopy();
+  } else {
+    meta = parseMetadata(text, isPatch);
+  }
+  if (meta.isValid()) {
+    entry.appendChild(meta, nullptr);
+  }
+  return entry;
+}
+
+void LibraryIndex::setEntry(const ValueTree& entry) {
+  jassert(entry.hasType(ID::INDEX_ENTRY));
+  const juce::ScopedLock sl(lock);
+  String path = entry[ID::indexFilePath];
+  auto existing = entries.find(path);
+  if (existing != entries.end() &&
+      existing->second.hasProperty(ID::indexWaveOrder) &&
+      !entry.hasProperty(ID::indexWaveOrder)) {
+    ValueTree copy = entry;
+    copy.setProperty(ID::indexWaveOrder,
+                     existing->second[ID::indexWaveOrder], nullptr);
+    entries[path] = copy;
+  } else {
+    entries[path] = entry;
+  }
+  changed = true;
+}
+
+void LibraryIndex::setWaveOrder(const String& path, int order) {
+  const juce::ScopedLock sl(lock);
+  auto existing = entries.find(path);
+  if (existing == entries.end())
+    return;
+  auto& entry = existing->second;
+  if (entry.hasProperty(ID::indexWaveOrder) &&
+      (int)entry[ID::indexWaveOrder] == order)
+    return;
+  entry.setProperty(ID::indexWaveOrder, order, nullptr);
+  changed = true;
+}
+
+juce::int64 LibraryIndex::getContentHash(const String& path) const {
+  const juce::ScopedLock sl(lock);
+  auto existing = entries.find(path);
+  if (existing == entries.end())
+    return 0;
+  return (juce::int64)existing->second[ID::indexContentHash];
+}
+
+void LibraryIndex::removeEntry(const String& path) {
+  const juce::ScopedLock sl(lock);
+  if (entries.erase(path) > 0) {
+    changed = true;
+  }
+}
+
+juce::StringArray LibraryIndex::removeMissing(const File& folder,
+                                              const std::set<String>& found) {
+  juce::StringArray removed;
+  const String folderPath = folder.getFullPathName();
+  const juce::ScopedLock sl(lock);
+  for (auto it = entries.begin(); it != entries.end();) {
+    if (it->first.startsWith(folderPath) && !found.contains(it->first)) {
+      removed.add(it->first);
+      it = entries.erase(it);
+      changed = true;
+    } else {
+      ++it;
+    }
+  }
+  return removed;
+}
+
+bool LibraryIndex::save() {
+  ValueTree index(ID::LIBRARY_INDEX);
+  {
+    const juce::ScopedLock sl(lock);
+    if (!changed)
+      return true;
+    index.setProperty(ID::indexVersion, LIBRARY_INDEX_VERSION, nullptr);
+    for (auto& [path, entry] : entries) {
+      index.appendChild(entry.createCopy(), nullptr);
+    }
+    changed = false;
+  }
+  juce::MemoryOutputStream stream;
+  index.writeToStream(stream);
+  // this goes through a temp file, so another instance
+  // won't ever see half an index
+  return UserFiles::getLibraryIndexFile().replaceWithData(
+      stream.getData(), stream.getDataSize());
+}
@@ -0,0 +1,180 @@
+#include "Electrum/Shared/LibraryWatcher.h"
+#include "Electrum/Shared/FileSystem.h"
+#if JUCE_LINUX
+#include <poll.h>
+#include <sys/inotify.h>
+#include <unistd.h>
+#endif
+
+LibraryWatcher::LibraryWatcher() : juce::Thread("LibraryWatcher") {
+  startThread(juce::Thread::Priority::background);
+}
+
+LibraryWatcher::~LibraryWatcher() {
+  // both loops wake up at least every WATCHER_SETTLE_MS to
+  // check this
+  stopThread(2000);
+}
+
+void LibraryWatcher::addListener(Listener* l) {
+  const juce::ScopedLock sl(listenerLock);
+  listeners.push_back(l);
+}
+
+void LibraryWatcher::removeListener(Listener* l) {
+  const juce::ScopedLock sl(listenerLock);
+  for (auto it = listeners.begin(); it != listeners.end(); ++it) {
+    if (*it == l) {
+      listeners.erase(it);
+      return;
+    }
+  }
+}
+
+void LibraryWatcher::run() {
+  if (!watchWithInotify()) {
+    DLog::log("inotify unavailable, polling the library folders");
+    watchWithPolling();
+  }
+}
+
+//===================================================
+
+bool LibraryWatcher::watchWithInotify() {
+#if JUCE_LINUX
+  const int fd = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+  if (fd < 0)
+    return false;
+  // files written in place show up as IN_CLOSE_WRITE, saves
+  // that go through a temp file show up as IN_MOVED_TO
+  const uint32_t mask =
+      IN_CLOSE_WRITE | IN_MOVED_TO | IN_MOVED_FROM | IN_DELETE;
+  const File patchDir = UserFiles::getPatchesFolder();
+  const File waveDir = UserFiles::getWavetablesFolder();
+  const int patchWd =
+      inotify_add_watch(fd, patchDir.getFullPathName().toRawUTF8(), mask);
+  const int waveWd =
+      inotify_add_watch(fd, waveDir.getFullPathName().toRawUTF8(), mask);
+  if (patchWd < 0 || waveWd < 0) {
+    close(fd);
+    return false;
+  }
+  // big enough for a good few events at once
+  alignas(inotify_event) char buf[4096];
+  pollfd pfd = {fd, POLLIN, 0};
+  while (!threadShouldExit()) {
+    const int ready = poll(&pfd, 1, WATCHER_SETTLE_MS);
+    if (ready <= 0) {
+      // nothing for a while, so send what's been collected
+      sendPending();
+      continue;
+    }
+    ssize_t len;
+    while ((len = read(fd, buf, sizeof(buf))) > 0) {
+      for (char* ptr = buf; ptr < buf + len;) {
+        auto* event = reinterpret_cast<inotify_event*>(ptr);
+        ptr += sizeof(inotify_event) + event->len;
+        // the kernel dropped events, so we can't trust the
+        // deltas any more
+        if (event->mask & IN_Q_OVERFLOW) {
+          sendFolderChanged(true);
+          sendFolderChanged(false);
+          continue;
+        }
+        if (event->len == 0)
+          continue;
+        const String name = String::fromUTF8(event->name);
+        if (event->wd == patchWd && name.endsWith(UserFiles::patchFileExt)) {
+          pendingPatches.insert(patchDir.getChildFile(name).getFullPathName());
+        } else if (event->wd == waveWd &&
+                   name.endsWith(UserFiles::waveFileExt)) {
+          pendingWaves.insert(waveDir.getChildFile(name).getFullPathName());
+        }
+      }
+    }
+  }
+  close(fd);
+  return true;
+#else
+  return false;
+#endif
+}
+
+void LibraryWatcher::watchWithPolling() {
+  const File patchDir = UserFiles::getPatchesFolder();
+  const File waveDir = UserFiles::getWavetablesFolder();
+  // 1. take the first snapshot without sending anything, the
+  // library's own scan covers whatever's there already
+  pollFolder(patchDir, UserFiles::patchFileExt, patchSnapshot, pendingPatches);
+  pollFolder(waveDir, UserFiles::waveFileExt, waveSnapshot, pendingWaves);
+  pendingPatches.clear();
+  pendingWaves.clear();
+  // 2. check the folders every so often
+  while (!wait(WATCHER_POLL_MS)) {
+    if (threadShouldExit())
+      return;
+    pollFolder(patchDir, UserFiles::patchFileExt, patchSnapshot,
+               pendingPatches);
+    pollFolder(waveDir, UserFiles::waveFileExt, waveSnapshot, pendingWaves);
+    sendPending();
+  }
+}
+
+void LibraryWatcher::pollFolder(const File& folder,
+                                const String& ext,
+                                snapshot_t& snapshot,
+                                std::set<String>& pending) {
+  snapshot_t current;
+  for (auto& f : folder.findChildFiles(File::findFiles, false, "*" + ext)) {
+    current[f.getFullPathName()] = {
+        f.getLastModificationTime().toMilliseconds(), f.getSize()};
+  }
+  // anything new or changed
+  for (auto& [path, stats] : current) {
+    auto old = snapshot.find(path);
+    if (old == snapshot.end() || old->second != stats) {
+      pending.insert(path);
+    }
+  }
+  // anything that's gone
+  for (auto& [path, stats] : snapshot) {
+    if (!current.contains(path)) {
+      pending.insert(path);
+    }
+  }
+  snapshot.swap(current);
+}
+
+//===================================================
+
+void LibraryWatcher::sendPending() {
+  auto toArray = [](std::set<String>& pending) {
+    juce::StringArray arr;
+    for (auto& p : pending) {
+      arr.add(p);
+    }
+    pending.clear();
+    return arr;
+  };
+  if (!pendingPatches.empty()) {
+    auto paths = toArray(pendingPatches);
+    const juce::ScopedLock sl(listenerLock);
+    for (auto* l : listeners) {
+      l->libraryFilesChanged(true, paths);
+    }
+  }
+  if (!pendingWaves.empty()) {
+    auto paths = toArray(pendingWaves);
+    const juce::ScopedLock sl(listenerLock);
+    for (auto* l : listeners) {
+      l->libraryFilesChanged(false, paths);
+    }
+  }
+}
+
+void LibraryWatcher::sendFolderChanged(bool isPatch) {
+  const juce::ScopedLock sl(listenerLock);
+  for (auto* l : listeners) {
+    l->libraryFolderChanged(isPatch);
+  }
+}
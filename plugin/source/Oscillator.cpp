@@ -9,6 +9,11 @@ WavetableOscillator::WavetableOscillator(Wavetable* w, int idx) : wave(w) {
 }
 //===================================================
 //
+static const float minLvl = juce::Decibels::decibelsToGain(-50.0f);
+
+bool WavetableOscillator::isSilent(float levelMod) const {
+  return !wave->isActive() || wave->getLevel() + levelMod < minLvl;
+}
 
 float WavetableOscillator::getNextSample(int midiNote,
                                          float levelMod,
@@ -16,7 +21,6 @@ float WavetableOscillator::getNextSample(int midiNote,
                                          float coarseMod,
                                          float fineMod) {
   jassert(!std::isnan(posMod));
-  static const float minLvl = juce::Decibels::decibelsToGain(-50.0f);
   static const float _oscMaxGain = juce::Decibels::decibelsToGain(-5.0f);
   if (wave->getLevel() + levelMod < minLvl)
     return 0.0f;
@@ -31,6 +35,8 @@ float WavetableOscillator::getNextSample(int midiNote,
   const float _phaseDelt =
       AudioUtil::phaseDeltForNote(midiNote, _coarse, _fine);
   phase = std::fmod(phase + _phaseDelt, 1.0f);
+  if (wave->isSmooth())
+    return wave->getSampleSmooth(phase, _phaseDelt, _pos) * _lvl;
   return wave->getSampleFixed(phase, _phaseDelt, _pos) * _lvl;
 }
 
@@ -9,7 +9,10 @@
 
 void OscillatorPanel::waveAttachCallback(float fWave) {
   const int waveIdx = (int)fWave;
-  jassert(waveIdx < state->userLib.numWavetables());
+  // the library scan might not have gotten to this wave
+  // yet, waveWasFound() tries again when it does
+  if (waveIdx >= wavetableCB.getNumItems())
+    return;
   wavetableCB.setSelectedItemIndex(waveIdx);
 }
 
@@ -70,6 +73,11 @@ void OscillatorPanel::waveWasSaved(wave_meta_t* w) {
   resized();
 }
 
+void OscillatorPanel::waveWasFound(wave_meta_t* w) {
+  waveWasSaved(w);
+  waveAttach->sendInitialUpdate();
+}
+
 void OscillatorPanel::comboBoxChanged(juce::ComboBox* cb) {
   String newWaveName = cb->getText();
   int waveIdx = state->userLib.indexOfWaveName(newWaveName);
@@ -78,7 +86,6 @@ void OscillatorPanel::comboBoxChanged(juce::ComboBox* cb) {
     selectedWaveIdx = waveIdx;
     selectedWaveName = newWaveName;
     waveAttach->setValueAsCompleteGesture((float)waveIdx);
-    state->graph.requestWavetableString(oscID);
     resized();
   }
 }
@@ -128,8 +128,7 @@ void PatchSaver::paint(juce::Graphics& g) {
 //===================================================
 
 PatchListEntry::PatchListEntry(patch_meta_t* p) : patch(p) {
-  nameText.setText(patch->name);
-  authorText.setText(patch->author);
+  // the text gets set from the patch in paint()
   authorText.setColour(UIColor::defaultText);
   nameText.setColour(UIColor::defaultText);
   nameText.setFont(FontData::getFontWithHeight(FontE::FuturaLC, 13.0f));
@@ -203,9 +202,9 @@ PatchCategHeader::PatchCategHeader(int c) {
   setInterceptsMouseClicks(true, true);
   // set up button callback
   btn.onClick = [this]() {
-    auto* parent = getParentComponent();
-    if (parent != nullptr) {
-      parent->resized();
+    auto* list = findParentComponentOfClass<PatchList>();
+    if (list != nullptr) {
+      list->categoryToggled();
     }
   };
   nameText.setText(UserFiles::PatchCategStrings[c]);
@@ -236,97 +235,201 @@ void PatchCategHeader::paint(juce::Graphics& g) {
 }
 
 //===================================================
-//
-// void PatchList::sortPatchList() {
-//   patches.sort(PatchListEntry::compareElements);
-// }
+
+#define PATCH_HEADER_H 25
+#define PATCH_ENTRY_H 21
 
 PatchList::PatchList(ElectrumState* s) : state(s) {
-  // 1. add the category headers
+  // 1. add the category headers, they only get shown when
+  // their row is in view
   for (int i = 0; i < NUM_PATCH_CATEGORIES; ++i) {
     auto* header = categHeaders.add(new PatchCategHeader(i));
-    addAndMakeVisible(header);
+    addChildComponent(header);
   }
-  // 2. add the system patches from the UserLib
-  const int numPatches = state->userLib.numPatches();
-  for (int i = 0; i < numPatches; ++i) {
-    auto p = state->userLib.getPatchAtIndex(i);
-    jassert(p != nullptr);
-    auto comp = patches.add(new PatchListEntry(p));
-    addAndMakeVisible(comp);
-    comp->onClick = [this, p]() { setSelectedPatch(p); };
-    comp->onDoubleClick = [this, p]() {
-      setSelectedPatch(p);
-      auto* pBrowser = findParentComponentOfClass<PatchBrowser>();
-      if (pBrowser != nullptr) {
-        pBrowser->loadCurrentPatch();
-      }
-    };
-  }
-  // sortPatchList();
-  //  3. attach the listener
+  // 2. attach the listener, the patches themselves only get
+  // components once they're scrolled into view
   state->userLib.addListener(this);
+  rebuildRows();
 }
 
 PatchList::~PatchList() {
   state->userLib.removeListener(this);
 }
 
-void PatchList::patchWasSaved(patch_meta_t* p) {
-  auto comp = patches.add(new PatchListEntry(p));
-  addAndMakeVisible(comp);
-  comp->onClick = [this, p]() { setSelectedPatch(p); };
-  // sortPatchList();
-  resized();
+void PatchList::patchWasSaved(patch_meta_t*) {
+  libraryChanged();
 }
 
-void PatchList::setSelectedPatch(patch_meta_t* current) {
-  if (selectedPatch != current) {
-    selectedPatch = current;
-    for (auto* p : patches) {
-      if (p->getPatch() == current) {
-        p->setSelected(true);
-      } else {
-        p->setSelected(false);
-      }
+void PatchList::patchWasFound(patch_meta_t*) {
+  libraryChanged();
+}
+
+void PatchList::patchWasRemoved(patch_meta_t* p) {
+  if (selectedPatch == p)
+    selectedPatch = nullptr;
+  // the rows can't keep pointing at it until the async
+  // update, so drop it now
+  rows.erase(std::remove_if(rows.begin(), rows.end(),
+                            [p](const patch_row_t& r) { return r.patch == p; }),
+             rows.end());
+  sortedPatches.erase(
+      std::remove(sortedPatches.begin(), sortedPatches.end(), p),
+      sortedPatches.end());
+  for (auto* e : entryPool) {
+    if (e->getPatch() == p) {
+      e->setPatch(nullptr);
+      e->setVisible(false);
     }
-    resized();
   }
+  libraryChanged();
 }
 
-void PatchList::resized() {
-  static const int hHeader = 25;
-  static const int hEntry = 21;
+void PatchList::libraryScanFinished() {
+  // changed patches may have moved to another category
+  libraryChanged();
+}
+
+void PatchList::libraryChanged() {
+  // the scan can turn up thousands of patches in a row, this
+  // only rebuilds once they've all come in
+  sortNeeded = true;
+  triggerAsyncUpdate();
+}
+
+void PatchList::handleAsyncUpdate() {
+  rebuildRows();
+}
+
+void PatchList::setSearchQuery(const String& q) {
+  if (q != query) {
+    query = q;
+    rebuildRows();
+    auto* vpt = findParentComponentOfClass<juce::Viewport>();
+    if (vpt != nullptr)
+      vpt->setViewPosition(0, 0);
+  }
+}
+
+void PatchList::rebuildRows() {
+  rows.clear();
+  if (query.trim().isNotEmpty()) {
+    // 1. search results go in as they are
+    for (auto* p : state->userLib.searchPatches(query)) {
+      rows.push_back({p->category, p});
+    }
+  } else {
+    // 2. otherwise sort the library if it's changed and put
+    // each category under its header
+    if (sortNeeded) {
+      sortedPatches.clear();
+      const int numPatches = state->userLib.numPatches();
+      for (int i = 0; i < numPatches; ++i) {
+        sortedPatches.push_back(state->userLib.getPatchAtIndex(i));
+      }
+      std::sort(sortedPatches.begin(), sortedPatches.end(),
+                [](patch_meta_t* a, patch_meta_t* b) {
+                  if (a->category != b->category)
+                    return a->category < b->category;
+                  return a->name.compareIgnoreCase(b->name) < 0;
+                });
+      sortNeeded = false;
+    }
+    auto next = sortedPatches.begin();
+    for (int c = 0; c < NUM_PATCH_CATEGORIES; ++c) {
+      rows.push_back({c, nullptr});
+      const bool open = categHeaders[c]->isOpen();
+      for (; next != sortedPatches.end() && (*next)->category <= c; ++next) {
+        if (open)
+          rows.push_back({c, *next});
+      }
+    }
+  }
+  // 3. lay out the rows
+  rowY.resize(rows.size() + 1);
+  int y = 0;
+  for (size_t r = 0; r < rows.size(); ++r) {
+    rowY[r] = y;
+    y += rows[r].patch == nullptr ? PATCH_HEADER_H : PATCH_ENTRY_H;
+  }
+  rowY[rows.size()] = y;
   const int width = std::max(getLocalBounds().getWidth(), 250);
-  int currentY = 0;
-  for (int i = 0; i < NUM_PATCH_CATEGORIES; ++i) {
-    // 1. place the header
-    categHeaders[i]->setBounds(0, currentY, width, hHeader);
-    currentY += hHeader;
-    // 2. place the appropriate entries
-    for (auto* p : patches) {
-      if (p->getPatch()->category == i) {
-        if (categHeaders[i]->isOpen()) {
-          p->setVisible(true);
-          p->setEnabled(true);
-          p->toFront(true);
-          p->setBounds(0, currentY, width, hEntry);
-          p->repaint();
-          currentY += hEntry;
-        } else {
-          p->setVisible(false);
-          p->setEnabled(false);
-        }
+  // if the size changed the viewport sends the new visible
+  // area on its own, either way this catches the new rows
+  setSize(width, y);
+  updateVisibleRows(visibleArea);
+}
+
+void PatchList::updateVisibleRows(const juce::Rectangle<int>& area) {
+  visibleArea = area;
+  const int width = getWidth();
+  // 1. find the rows in view
+  auto tops = rowY.begin();
+  auto topsEnd = rowY.begin() + (long)rows.size();
+  auto firstBelow = std::upper_bound(tops, topsEnd, area.getY());
+  const int first = std::max(0, (int)(firstBelow - tops) - 1);
+  const int last =
+      (int)(std::lower_bound(tops, topsEnd, area.getBottom()) - tops);
+  // 2. make sure there are enough entries
+  const int needed = last - first;
+  while (entryPool.size() < needed) {
+    auto* e = entryPool.add(new PatchListEntry(nullptr));
+    addChildComponent(e);
+    e->onClick = [this, e]() { setSelectedPatch(e->getPatch()); };
+    e->onDoubleClick = [this, e]() {
+      setSelectedPatch(e->getPatch());
+      auto* pBrowser = findParentComponentOfClass<PatchBrowser>();
+      if (pBrowser != nullptr) {
+        pBrowser->loadCurrentPatch();
       }
+    };
+  }
+  for (auto* e : entryPool) {
+    e->setVisible(false);
+  }
+  for (auto* h : categHeaders) {
+    h->setVisible(false);
+  }
+  // 3. place them
+  int nextEntry = 0;
+  for (int r = first; r < last; ++r) {
+    auto& row = rows[(size_t)r];
+    const int y = rowY[(size_t)r];
+    if (row.patch == nullptr) {
+      auto* h = categHeaders[row.category];
+      h->setBounds(0, y, width, PATCH_HEADER_H);
+      h->setVisible(true);
+    } else {
+      auto* e = entryPool[nextEntry];
+      ++nextEntry;
+      e->setPatch(row.patch);
+      e->setSelected(row.patch == selectedPatch);
+      e->setBounds(0, y, width, PATCH_ENTRY_H);
+      e->setVisible(true);
     }
   }
-  setSize(width, currentY);
-  setBounds(0, 0, width, currentY);
+}
+
+void PatchList::setSelectedPatch(patch_meta_t* current) {
+  if (selectedPatch != current) {
+    selectedPatch = current;
+    for (auto* e : entryPool) {
+      e->setSelected(e->isVisible() && e->getPatch() == current);
+    }
+  }
+}
+
+void PatchList::resized() {
+  updateVisibleRows(visibleArea);
 }
 
 //==================================================================
 
 PatchBrowser::PatchBrowser(ElectrumState* s) : state(s), loader(s), saver(s) {
+  searchBox.setTextToShowWhenEmpty("Search", UIColor::defaultText);
+  searchBox.onTextChange = [this]() {
+    loader.getPL().setSearchQuery(searchBox.getText());
+  };
+  addAndMakeVisible(searchBox);
   loadBtn.setButtonText("Load Patch");
   saveBtn.setButtonText("Save Patch");
   loadBtn.onClick = [this]() { loadCurrentPatch(); };
@@ -346,19 +449,23 @@ void PatchBrowser::resized() {
     loader.setEnabled(true);
     loader.setVisible(true);
     loader.toFront(true);
+    searchBox.setVisible(true);
   }
   auto fBounds = getLocalBounds().toFloat();
   auto bBounds = fBounds.removeFromBottom(35.0f);
   auto sBounds = bBounds.removeFromLeft(bBounds.getWidth() / 2.0f);
   loadBtn.setBounds(sBounds.reduced(3.5f).toNearestInt());
   saveBtn.setBounds(bBounds.reduced(3.5f).toNearestInt());
-  loader.setBounds(fBounds.toNearestInt());
   saver.setBounds(fBounds.toNearestInt());
+  auto searchBounds = fBounds.removeFromTop(24.0f).reduced(2.0f);
+  searchBox.setBounds(searchBounds.toNearestInt());
+  loader.setBounds(fBounds.toNearestInt());
 }
 
 void PatchBrowser::openSaveView() {
   loader.setVisible(false);
   loader.setEnabled(false);
+  searchBox.setVisible(false);
   saveBtn.setEnabled(false);
   loadBtn.setEnabled(false);
   saver.setEnabled(true);
@@ -368,10 +475,8 @@ void PatchBrowser::openSaveView() {
 }
 
 void PatchBrowser::loadCurrentPatch() {
-  if (loader.getPL().getSelected() != nullptr) {
-    auto nState =
-        state->userLib.getMasterTreeForPatch(loader.getPL().getSelected());
-    jassert(nState.isValid());
-    state->replaceState(nState);
-  }
+  // the loader parses it and builds the waves in the
+  // background, then swaps it in
+  if (loader.getPL().getSelected() != nullptr)
+    state->patchLoader.loadPatch(loader.getPL().getSelected());
 }
@@ -0,0 +1,663 @@
+#include "Electrum/Shared/PatchLoader.h"
+#include "Electrum/Shared/ElectrumState.h"
+#include <set>
+
+PreparedPatch::PreparedPatch() {
+  waveIndices.fill(-1);
+  waveHashes.fill(0);
+  lfoHashes.fill(0);
+  hasLfo.fill(false);
+}
+
+//===================================================
+
+PatchLoader::PatchLoader(ElectrumState* s)
+    : juce::Thread("PatchLoader"), state(s) {
+  for (auto& w : wantedWaves) {
+    w.store(-1);
+  }
+  builtWaves.fill(-1);
+  state->userLib.addListener(this);
+  updatePrograms();
+  startThread(juce::Thread::Priority::normal);
+}
+
+PatchLoader::~PatchLoader() {
+  stopThread(2000);
+  cancelPendingUpdate();
+  state->userLib.removeListener(this);
+  // nothing's processing now, let go of whatever was still
+  // on its way or on hand
+  PreparedPatch* p = nullptr;
+  while (toAudio.pop(p)) {
+    p->decReferenceCount();
+  }
+  returned_patch_t returned;
+  while (fromAudio.pop(returned)) {
+    returned.patch->decReferenceCount();
+  }
+  program_patch_t entry;
+  while (programsToAudio.pop(entry)) {
+    if (entry.patch != nullptr)
+      entry.patch->decReferenceCount();
+  }
+  for (int i = 0; i < numAudioPrograms; ++i) {
+    audioPrograms[(size_t)i].patch->decReferenceCount();
+  }
+}
+
+void PatchLoader::loadPatch(patch_meta_t* patch) {
+  jassert(patch != nullptr);
+  {
+    const juce::ScopedLock sl(loadLock);
+    wantedPatch = UserFiles::getPatchesFolder().getChildFile(patch->path);
+  }
+  notify();
+}
+
+bool PatchLoader::loadPatchNow(const File& file) {
+  PreparedPatch::Ptr p = nullptr;
+  {
+    const juce::ScopedLock sl(prepareLock);
+    p = getPreparedPatch(file);
+    if (p == nullptr)
+      return false;
+    claimWaves(*p);
+  }
+  // nothing's processing, so the only things that can stop
+  // it going in are old sets waiting to be let go of and LFO
+  // decodes that haven't finished
+  if (!state->commitPrepared(*p)) {
+    state->flushAsyncUpdates();
+    state->commitPrepared(*p);
+  }
+  state->replaceState(p->tree.createCopy());
+  const int program = indexOfProgram(file);
+  if (program >= 0)
+    currentProgram.store(program);
+  return true;
+}
+
+void PatchLoader::requestProgram(int program) {
+  programRequests.fetch_add(1);
+  wantedProgram.store(program, std::memory_order_release);
+}
+
+int PatchLoader::getNumPrograms() const {
+  const juce::ScopedLock sl(programLock);
+  return (int)programs.size();
+}
+
+String PatchLoader::getProgramName(int program) const {
+  const juce::ScopedLock sl(programLock);
+  if (!juce::isPositiveAndBelow(program, (int)programs.size()))
+    return {};
+  return programs[(size_t)program].name;
+}
+
+void PatchLoader::addProgramRef(ValueTree& stateCopy) const {
+  const int program = currentProgram.load();
+  stateCopy.setProperty(ID::programIndex, program, nullptr);
+  const File file = getProgramFile(program);
+  if (file != File()) {
+    const String path =
+        file.getRelativePathFrom(UserFiles::getPatchesFolder());
+    stateCopy.setProperty(ID::programPath, path, nullptr);
+  }
+}
+
+void PatchLoader::resolveProgramRef(ValueTree& newState) {
+  if (!newState.hasProperty(ID::programIndex))
+    return;
+  // 1. find it by its file if it's still around
+  int program = newState[ID::programIndex];
+  const String path = newState[ID::programPath];
+  if (path.isNotEmpty()) {
+    const int found =
+        indexOfProgram(UserFiles::getPatchesFolder().getChildFile(path));
+    if (found >= 0)
+      program = found;
+  }
+  newState.removeProperty(ID::programIndex, nullptr);
+  newState.removeProperty(ID::programPath, nullptr);
+  // 2. the restored state wins over any program change that
+  // was on its way
+  programRequests.fetch_add(1);
+  wantedProgram.store(-1);
+  currentProgram.store(program);
+}
+
+void PatchLoader::requestWave(int osc, int waveIdx) {
+  // only store on a change so the same request coming in
+  // every block doesn't look like a new one
+  if (wantedWaves[(size_t)osc].load(std::memory_order_relaxed) != waveIdx)
+    wantedWaves[(size_t)osc].store(waveIdx, std::memory_order_release);
+}
+
+PreparedPatch* PatchLoader::nextPrepared() {
+  // 1. keep hold of any programs that have come over
+  receivePrograms();
+  // 2. a program change this thread can do on its own
+  const int program = wantedProgram.load(std::memory_order_acquire);
+  for (int i = 0; program >= 0 && i < numAudioPrograms; ++i) {
+    auto& entry = audioPrograms[(size_t)i];
+    if (entry.program != program)
+      continue;
+    if (!claimOutstanding())
+      break;
+    // the loader may have taken the request first, or a
+    // newer one may have come in
+    int expected = program;
+    if (!wantedProgram.compare_exchange_strong(expected, -1)) {
+      numOutstanding.fetch_sub(1);
+      break;
+    }
+    currentProgram.store(program);
+    // the entry keeps its reference, this one is for
+    // finishedWith()
+    entry.patch->incReferenceCount();
+    return entry.patch;
+  }
+  // 3. otherwise whatever the loader has sent
+  PreparedPatch* p = nullptr;
+  if (toAudio.pop(p))
+    return p;
+  return nullptr;
+}
+
+void PatchLoader::finishedWith(PreparedPatch* p) {
+  if (p->tree.isValid())
+    numBehind.fetch_add(1);
+  returnFromAudio(p, true);
+}
+
+void PatchLoader::returnFromAudio(PreparedPatch* p, bool committed) {
+  // the message thread swaps the tree in and releases it.
+  // numOutstanding makes sure there's room
+  const bool pushed = fromAudio.push({p, committed});
+  jassert(pushed);
+  juce::ignoreUnused(pushed);
+  triggerAsyncUpdate();
+}
+
+void PatchLoader::receivePrograms() {
+  program_patch_t entry;
+  while (programsToAudio.pop(entry)) {
+    // 1. let go of all of them
+    if (entry.patch == nullptr) {
+      for (int i = 0; i < numAudioPrograms; ++i) {
+        returnFromAudio(audioPrograms[(size_t)i].patch, false);
+      }
+      numAudioPrograms = 0;
+      continue;
+    }
+    // 2. or make room by dropping the oldest, the loader
+    // does the same with its copy
+    if (numAudioPrograms == PATCH_AUDIO_PROGRAMS) {
+      returnFromAudio(audioPrograms[0].patch, false);
+      std::move(audioPrograms.begin() + 1, audioPrograms.end(),
+                audioPrograms.begin());
+      --numAudioPrograms;
+    }
+    audioPrograms[(size_t)numAudioPrograms] = entry;
+    ++numAudioPrograms;
+  }
+}
+
+//===================================================
+
+void PatchLoader::run() {
+  while (!threadShouldExit()) {
+    // 1. a whole patch from the browser
+    File file;
+    {
+      const juce::ScopedLock sl(loadLock);
+      file = wantedPatch;
+      wantedPatch = File();
+    }
+    // 2. or a program change the audio thread didn't have
+    // on hand, which wins if both came in
+    const int program = wantedProgram.exchange(-1);
+    const int requests = programRequests.load();
+    if (program >= 0) {
+      const File programFile = getProgramFile(program);
+      if (programFile != File())
+        file = programFile;
+    }
+    bool busy = false;
+    {
+      const juce::ScopedLock sl(prepareLock);
+      if (file != File()) {
+        // unless another program change came in while it
+        // was loading
+        auto p = getPreparedPatch(file);
+        if (p != nullptr &&
+            (program < 0 || requests == programRequests.load()))
+          sendPatch(file, p);
+      }
+      // 3. any waves the audio thread has asked for
+      if (auto p = prepareWaves())
+        sendToAudio(p);
+      sendUnsent();
+      // 4. the audio thread may have changed programs on its
+      // own, its waves are the ones to build on now
+      const int current = currentProgram.load();
+      if (current != prefetchCenter) {
+        for (auto& [sent, p] : sentPrograms) {
+          if (sent == current)
+            claimWaves(*p);
+        }
+        lineUpNeighbors(current);
+      }
+      // 5. get ahead on the neighbors if there's nothing
+      // else going on, and pass them on once they're ready
+      busy = wantedProgram.load() < 0 && prefetchNext();
+      sendPrograms();
+    }
+    if (!busy)
+      wait(PATCH_LOADER_POLL_MS);
+  }
+}
+
+//===================================================
+
+void PatchLoader::patchWasSaved(patch_meta_t*) {
+  programsChanged = true;
+  triggerAsyncUpdate();
+}
+
+void PatchLoader::patchWasFound(patch_meta_t*) {
+  programsChanged = true;
+  triggerAsyncUpdate();
+}
+
+// this comes in before the patch is deleted, the list gets
+// rebuilt once it's gone
+void PatchLoader::patchWasRemoved(patch_meta_t*) {
+  programsChanged = true;
+  triggerAsyncUpdate();
+}
+
+void PatchLoader::libraryScanFinished() {
+  programsChanged = true;
+  triggerAsyncUpdate();
+}
+
+void PatchLoader::updatePrograms() {
+  // 1. sort the library by category and then name, so the
+  // numbers stay put between sessions
+  auto& lib = state->userLib;
+  std::vector<patch_meta_t*> sorted;
+  for (int i = 0; i < lib.numPatches(); ++i) {
+    sorted.push_back(lib.getPatchAtIndex(i));
+  }
+  std::sort(sorted.begin(), sorted.end(),
+            [](patch_meta_t* a, patch_meta_t* b) {
+              if (a->category != b->category)
+                return a->category < b->category;
+              return a->name.compareIgnoreCase(b->name) < 0;
+            });
+  std::vector<program_t> newPrograms;
+  const File folder = UserFiles::getPatchesFolder();
+  for (auto* p : sorted) {
+    newPrograms.push_back({p->name, folder.getChildFile(p->path)});
+  }
+  // 2. swap it in
+  {
+    const juce::ScopedLock sl(programLock);
+    programs.swap(newPrograms);
+  }
+  programsChanged = false;
+  programsMoved.store(true);
+}
+
+int PatchLoader::indexOfProgram(const File& file) const {
+  const juce::ScopedLock sl(programLock);
+  for (size_t i = 0; i < programs.size(); ++i) {
+    if (programs[i].file == file)
+      return (int)i;
+  }
+  return -1;
+}
+
+File PatchLoader::getProgramFile(int program) const {
+  const juce::ScopedLock sl(programLock);
+  if (!juce::isPositiveAndBelow(program, (int)programs.size()))
+    return File();
+  return programs[(size_t)program].file;
+}
+
+//===================================================
+
+PreparedPatch::Ptr PatchLoader::getPreparedPatch(const File& file) {
+  const juce::Time modified = file.getLastModificationTime();
+  for (auto it = patchCache.begin(); it != patchCache.end(); ++it) {
+    if (it->file != file)
+      continue;
+    // 1. still good, move it to the back
+    if (it->modified == modified && wavesAreCurrent(*it->patch)) {
+      auto entry = *it;
+      patchCache.erase(it);
+      patchCache.push_back(entry);
+      return entry.patch;
+    }
+    // 2. the file or one of its waves has changed since
+    patchCache.erase(it);
+    break;
+  }
+  auto p = preparePatch(file);
+  if (p != nullptr)
+    addToCache(file, p);
+  return p;
+}
+
+PreparedPatch::Ptr PatchLoader::findCached(const File& file) const {
+  for (auto& entry : patchCache) {
+    if (entry.file != file)
+      continue;
+    if (entry.modified == file.getLastModificationTime() &&
+        wavesAreCurrent(*entry.patch))
+      return entry.patch;
+    return nullptr;
+  }
+  return nullptr;
+}
+
+bool PatchLoader::wavesAreCurrent(const PreparedPatch& p) const {
+  for (size_t i = 0; i < NUM_OSCILLATORS; ++i) {
+    if (p.waves[i] == nullptr)
+      continue;
+    if (state->userLib.getWaveHash(p.waveIndices[i]) != p.waveHashes[i])
+      return false;
+  }
+  return true;
+}
+
+void PatchLoader::addToCache(const File& file, PreparedPatch::Ptr p) {
+  patchCache.push_back({file, file.getLastModificationTime(), p});
+  // drop the least recently used until it fits, but always
+  // keep the one that was just added
+  const size_t budget = cacheBudget.load();
+  while (patchCache.size() > 1 && getCacheMemoryUsage() > budget) {
+    patchCache.erase(patchCache.begin());
+  }
+}
+
+size_t PatchLoader::getCacheMemoryUsage() const {
+  // patches often share waves, so each set only counts once
+  std::set<const WaveSet*> sets;
+  size_t total = 0;
+  for (auto& entry : patchCache) {
+    total += sizeof(PreparedPatch);
+    for (auto& set : entry.patch->waves) {
+      if (set != nullptr && sets.insert(set.get()).second)
+        total += set->getMemoryUsage();
+    }
+  }
+  return total;
+}
+
+bool PatchLoader::prefetchNext() {
+  while (!prefetchQueue.empty()) {
+    const int program = prefetchQueue.front();
+    prefetchQueue.erase(prefetchQueue.begin());
+    const File file = getProgramFile(program);
+    if (file == File())
+      continue;
+    bool cached = false;
+    for (auto& entry : patchCache) {
+      cached = cached || entry.file == file;
+    }
+    if (cached)
+      continue;
+    if (auto p = preparePatch(file))
+      addToCache(file, p);
+    return true;
+  }
+  return false;
+}
+
+PreparedPatch::Ptr PatchLoader::preparePatch(const File& file) {
+  PreparedPatch::Ptr p = new PreparedPatch();
+  // 1. parse the file
+  p->tree = UserFiles::loadPatchTree(file);
+  if (!p->tree.isValid()) {
+    DLog::log("Could not load patch " + file.getFullPathName());
+    return nullptr;
+  }
+  // 2. build the waves the oscillators will be pointed at
+  for (int i = 0; i < NUM_OSCILLATORS; ++i) {
+    const String waveID = ID::oscillatorWaveIndex.toString() + String(i);
+    for (auto param : p->tree) {
+      if (param.hasType("PARAM") && param["id"].toString() == waveID) {
+        const int waveIdx = (int)param["value"];
+        p->waves[(size_t)i] = buildWaveSet(waveIdx);
+        if (p->waves[(size_t)i] != nullptr) {
+          p->waveIndices[(size_t)i] = waveIdx;
+          p->waveHashes[(size_t)i] = state->userLib.getWaveHash(waveIdx);
+        }
+        break;
+      }
+    }
+  }
+  // 3. the parameter values and modulations
+  prepareParams(*p);
+  auto modTree = p->tree.getChildWithName(ID::ELECTRUM_MOD_TREE);
+  if (modTree.isValid()) {
+    p->modulations.updateMap(modTree);
+    p->hasModulations = true;
+  }
+  // 4. decode the LFO shapes
+  auto lfoTree = p->tree.getChildWithName(ID::LFO_INFO);
+  if (lfoTree.isValid()) {
+    handle_vector_t handles;
+    for (int i = 0; i < NUM_LFOS; ++i) {
+      const String propID = ID::lfoShapeString.toString() + String(i);
+      const String shapeStr = lfoTree[propID];
+      if (shapeStr.isEmpty())
+        continue;
+      LFO::stringDecode(shapeStr, handles);
+      LFO::parseHandlesToTable(handles, p->lfoTables[(size_t)i]);
+      p->lfoHashes[(size_t)i] = shapeStr.hash();
+      p->hasLfo[(size_t)i] = true;
+    }
+  }
+  return p;
+}
+
+void PatchLoader::prepareParams(PreparedPatch& p) const {
+  // the list is fixed once the processor is built, so this
+  // is safe to read from here
+  auto& allParams = state->processor.getParameters();
+  for (int i = 0; i < allParams.size(); ++i) {
+    auto* param = dynamic_cast<juce::RangedAudioParameter*>(allParams[i]);
+    if (param == nullptr)
+      continue;
+    auto paramTree = p.tree.getChildWithProperty("id", param->paramID);
+    if (!paramTree.isValid() || !paramTree.hasProperty("value"))
+      continue;
+    const float value = param->convertTo0to1((float)paramTree["value"]);
+    p.params.push_back({i, value});
+  }
+}
+
+PreparedPatch::Ptr PatchLoader::prepareWaves() {
+  PreparedPatch::Ptr p = nullptr;
+  for (size_t i = 0; i < NUM_OSCILLATORS; ++i) {
+    const int waveIdx = wantedWaves[i].load(std::memory_order_acquire);
+    if (waveIdx < 0 || waveIdx == builtWaves[i])
+      continue;
+    // if the wave list is busy this just tries again on the
+    // next pass
+    auto set = buildWaveSet(waveIdx);
+    if (set == nullptr)
+      continue;
+    if (p == nullptr)
+      p = new PreparedPatch();
+    p->waves[i] = set;
+    p->waveIndices[i] = waveIdx;
+    builtWaves[i] = waveIdx;
+  }
+  return p;
+}
+
+WaveSet::Ptr PatchLoader::buildWaveSet(int waveIdx) {
+  String name;
+  if (!state->userLib.tryGetWaveName(waveIdx, name))
+    return nullptr;
+  // 1. check the cache. Sets are keyed by content so an
+  // edited wave never comes back stale
+  const juce::int64 hash = state->userLib.getWaveHash(waveIdx);
+  for (auto it = waveCache.begin(); it != waveCache.end(); ++it) {
+    if (hash != 0 && it->first == hash) {
+      auto entry = *it;
+      waveCache.erase(it);
+      waveCache.push_back(entry);
+      return entry.second;
+    }
+  }
+  // 2. build it
+  WaveSet::Ptr set = new WaveSet(UserFiles::loadTableStringForWave(name));
+  if (set->size() == 0) {
+    DLog::log("Wave " + name + " has no frames");
+    return nullptr;
+  }
+  if (hash != 0) {
+    waveCache.push_back({hash, set});
+    if (waveCache.size() > PATCH_LOADER_CACHE_SIZE)
+      waveCache.erase(waveCache.begin());
+  }
+  return set;
+}
+
+void PatchLoader::claimWaves(const PreparedPatch& p) {
+  for (size_t i = 0; i < NUM_OSCILLATORS; ++i) {
+    if (p.waves[i] == nullptr)
+      continue;
+    builtWaves[i] = p.waveIndices[i];
+    wantedWaves[i].store(p.waveIndices[i]);
+  }
+}
+
+void PatchLoader::sendPatch(const File& file, PreparedPatch::Ptr p) {
+  // 1. so an older request doesn't put the last wave back
+  claimWaves(*p);
+  sendToAudio(p);
+  // 2. line up the neighbors
+  const int program = indexOfProgram(file);
+  prefetchQueue.clear();
+  if (program < 0)
+    return;
+  currentProgram.store(program);
+  lineUpNeighbors(program);
+}
+
+void PatchLoader::lineUpNeighbors(int program) {
+  // nearest first
+  prefetchCenter = program;
+  prefetchQueue.clear();
+  for (int d = 1; d <= PATCH_PREFETCH_RADIUS; ++d) {
+    prefetchQueue.push_back(program + d);
+    if (program - d >= 0)
+      prefetchQueue.push_back(program - d);
+  }
+}
+
+void PatchLoader::sendPrograms() {
+  // 1. the numbers have moved or one of the patches has gone
+  // stale, so the audio thread lets go of all of them
+  if (programsMoved.exchange(false))
+    clearSentPrograms = true;
+  for (auto& [program, p] : sentPrograms) {
+    clearSentPrograms = clearSentPrograms || !wavesAreCurrent(*p);
+  }
+  if (clearSentPrograms) {
+    if (!programsToAudio.push({-1, nullptr}))
+      return;
+    sentPrograms.clear();
+    clearSentPrograms = false;
+  }
+  // 2. send the current program and its neighbors once
+  // they're cached, nearest first
+  const int current = currentProgram.load();
+  for (int d = 0; d <= PATCH_PREFETCH_RADIUS * 2; ++d) {
+    const int program = current + ((d % 2 == 0) ? -(d / 2) : (d + 1) / 2);
+    if (program < 0)
+      continue;
+    bool sent = false;
+    for (auto& entry : sentPrograms) {
+      sent = sent || entry.first == program;
+    }
+    if (sent)
+      continue;
+    auto p = findCached(getProgramFile(program));
+    if (p == nullptr)
+      continue;
+    if (!programsToAudio.canPush() || !claimOutstanding())
+      return;
+    p->incReferenceCount();
+    programsToAudio.push({program, p.get()});
+    // 3. the audio thread drops its oldest at the same point
+    sentPrograms.push_back({program, p});
+    if (sentPrograms.size() > (size_t)PATCH_AUDIO_PROGRAMS)
+      sentPrograms.erase(sentPrograms.begin());
+  }
+}
+
+void PatchLoader::sendToAudio(PreparedPatch::Ptr p) {
+  unsent.push_back(p);
+  sendUnsent();
+}
+
+void PatchLoader::sendUnsent() {
+  // if the audio thread isn't running or the message thread
+  // is behind on releasing, the rest wait for the next pass
+  size_t sent = 0;
+  while (sent < unsent.size() && toAudio.canPush() && claimOutstanding()) {
+    auto* p = unsent[sent].get();
+    p->incReferenceCount();
+    toAudio.push(p);
+    ++sent;
+  }
+  unsent.erase(unsent.begin(), unsent.begin() + (std::ptrdiff_t)sent);
+}
+
+//===================================================
+
+bool PatchLoader::claimOutstanding() {
+  if (numOutstanding.fetch_add(1) < PATCH_LOADER_RING_SIZE)
+    return true;
+  numOutstanding.fetch_sub(1);
+  return false;
+}
+
+//===================================================
+
+void PatchLoader::handleAsyncUpdate() {
+  // 1. the library has changed, so have the programs
+  bool programChanged = false;
+  if (programsChanged) {
+    updatePrograms();
+    programChanged = true;
+  }
+  // 2. catch the tree up with what the audio thread has
+  // committed and let go of it. The parameters are already
+  // set, so replaceState() only changes the rest of the tree
+  returned_patch_t returned;
+  while (fromAudio.pop(returned)) {
+    auto* p = returned.patch;
+    if (returned.committed && p->tree.isValid()) {
+      state->replaceState(p->tree.createCopy());
+      numBehind.fetch_sub(1);
+      programChanged = true;
+    }
+    p->decReferenceCount();
+    numOutstanding.fetch_sub(1);
+  }
+  // 3. and let the host know, once
+  if (programChanged) {
+    state->processor.updateHostDisplay(
+        juce::AudioProcessorListener::ChangeDetails().withProgramChanged(
+            true));
+  }
+}
@@ -0,0 +1,312 @@
+#include "Electrum/Shared/PatchSearchIndex.h"
+
+// how much each kind of match counts for
+#define SEARCH_EXACT_SCORE 3.0f
+#define SEARCH_PREFIX_SCORE 2.0f
+#define SEARCH_FUZZY_SCORE 1.0f
+
+PatchSearchIndex::PatchSearchIndex() {
+  // the root
+  nodes.push_back(trie_node_t());
+}
+
+juce::StringArray PatchSearchIndex::tokenize(const String& text) {
+  juce::StringArray tokens;
+  String current;
+  for (auto ptr = text.getCharPointer(); !ptr.isEmpty(); ++ptr) {
+    const juce::juce_wchar c = *ptr;
+    if (juce::CharacterFunctions::isLetterOrDigit(c)) {
+      current += juce::CharacterFunctions::toLowerCase(c);
+    } else if (current.isNotEmpty()) {
+      tokens.add(current);
+      current = String();
+    }
+  }
+  if (current.isNotEmpty())
+    tokens.add(current);
+  return tokens;
+}
+
+int PatchSearchIndex::findOrAddToken(const String& token) {
+  int node = 0;
+  for (auto ptr = token.getCharPointer(); !ptr.isEmpty(); ++ptr) {
+    const juce::juce_wchar c = *ptr;
+    auto& children = nodes[(size_t)node].children;
+    auto it = std::lower_bound(
+        children.begin(), children.end(), c,
+        [](const std::pair<juce::juce_wchar, int>& child,
+           juce::juce_wchar ch) { return child.first < ch; });
+    if (it != children.end() && it->first == c) {
+      node = it->second;
+    } else {
+      const int next = (int)nodes.size();
+      children.insert(it, {c, next});
+      // careful, this invalidates 'children'
+      nodes.push_back(trie_node_t());
+      node = next;
+    }
+  }
+  auto& n = nodes[(size_t)node];
+  if (n.token < 0) {
+    n.token = (int)postings.size();
+    postings.push_back({});
+  }
+  return n.token;
+}
+
+int PatchSearchIndex::findNode(const String& prefix) const {
+  int node = 0;
+  for (auto ptr = prefix.getCharPointer(); !ptr.isEmpty(); ++ptr) {
+    const juce::juce_wchar c = *ptr;
+    auto& children = nodes[(size_t)node].children;
+    auto it = std::lower_bound(
+        children.begin(), children.end(), c,
+        [](const std::pair<juce::juce_wchar, int>& child,
+           juce::juce_wchar ch) { return child.first < ch; });
+    if (it == children.end() || it->first != c)
+      return -1;
+    node = it->second;
+  }
+  return node;
+}
+
+template <typename Fn>
+void PatchSearchIndex::forEachTokenBelow(int node, Fn&& fn) const {
+  std::vector<int> stack = {node};
+  while (!stack.empty()) {
+    const auto& n = nodes[(size_t)stack.back()];
+    stack.pop_back();
+    if (n.token >= 0)
+      fn(n.token);
+    for (auto& child : n.children) {
+      stack.push_back(child.second);
+    }
+  }
+}
+
+template <typename Fn>
+void PatchSearchIndex::forEachFuzzyMatch(const String& term,
+                                         int maxDist,
+                                         bool asPrefix,
+                                         Fn&& fn) const {
+  std::vector<juce::juce_wchar> chars;
+  for (auto ptr = term.getCharPointer(); !ptr.isEmpty(); ++ptr) {
+    chars.push_back(*ptr);
+  }
+  const size_t len = chars.size();
+  // each node on the stack carries its parent's edit distance
+  // row, which is all it needs to compute its own
+  struct frame_t {
+    int node;
+    juce::juce_wchar c;
+    std::vector<int> parentRow;
+  };
+  std::vector<int> rootRow(len + 1);
+  for (size_t i = 0; i <= len; ++i) {
+    rootRow[i] = (int)i;
+  }
+  std::vector<frame_t> stack;
+  for (auto& child : nodes[0].children) {
+    stack.push_back({child.second, child.first, rootRow});
+  }
+  std::vector<int> row(len + 1);
+  while (!stack.empty()) {
+    frame_t f = std::move(stack.back());
+    stack.pop_back();
+    // 1. compute this node's row
+    row[0] = f.parentRow[0] + 1;
+    int rowMin = row[0];
+    for (size_t i = 1; i <= len; ++i) {
+      const int cost = chars[i - 1] == f.c ? 0 : 1;
+      row[i] = std::min(
+          {row[i - 1] + 1, f.parentRow[i] + 1, f.parentRow[i - 1] + cost});
+      rowMin = std::min(rowMin, row[i]);
+    }
+    const auto& n = nodes[(size_t)f.node];
+    // 2. the whole term matches the path to here
+    if (row[len] <= maxDist) {
+      const int dist = row[len];
+      if (asPrefix) {
+        forEachTokenBelow(f.node, [&](int t) { fn(t, dist); });
+        continue;
+      }
+      if (n.token >= 0)
+        fn(n.token, dist);
+    }
+    // 3. nothing further down can get any closer
+    if (rowMin > maxDist)
+      continue;
+    for (auto& child : n.children) {
+      stack.push_back({child.second, child.first, row});
+    }
+  }
+}
+
+//===================================================
+
+void PatchSearchIndex::add(patch_meta_t* patch) {
+  jassert(!docIds.contains(patch));
+  // 1. grab a doc slot
+  int doc;
+  if (!freeDocs.empty()) {
+    doc = freeDocs.back();
+    freeDocs.pop_back();
+  } else {
+    doc = (int)docs.size();
+    docs.push_back(doc_t());
+  }
+  docIds[patch] = doc;
+  docs[(size_t)doc].patch = patch;
+  ++numPatches;
+  ranksDirty = true;
+  // 2. collect the fields each token shows up in
+  std::map<int, uint8_t> tokenFields;
+  auto addField = [&](const String& text, search_field_t field) {
+    for (auto& token : tokenize(text)) {
+      tokenFields[findOrAddToken(token)] |= field;
+    }
+  };
+  addField(patch->name, SearchName);
+  addField(patch->author, SearchAuthor);
+  addField(patch->description, SearchDescription);
+  addField(UserFiles::PatchCategStrings[patch->category], SearchCategory);
+  // 3. add the doc to each token's posting list
+  auto& tokens = docs[(size_t)doc].tokens;
+  for (auto& [token, fields] : tokenFields) {
+    auto& list = postings[(size_t)token];
+    auto it = std::lower_bound(
+        list.begin(), list.end(), doc,
+        [](const posting_t& p, int d) { return p.doc < d; });
+    list.insert(it, {doc, fields});
+    tokens.push_back(token);
+  }
+}
+
+void PatchSearchIndex::remove(patch_meta_t* patch) {
+  auto found = docIds.find(patch);
+  if (found == docIds.end())
+    return;
+  const int doc = found->second;
+  docIds.erase(found);
+  auto& d = docs[(size_t)doc];
+  for (int token : d.tokens) {
+    auto& list = postings[(size_t)token];
+    auto it = std::lower_bound(
+        list.begin(), list.end(), doc,
+        [](const posting_t& p, int dc) { return p.doc < dc; });
+    if (it != list.end() && it->doc == doc)
+      list.erase(it);
+  }
+  // tokens stay in the trie with an empty list, most of them
+  // will be back the next time something gets added
+  d.tokens.clear();
+  d.patch = nullptr;
+  freeDocs.push_back(doc);
+  --numPatches;
+  ranksDirty = true;
+}
+
+void PatchSearchIndex::update(patch_meta_t* patch) {
+  remove(patch);
+  add(patch);
+}
+
+void PatchSearchIndex::updateNameRanks() const {
+  if (!ranksDirty)
+    return;
+  std::vector<int> order;
+  for (size_t d = 0; d < docs.size(); ++d) {
+    if (docs[d].patch != nullptr)
+      order.push_back((int)d);
+  }
+  std::sort(order.begin(), order.end(), [this](int a, int b) {
+    return docs[(size_t)a].patch->name.compareIgnoreCase(
+               docs[(size_t)b].patch->name) < 0;
+  });
+  nameRanks.assign(docs.size(), 0);
+  for (size_t i = 0; i < order.size(); ++i) {
+    nameRanks[(size_t)order[i]] = (int)i;
+  }
+  ranksDirty = false;
+}
+
+float PatchSearchIndex::fieldWeight(uint8_t fields) {
+  if (fields & SearchName)
+    return 4.0f;
+  if (fields & (SearchAuthor | SearchCategory))
+    return 2.0f;
+  return 1.0f;
+}
+
+std::vector<patch_meta_t*> PatchSearchIndex::search(
+    const String& query) const {
+  std::vector<patch_meta_t*> results;
+  auto terms = tokenize(query);
+  if (terms.isEmpty())
+    return results;
+  const size_t numDocs = docs.size();
+  termScores.assign(numDocs, 0.0f);
+  totalScores.assign(numDocs, 0.0f);
+  termsMatched.assign(numDocs, 0);
+  for (int t = 0; t < terms.size(); ++t) {
+    const String& term = terms[t];
+    const bool isLast = t == terms.size() - 1;
+    std::fill(termScores.begin(), termScores.end(), 0.0f);
+    // each doc keeps its best match for this term
+    auto addToken = [&](int token, float quality) {
+      for (auto& p : postings[(size_t)token]) {
+        const float score = quality * fieldWeight(p.fields);
+        float& best = termScores[(size_t)p.doc];
+        best = std::max(best, score);
+      }
+    };
+    // 1. exact and prefix matches straight out of the trie
+    bool anyMatch = false;
+    const int node = findNode(term);
+    if (node >= 0) {
+      if (isLast) {
+        forEachTokenBelow(node, [&](int token) {
+          const bool exact = token == nodes[(size_t)node].token;
+          anyMatch = anyMatch || !postings[(size_t)token].empty();
+          addToken(token, exact ? SEARCH_EXACT_SCORE : SEARCH_PREFIX_SCORE);
+        });
+      } else if (nodes[(size_t)node].token >= 0) {
+        anyMatch = !postings[(size_t)nodes[(size_t)node].token].empty();
+        addToken(nodes[(size_t)node].token, SEARCH_EXACT_SCORE);
+      }
+    }
+    // 2. if that turned up nothing it's probably a typo
+    if (!anyMatch && term.length() >= SEARCH_FUZZY_MIN_LENGTH) {
+      forEachFuzzyMatch(term, 1, isLast, [&](int token, int) {
+        addToken(token, SEARCH_FUZZY_SCORE);
+      });
+    }
+    // 3. tally up
+    for (size_t d = 0; d < numDocs; ++d) {
+      if (termScores[d] > 0.0f) {
+        totalScores[d] += termScores[d];
+        ++termsMatched[d];
+      }
+    }
+  }
+  // only docs that matched every term make it
+  std::vector<int> matches;
+  for (size_t d = 0; d < numDocs; ++d) {
+    if (termsMatched[d] == terms.size() && docs[d].patch != nullptr)
+      matches.push_back((int)d);
+  }
+  // ties go alphabetically, by rank so the sort doesn't have
+  // to compare strings
+  updateNameRanks();
+  std::sort(matches.begin(), matches.end(), [this](int a, int b) {
+    const float sa = totalScores[(size_t)a];
+    const float sb = totalScores[(size_t)b];
+    if (sa != sb)
+      return sa > sb;
+    return nameRanks[(size_t)a] < nameRanks[(size_t)b];
+  });
+  for (int d : matches) {
+    results.push_back(docs[(size_t)d].patch);
+  }
+  return results;
+}
@@ -1,5 +1,6 @@
 #include "Electrum/Audio/Modulator/Perlin.h"
 #include "Electrum/Audio/AudioUtil.h"
+#include <juce_dsp/juce_dsp.h>
 
 namespace Perlin {
 
@@ -29,7 +30,7 @@ static int32_t foolishFloor(float fp) {
  * A vector-valued noise over 3D accesses it 96 times, and a
  * float-valued 4D noise 64 times. We want this to fit in the cache!
  */
-static const uint8_t perm[256] = {
+static constexpr uint8_t perm[256] = {
     151, 160, 137, 91,  90,  15,  131, 13,  201, 95,  96,  53,  194, 233, 7,
     225, 140, 36,  103, 30,  69,  142, 8,   99,  37,  240, 21,  10,  23,  190,
     6,   148, 247, 120, 234, 75,  0,   26,  197, 62,  94,  252, 219, 203, 117,
@@ -132,19 +133,151 @@ float getFractal(float x, size_t octaves, float frequency, float lacunarity) {
   return output / denom;
 }
 
+/**
+ * The gradient for each possible hash value, this is the
+ * same math as `grad()` above minus the multiplication
+ * so the generators can do that part in SIMD lanes
+ */
+static constexpr std::array<float, 256> s_genGradients() {
+  std::array<float, 256> arr = {};
+  for (size_t i = 0; i < 256; ++i) {
+    const int h = perm[i] & 0x0F;
+    const float g = 1.0f + (float)(h & 7);
+    arr[i] = ((h & 8) != 0) ? -g : g;
+  }
+  return arr;
+}
+
+static constexpr std::array<float, 256> gradients = s_genGradients();
+
+// the weighted sum of every octave's noise value, before
+// it gets mapped into the 0-1 range
+static float sumOctaves(const float* x0,
+                        const float* g0,
+                        const float* g1,
+                        const float* weights) {
+#if JUCE_USE_SIMD
+  typedef juce::dsp::SIMDRegister<float> vec_t;
+  constexpr size_t lanes = vec_t::SIMDNumElements;
+  static_assert(PERLIN_OCTAVES_MAX % lanes == 0);
+  const vec_t one = vec_t::expand(1.0f);
+  vec_t sum = vec_t::expand(0.0f);
+  for (size_t i = 0; i < PERLIN_OCTAVES_MAX; i += lanes) {
+    const vec_t vx0 = vec_t::fromRawArray(x0 + i);
+    const vec_t vx1 = vx0 - one;
+    vec_t t0 = one - (vx0 * vx0);
+    t0 = t0 * t0;
+    vec_t t1 = one - (vx1 * vx1);
+    t1 = t1 * t1;
+    const vec_t n0 = t0 * t0 * vec_t::fromRawArray(g0 + i) * vx0;
+    const vec_t n1 = t1 * t1 * vec_t::fromRawArray(g1 + i) * vx1;
+    sum += (n0 + n1) * vec_t::fromRawArray(weights + i);
+  }
+  return sum.sum();
+#else
+  float sum = 0.0f;
+  for (size_t i = 0; i < PERLIN_OCTAVES_MAX; ++i) {
+    const float x1 = x0[i] - 1.0f;
+    float t0 = 1.0f - (x0[i] * x0[i]);
+    t0 *= t0;
+    float t1 = 1.0f - (x1 * x1);
+    t1 *= t1;
+    sum += ((t0 * t0 * g0[i] * x0[i]) + (t1 * t1 * g1[i] * x1)) * weights[i];
+  }
+  return sum;
+#endif
+}
+
 }  // namespace Perlin
 //===================================================
+static constexpr perlin_phase_t phaseFracMask = 0x00FFFFFF;
+static constexpr float phaseToFrac = 1.0f / 16777216.0f;
+// same scaling as the `jmap` call in `Perlin::getNoise`
+static constexpr float noiseToNorm = 1.0f / (2.532f * 2.0f);
+
+PerlinGenerator::PerlinGenerator(uint32_t s)
+    : seed((uint8_t)(s & 0xFF)),
+      currentOctaves(1),
+      currentFreq(1.0f),
+      currentLacunarity(2.0f) {
+  // seeded generators also start at a random spot
+  // for each octave
+  juce::Random rng((juce::int64)s);
+  for (size_t i = 0; i < PERLIN_OCTAVES_MAX; ++i) {
+    octavePhases[i] = (s == 0) ? 0 : (perlin_phase_t)rng.nextInt();
+    octaveDeltas[i] = 0;
+    octaveWeights[i] = 0.0f;
+  }
+}
+
 void PerlinGenerator::setParams(size_t octaves,
                                 float frequency,
                                 float lacunarity) {
+  octaves = std::clamp(octaves, (size_t)1, (size_t)PERLIN_OCTAVES_MAX);
+  if (octaves == currentOctaves && fequal(frequency, currentFreq) &&
+      fequal(lacunarity, currentLacunarity) &&
+      currentSampleRate == SampleRate::get()) {
+    return;
+  }
   currentOctaves = octaves;
   currentFreq = frequency;
-  xDelta = (currentFreq / ((float)SampleRate::get() * 6.0f));
   currentLacunarity = lacunarity;
+  currentSampleRate = SampleRate::get();
+  updateDeltas();
+}
+
+void PerlinGenerator::copyParams(const PerlinGenerator& other) {
+  setParams(other.currentOctaves, other.currentFreq, other.currentLacunarity);
+}
+
+void PerlinGenerator::updateDeltas() {
+  // this is the speed the old float accumulator moved at,
+  // it advanced by `freq / (6 * sampleRate)` each sample and
+  // then got scaled by the frequency of each octave
+  const double tickDelta = (double)currentFreq * (double)currentFreq /
+                           (6.0 * currentSampleRate) *
+                           (double)PERLIN_CONTROL_INTERVAL;
+  double octaveFreq = 1.0;
+  float amp = 1.0f;
+  float denom = 0.0f;
+  for (size_t i = 0; i < PERLIN_OCTAVES_MAX; ++i) {
+    const double delta = std::fmod(tickDelta * octaveFreq, 256.0);
+    octaveDeltas[i] = (perlin_phase_t)(delta * 16777216.0);
+    octaveWeights[i] = (i < currentOctaves) ? amp : 0.0f;
+    denom += octaveWeights[i];
+    octaveFreq *= (double)currentLacunarity;
+    amp *= (1.0f / currentLacunarity);
+  }
+  for (size_t i = 0; i < PERLIN_OCTAVES_MAX; ++i) {
+    octaveWeights[i] /= denom;
+  }
+}
+
+float PerlinGenerator::computeNextValue() {
+  alignas(32) float x0[PERLIN_OCTAVES_MAX];
+  alignas(32) float g0[PERLIN_OCTAVES_MAX];
+  alignas(32) float g1[PERLIN_OCTAVES_MAX];
+  // 1. advance each octave and grab the gradients on either side of it
+  for (size_t i = 0; i < PERLIN_OCTAVES_MAX; ++i) {
+    octavePhases[i] += octaveDeltas[i];
+    const perlin_phase_t p = octavePhases[i];
+    const uint8_t i0 = (uint8_t)(p >> 24);
+    const uint8_t i1 = (uint8_t)(i0 + 1);
+    x0[i] = (float)(p & phaseFracMask) * phaseToFrac;
+    g0[i] = Perlin::gradients[(uint8_t)(i0 ^ seed)];
+    g1[i] = Perlin::gradients[(uint8_t)(i1 ^ seed)];
+  }
+  // 2. evaluate every octave at once and map into the 0-1 range
+  const float sum =
+      Perlin::sumOctaves(x0, g0, g1, octaveWeights) * noiseToNorm + 0.5f;
+  return std::clamp(sum, 0.0f, 1.0f);
 }
 
 void PerlinGenerator::tick() {
-  currentX += xDelta;
-  lastOutput = Perlin::getFractal(currentX, currentOctaves, currentFreq,
-                                  currentLacunarity);
+  if (--samplesUntilUpdate <= 0) {
+    samplesUntilUpdate = PERLIN_CONTROL_INTERVAL;
+    outputDelta =
+        (computeNextValue() - lastOutput) / (float)PERLIN_CONTROL_INTERVAL;
+  }
+  lastOutput += outputDelta;
 }
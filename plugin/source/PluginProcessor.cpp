@@ -4,6 +4,7 @@
 #include "Electrum/Common.h"
 #include "Electrum/Identifiers.h"
 #include "Electrum/PluginEditor.h"
+#include "Electrum/Shared/StateFormat.h"
 namespace audio_plugin {
 ElectrumAudioProcessor::ElectrumAudioProcessor()
     : AudioProcessor(
@@ -54,24 +55,29 @@ double ElectrumAudioProcessor::getTailLengthSeconds() const {
   return 0.0;
 }
 
+// the programs are the patch library, in the order the
+// PatchLoader keeps it
 int ElectrumAudioProcessor::getNumPrograms() {
-  return 1;  // NB: some hosts don't cope very well if you tell them there are 0
-  // programs, so this should be at least 1, even if you're not
-  // really implementing programs.
+  // NB: some hosts don't cope very well if you tell them
+  // there are 0 programs, so this should be at least 1
+  return std::max(tree.patchLoader.getNumPrograms(), 1);
 }
 
 int ElectrumAudioProcessor::getCurrentProgram() {
-  return 0;
+  return tree.patchLoader.getCurrentProgram();
 }
 
 void ElectrumAudioProcessor::setCurrentProgram(int index) {
-  juce::ignoreUnused(index);
+  // some hosts set the current program again right after
+  // restoring the state, which would throw the state away.
+  // The state brings its program back with it so that one
+  // gets skipped
+  if (index != tree.patchLoader.getCurrentProgram())
+    tree.patchLoader.requestProgram(index);
 }
 
 const juce::String ElectrumAudioProcessor::getProgramName(int index) {
-  juce::ignoreUnused(index);
-
-  return {};
+  return tree.patchLoader.getProgramName(index);
 }
 
 void ElectrumAudioProcessor::changeProgramName(int index,
@@ -123,7 +129,10 @@ void ElectrumAudioProcessor::processBlock(juce::AudioBuffer<float>& buffer,
   // Make sure to reset the state if your inner loop is processing
   // Alternatively, you can process the samples with the channels
   // interleaved by keeping the same state.
-  tree.modulations.updateMap(tree.getModulationTree());
+  // a patch the audio thread has just committed brought its
+  // own modulations, the tree's are stale until it catches up
+  if (!tree.patchLoader.stateIsBehind())
+    tree.modulations.updateMap(tree.getModulationTree());
   // update the tempo information if needed
   if (tree.wantsPlayHeadUpdate()) {
     auto* ph = getPlayHead();
@@ -145,8 +154,9 @@ void ElectrumAudioProcessor::getStateInformation(
 
     juce::MemoryBlock& destData) {
   auto stateCpy = tree.copyState();
-  String stateXml = stateCpy.toXmlString();
-  destData.replaceAll(stateXml.toRawUTF8(), stateXml.getNumBytesAsUTF8());
+  tree.addWaveRefs(stateCpy);
+  tree.patchLoader.addProgramRef(stateCpy);
+  StateFormat::write(stateCpy, destData);
 }
 
 void ElectrumAudioProcessor::setStateInformation(const void* data,
@@ -154,9 +164,13 @@ void ElectrumAudioProcessor::setStateInformation(const void* data,
   // You should use this method to restore your parameters from this memory
   // block, whose contents will have been created by the getStateInformation()
   // call.
-  String xmlStr((const char*)data, (size_t)sizeInBytes);
-  auto vt = ValueTree::fromXml(xmlStr);
+  // this also handles the XML that older versions saved
+  auto vt = StateFormat::read(data, (size_t)sizeInBytes);
   jassert(vt.isValid());
+  if (!vt.isValid())
+    return;
+  tree.resolveWaveRefs(vt);
+  tree.patchLoader.resolveProgramRef(vt);
   tree.replaceState(vt);
   // tree.ensureLFOTree();
 }
@@ -11,12 +11,6 @@ static bool s_compareWavePts(wave_point_t a, wave_point_t b) {
   return a.waveIdx < b.waveIdx;
 }
 
-static fpoint_t pointLerp(const fpoint_t& a, const fpoint_t& b, float n) {
-  auto x = flerp(a.x, b.x, n);
-  auto y = flerp(a.y, b.y, n);
-  return {x, y};
-}
-
 namespace Pointwise {
 static const float headroomDbAbs = 4.0f;
 static const float yHeadroomNeg =
@@ -270,72 +264,159 @@ Warp::Warp(const ValueTree& frameTree) {
   jassert(points.size() > 1);
 }
 
-static float s_quadraticAtSample(const wave_point_t& _leftWP,
-                                 const wave_point_t& _rightWP,
-                                 int waveIdx) {
-  wave_point_t leftWP = _leftWP;
-  wave_point_t rightWP = _rightWP;
-  // 1. find t and project to a normalized rectangle
-  frect_t normBounds = {0.0f, 0.0f, 1.0f, 1.0f};
-  const float t = (float)(waveIdx - leftWP.waveIdx) /
-                  (float)(rightWP.waveIdx - leftWP.waveIdx);
-  auto lPoint = projectWavePointToSpace(normBounds, leftWP);
-  auto rPoint = projectWavePointToSpace(normBounds, rightWP);
-  fpoint_t cPoint;
-  // 2. figure out which point is the bezier one
-  if (leftWP.pointType > 0) {
-    bez_handle_t handle = {&leftWP, false};
-    cPoint = projectBezierHandleToSpace(normBounds, handle);
-  } else {
-    bez_handle_t handle = {&rightWP, true};
-    cPoint = projectBezierHandleToSpace(normBounds, handle);
-  }
-  // 3. lerp between them
-  auto p1 = pointLerp(lPoint, cPoint, t);
-  auto p2 = pointLerp(rPoint, cPoint, t);
-  auto crossingPt = pointLerp(p1, p2, t);
-  // 4. return a denormalized y-value
-  return flerp(-1.0f, 1.0f, crossingPt.y);
-}
-
-static float s_cubicAtSample(const wave_point_t& _leftWP,
-                             const wave_point_t& _rightWP,
-                             int waveIdx) {
-  // 1. find t and project to a normalized rectangle
-  wave_point_t leftWP = _leftWP;
-  wave_point_t rightWP = _rightWP;
-  frect_t normBounds = {0.0f, 0.0f, 1.0f, 1.0f};
-  const float t = (float)(waveIdx - leftWP.waveIdx) /
-                  (float)(rightWP.waveIdx - leftWP.waveIdx);
-  auto lPoint = projectWavePointToSpace(normBounds, leftWP);
-  auto rPoint = projectWavePointToSpace(normBounds, rightWP);
-  auto lControl = projectBezierHandleToSpace(normBounds, {&leftWP, false});
-  auto rControl = projectBezierHandleToSpace(normBounds, {&leftWP, false});
-  auto lCurrent = pointLerp(lPoint, lControl, t);
-  auto rCurrent = pointLerp(rPoint, rControl, t);
-  fpoint_t crossingPt = pointLerp(lCurrent, rCurrent, t);
-  return flerp(-1.0f, 1.0f, crossingPt.y);
+// a cubic in t, a + bt + ct^2 + dt^3
+struct seg_cubic_t {
+  float a;
+  float b;
+  float c;
+  float d;
+};
+
+static seg_cubic_t s_bezierCubic(float p0, float c1, float c2, float p3) {
+  return {p0, 3.0f * (c1 - p0), 3.0f * (p0 - (2.0f * c1) + c2),
+          p3 - p0 + (3.0f * (c1 - c2))};
+}
+
+static double s_evalCubic(const seg_cubic_t& cub, double t) {
+  return (double)cub.a +
+         (t * ((double)cub.b + (t * ((double)cub.c + (t * (double)cub.d)))));
+}
+
+static double s_evalSlope(const seg_cubic_t& cub, double t) {
+  return (double)cub.b +
+         (t * ((2.0 * (double)cub.c) + (t * 3.0 * (double)cub.d)));
+}
+
+// one segment of the wave as a curve in t, where t goes from
+// 0 at the left point to 1 at the right one. x is in samples
+// from the left point, y is the level
+struct wave_segment_t {
+  seg_cubic_t x;
+  seg_cubic_t y;
+  // straight lines move through x evenly so t is just the
+  // sample index over the length
+  bool isLine;
+};
+
+// where a bezier handle sits, x as a wave index and y as a
+// level, using the same scale projectWavePointToSpace uses
+static fpoint_t s_handlePosition(const wave_point_t& point, bool isLeft) {
+  static const frect_t normBounds = {0.0f, 0.0f, 1.0f, 1.0f};
+  static const float yAmplitude = 0.5f * yHeadroomNeg;
+  wave_point_t pt = point;
+  auto center = projectWavePointToSpace(normBounds, pt);
+  auto handle = projectBezierHandleToSpace(normBounds, {&pt, isLeft});
+  const float x = (float)pt.waveIdx +
+                  ((handle.x - center.x) * (float)(TABLE_SIZE - 1));
+  return {x, pt.level + ((handle.y - center.y) / yAmplitude)};
+}
+
+static wave_segment_t s_segmentBetween(const wave_point_t& left,
+                                       const wave_point_t& right) {
+  const float length = (float)(right.waveIdx - left.waveIdx);
+  const float p0 = left.level;
+  const float p3 = right.level;
+  // 1. straight line
+  if (left.pointType < 1 && right.pointType < 1) {
+    return {{0.0f, length, 0.0f, 0.0f}, {p0, p3 - p0, 0.0f, 0.0f}, true};
+  }
+  // 2. handle x positions relative to the left point, kept
+  // inside the segment so x(t) never runs backwards
+  auto handleX = [&](const fpoint_t& handle) {
+    return std::clamp(handle.x - (float)left.waveIdx, 0.0f, length);
+  };
+  // 3. cubic with the left point's right handle and the
+  // right point's left handle
+  if (left.pointType > 0 && right.pointType > 0) {
+    auto c1 = s_handlePosition(left, false);
+    auto c2 = s_handlePosition(right, true);
+    return {s_bezierCubic(0.0f, handleX(c1), handleX(c2), length),
+            s_bezierCubic(p0, c1.y, c2.y, p3), false};
+  }
+  // 4. quadratic with whichever handle there is, raised to
+  // a cubic
+  auto c = left.pointType > 0 ? s_handlePosition(left, false)
+                              : s_handlePosition(right, true);
+  const float cx = handleX(c);
+  return {s_bezierCubic(0.0f, cx * (2.0f / 3.0f),
+                        length + ((cx - length) * (2.0f / 3.0f)), length),
+          s_bezierCubic(p0, p0 + ((c.y - p0) * (2.0f / 3.0f)),
+                        p3 + ((c.y - p3) * (2.0f / 3.0f)), p3),
+          false};
+}
+
+// finds the t in [lo, 1] where x(t) lands on the target,
+// newton steps that fall back to bisection. x(t) never
+// decreases so the last sample's t is a safe lower bound
+static double s_solveForX(const seg_cubic_t& x, double target, double lo) {
+  double hi = 1.0;
+  double t = lo;
+  for (int i = 0; i < 24; ++i) {
+    const double err = s_evalCubic(x, t) - target;
+    if (std::abs(err) < 1e-7)
+      break;
+    if (err < 0.0)
+      lo = t;
+    else
+      hi = t;
+    const double slope = s_evalSlope(x, t);
+    double next = slope > 0.0 ? t - (err / slope) : lo;
+    if (next <= lo || next >= hi)
+      next = 0.5 * (lo + hi);
+    t = next;
+  }
+  return t;
+}
+
+// writes 'length' samples of the segment starting at t = 0.
+// lines go by forward differencing, doubles so the error
+// doesn't build up over long segments. curves solve x(t) for
+// each sample so the handles' x offsets shape them the way
+// the editor draws them
+static void s_rasterizeSegment(const wave_segment_t& seg,
+                               float* dest,
+                               int length) {
+  if (seg.isLine) {
+    const double h = 1.0 / (double)length;
+    double y = (double)seg.y.a;
+    const double d1 = (double)seg.y.b * h;
+    for (int i = 0; i < length; ++i) {
+      dest[i] = (float)y;
+      y += d1;
+    }
+    return;
+  }
+  double t = 0.0;
+  for (int i = 0; i < length; ++i) {
+    t = s_solveForX(seg.x, (double)i, t);
+    dest[i] = (float)s_evalCubic(seg.y, t);
+  }
+}
+
+void renderWavePoints(const wave_pt_vec& points, float* dest) {
+  jassert(points.size() > 1);
+  jassert(points.front().waveIdx == 0);
+  jassert(points.back().waveIdx == TABLE_SIZE - 1);
+  // each segment covers its left point up to but not
+  // including its right point
+  for (size_t p = 1; p < points.size(); ++p) {
+    auto& left = points[p - 1];
+    auto& right = points[p];
+    const int length = right.waveIdx - left.waveIdx;
+    jassert(length > 0);
+    s_rasterizeSegment(s_segmentBetween(left, right), dest + left.waveIdx,
+                       length);
+  }
+  dest[TABLE_SIZE - 1] = points.back().level;
+}
+
+void Warp::renderFrame(float* dest) const {
+  renderWavePoints(points, dest);
 }
 
 String Warp::encodeFrameString() const {
   float data[TABLE_SIZE];
-  size_t leftPt, rightPt;
-  for (int i = 0; i < TABLE_SIZE; ++i) {
-    leftPt = leftNeighborPointIndex(i);
-    rightPt = leftPt + 1;
-    auto& pLeft = points[leftPt];
-    auto& pRight = points[rightPt];
-    jassert(rightPt < points.size());
-    const float n =
-        (float)(i - pLeft.waveIdx) / (float)(pRight.waveIdx - pLeft.waveIdx);
-    if (pLeft.pointType < 1 && pRight.pointType < 1) {
-      data[i] = flerp(pLeft.level, pRight.level, n);
-    } else if (pLeft.pointType > 0 && pRight.pointType > 0) {
-      data[i] = s_cubicAtSample(pLeft, pRight, i);
-    } else {
-      data[i] = s_quadraticAtSample(pLeft, pRight, i);
-    }
-  }
+  renderFrame(data);
   return stringEncodeWave(data);
 }
 
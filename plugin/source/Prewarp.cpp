@@ -0,0 +1,76 @@
+#include "Electrum/Audio/Filters/Prewarp.h"
+#include <bit>
+#include <map>
+#include <mutex>
+
+namespace Prewarp {
+
+// the float's exponent plus its mantissa in [0, 1), this is
+// equal to log2(x) at powers of two and linear in between
+static constexpr float pseudoLog2(float x) {
+  const auto bits = std::bit_cast<uint32_t>(x);
+  const int exponent = (int)((bits >> 23) & 0xFF) - 127;
+  const float mantissa = (float)(bits & 0x7FFFFF) / (float)(1 << 23);
+  return (float)exponent + mantissa;
+}
+
+// the inverse of the above
+static double pseudoExp2(double x) {
+  const double exponent = std::floor(x);
+  return std::ldexp(1.0 + (x - exponent), (int)exponent);
+}
+
+static constexpr float logMin = (float)PREWARP_OCTAVE_MIN;
+static constexpr float idxScale = (float)PREWARP_POINTS_PER_OCTAVE;
+static_assert(pseudoLog2(FILTER_CUTOFF_MIN) >= (float)PREWARP_OCTAVE_MIN);
+static_assert(pseudoLog2(FILTER_CUTOFF_MAX) < (float)PREWARP_OCTAVE_MAX);
+
+static prewarp_table_t _generateTable(double sampleRate) {
+  prewarp_table_t arr;
+  // keep the prewarp below nyquist in case we're at a
+  // sample rate where the max cutoff would be past it
+  const double hzLimit = sampleRate * 0.49;
+  for (size_t i = 0; i < PREWARP_TABLE_SIZE; ++i) {
+    const double pos = (double)logMin + ((double)i / (double)idxScale);
+    const double hz = std::min(pseudoExp2(pos), hzLimit);
+    const double g =
+        std::tan(juce::MathConstants<double>::pi * hz / sampleRate);
+    arr[i] = {(float)g, (float)(g / (1.0 + g))};
+  }
+  return arr;
+}
+
+const prewarp_tables_t* getTables(double sampleRate) {
+  static std::mutex mutex;
+  static std::map<double, std::unique_ptr<const prewarp_tables_t>> cache;
+  const std::lock_guard<std::mutex> lock(mutex);
+  auto& tables = cache[sampleRate];
+  if (tables == nullptr) {
+    auto built = std::make_unique<prewarp_tables_t>();
+    for (size_t i = 0; i < NUM_OVERSAMPLING_MODES; ++i) {
+      (*built)[i] = _generateTable(sampleRate * (double)(1 << i));
+    }
+    tables = std::move(built);
+  }
+  return tables.get();
+}
+
+void lookup(const prewarp_tables_t* tables,
+            float cutoffHz,
+            float& g,
+            float& bigG,
+            OversamplingE rate) {
+  jassert(tables != nullptr);
+  cutoffHz = std::clamp(cutoffHz, FILTER_CUTOFF_MIN, FILTER_CUTOFF_MAX);
+  const float fIdx = (pseudoLog2(cutoffHz) - logMin) * idxScale;
+  const size_t lowIdx =
+      std::min((size_t)fIdx, (size_t)(PREWARP_TABLE_SIZE - 2));
+  const float t = fIdx - (float)lowIdx;
+  const auto& table = (*tables)[(size_t)rate];
+  const auto& low = table[lowIdx];
+  const auto& high = table[lowIdx + 1];
+  g = flerp(low.g, high.g, t);
+  bigG = flerp(low.bigG, high.bigG, t);
+}
+
+}  // namespace Prewarp
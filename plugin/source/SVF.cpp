@@ -0,0 +1,56 @@
+#include "Electrum/Audio/Filters/SVF.h"
+#include "Electrum/Audio/Filters/Prewarp.h"
+#include "Electrum/Common.h"
+
+void svf_coeffs_t::setCutoff(float cutoffHz) {
+  // the table has G as well but the SVF doesn't need it
+  float bigG;
+  Prewarp::lookup(tables, cutoffHz, g, bigG);
+  invDenom = 1.0f / (1.0f + (k * g) + (g * g));
+}
+
+void svf_coeffs_t::setK(float val) {
+  k = val;
+  invDenom = 1.0f / (1.0f + (k * g) + (g * g));
+}
+
+//===================================================
+
+template <FilterTypeE mode>
+StateVariable<mode>::StateVariable() {
+  for (int i = 0; i < SVF_STATE_SIZE; ++i) {
+    zState[0][i] = 0.0f;
+    zState[1][i] = 0.0f;
+  }
+}
+
+template <FilterTypeE mode>
+void StateVariable<mode>::prepare() {
+  c.setCutoff(cutoffHz);
+  c.snap();
+}
+
+template <FilterTypeE mode>
+void StateVariable<mode>::setCutoffHz(float hz) {
+  if (!fequal(hz, cutoffHz)) {
+    cutoffHz = hz;
+    c.setCutoff(cutoffHz);
+  }
+}
+
+template <FilterTypeE mode>
+float StateVariable<mode>::processMono(float input, int channel) {
+  return SVF::tick<mode>(input, zState[channel], c.g, c.k, c.invDenom);
+}
+
+template <FilterTypeE mode>
+void StateVariable<mode>::processStereo(float& left, float& right) {
+  left = processMono(left, 0);
+  right = processMono(right, 1);
+}
+
+template class StateVariable<SVFLowPass>;
+template class StateVariable<SVFBandPass>;
+template class StateVariable<SVFHighPass>;
+template class StateVariable<SVFNotch>;
+template class StateVariable<SVFPeak>;
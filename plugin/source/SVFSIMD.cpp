@@ -0,0 +1,171 @@
+#include "Electrum/Audio/Filters/SVFSIMD.h"
+#include "Electrum/Common.h"
+
+namespace {
+inline bool isRamping(const svf_coeffs_t* c) {
+  return !fequal(c->g, c->lastG) || !fequal(c->k, c->lastK);
+}
+
+template <typename T>
+inline T denominator(T g, T k) {
+  return SIMD::divide(SIMD::splat<T>(1.0f), (k * g) + (g * g) + 1.0f);
+}
+
+// runs one lane or group of lanes through a block in place
+template <FilterTypeE mode, typename T>
+inline void runSVF(float* buffer,
+                   int numSamples,
+                   T* z,
+                   T g,
+                   T k,
+                   T invDenom,
+                   T inputGain,
+                   T gStep,
+                   T kStep,
+                   bool ramping) {
+  constexpr int stride = (int)(sizeof(T) / sizeof(float));
+  if (ramping) {
+    for (int i = 0; i < numSamples; ++i) {
+      float* frame = buffer + (i * stride);
+      g = g + gStep;
+      k = k + kStep;
+      invDenom = denominator(g, k);
+      const T in = SIMD::load<T>(frame) * inputGain;
+      SIMD::store(SVF::tick<mode>(in, z, g, k, invDenom), frame);
+    }
+  } else {
+    for (int i = 0; i < numSamples; ++i) {
+      float* frame = buffer + (i * stride);
+      const T in = SIMD::load<T>(frame) * inputGain;
+      SIMD::store(SVF::tick<mode>(in, z, g, k, invDenom), frame);
+    }
+  }
+}
+}  // namespace
+
+//===================================================
+
+void SVFBatch::addLane(float* samples,
+                       float* state,
+                       svf_coeffs_t* coeffs,
+                       float inputGain) {
+  jassert(numLanes < SVF_BATCH_MAX);
+  lanes[numLanes] = {samples, state, coeffs, inputGain};
+  ++numLanes;
+}
+
+void SVFBatch::process(FilterTypeE type, int numSamples) {
+  jassert(numSamples <= MAX_VOICE_BLOCK);
+  switch (type) {
+    case SVFLowPass:
+      processLanes<SVFLowPass>(numSamples);
+      break;
+    case SVFBandPass:
+      processLanes<SVFBandPass>(numSamples);
+      break;
+    case SVFHighPass:
+      processLanes<SVFHighPass>(numSamples);
+      break;
+    case SVFNotch:
+      processLanes<SVFNotch>(numSamples);
+      break;
+    case SVFPeak:
+      processLanes<SVFPeak>(numSamples);
+      break;
+    default:
+      break;
+  }
+}
+
+template <FilterTypeE mode>
+void SVFBatch::processLanes(int numSamples) {
+  const float rampScale = 1.0f / (float)numSamples;
+#if JUCE_USE_SIMD
+  using SIMD::vec_t;
+  constexpr int width = SIMD::lanes;
+  alignas(32) float temp[width];
+  for (int first = 0; first < numLanes; first += width) {
+    svf_lane_t* group = lanes + first;
+    const int count = std::min(width, numLanes - first);
+    // 1. gather the coefficients and state, unused lanes get
+    // zeroes
+    auto gather = [&](auto getValue) {
+      for (int l = 0; l < width; ++l) {
+        temp[l] = (l < count) ? getValue(group[l]) : 0.0f;
+      }
+      return vec_t::fromRawArray(temp);
+    };
+    bool ramping = false;
+    for (int l = 0; l < count; ++l) {
+      ramping = ramping || isRamping(group[l].coeffs);
+    }
+    const vec_t inputGain =
+        gather([](const svf_lane_t& l) { return l.inputGain; });
+    vec_t g;
+    vec_t k;
+    vec_t invDenom = vec_t::expand(1.0f);
+    vec_t gStep = vec_t::expand(0.0f);
+    vec_t kStep = vec_t::expand(0.0f);
+    if (ramping) {
+      g = gather([](const svf_lane_t& l) { return l.coeffs->lastG; });
+      k = gather([](const svf_lane_t& l) { return l.coeffs->lastK; });
+      gStep = gather([=](const svf_lane_t& l) {
+        return (l.coeffs->g - l.coeffs->lastG) * rampScale;
+      });
+      kStep = gather([=](const svf_lane_t& l) {
+        return (l.coeffs->k - l.coeffs->lastK) * rampScale;
+      });
+    } else {
+      g = gather([](const svf_lane_t& l) { return l.coeffs->g; });
+      k = gather([](const svf_lane_t& l) { return l.coeffs->k; });
+      invDenom =
+          gather([](const svf_lane_t& l) { return l.coeffs->invDenom; });
+    }
+    vec_t z[SVF_STATE_SIZE];
+    for (int p = 0; p < SVF_STATE_SIZE; ++p) {
+      z[p] = gather([p](const svf_lane_t& l) { return l.state[p]; });
+    }
+    // 2. interleave the samples so each index is one vector
+    for (int i = 0; i < numSamples; ++i) {
+      float* frame = interleaved + (i * width);
+      for (int l = 0; l < width; ++l) {
+        frame[l] = (l < count) ? group[l].samples[i] : 0.0f;
+      }
+    }
+    // 3. run the filter
+    runSVF<mode>(interleaved, numSamples, z, g, k, invDenom, inputGain, gStep,
+                 kStep, ramping);
+    // 4. de-interleave and write the state back
+    for (int i = 0; i < numSamples; ++i) {
+      const float* frame = interleaved + (i * width);
+      for (int l = 0; l < count; ++l) {
+        group[l].samples[i] = frame[l];
+      }
+    }
+    for (int p = 0; p < SVF_STATE_SIZE; ++p) {
+      z[p].copyToRawArray(temp);
+      for (int l = 0; l < count; ++l) {
+        group[l].state[p] = temp[l];
+      }
+    }
+  }
+#else
+  for (int l = 0; l < numLanes; ++l) {
+    auto& lane = lanes[l];
+    const svf_coeffs_t* c = lane.coeffs;
+    if (isRamping(c)) {
+      runSVF<mode>(lane.samples, numSamples, lane.state, c->lastG, c->lastK,
+                   0.0f, lane.inputGain, (c->g - c->lastG) * rampScale,
+                   (c->k - c->lastK) * rampScale, true);
+    } else {
+      runSVF<mode>(lane.samples, numSamples, lane.state, c->g, c->k,
+                   c->invDenom, lane.inputGain, 0.0f, 0.0f, false);
+    }
+  }
+#endif
+  // both channels of a voice share their coefficients, so
+  // the ramps are only done once every lane has run
+  for (int l = 0; l < numLanes; ++l) {
+    lanes[l].coeffs->snap();
+  }
+}
@@ -0,0 +1,54 @@
+#include "Electrum/Shared/StateFormat.h"
+
+namespace StateFormat {
+
+bool isBinary(const void* data, size_t size) {
+  if (size < 3 * sizeof(juce::int32))
+    return false;
+  juce::MemoryInputStream stream(data, size, false);
+  return stream.readInt() == STATE_MAGIC;
+}
+
+void write(const ValueTree& state, juce::MemoryBlock& dest, bool compress) {
+  dest.reset();
+  juce::MemoryOutputStream stream(dest, false);
+  stream.writeInt(STATE_MAGIC);
+  stream.writeInt(STATE_VERSION);
+  stream.writeInt(compress ? STATE_FLAG_GZIP : 0);
+  if (compress) {
+    juce::GZIPCompressorOutputStream gzip(stream, STATE_GZIP_LEVEL);
+    state.writeToStream(gzip);
+    gzip.flush();
+  } else {
+    state.writeToStream(stream);
+  }
+}
+
+ValueTree read(const void* data, size_t size) {
+  if (data == nullptr || size == 0)
+    return ValueTree();
+  // 1. anything without the header is from before the binary
+  // format
+  if (!isBinary(data, size)) {
+    String xmlStr((const char*)data, size);
+    return ValueTree::fromXml(xmlStr);
+  }
+  juce::MemoryInputStream stream(data, size, false);
+  stream.readInt();
+  const int version = stream.readInt();
+  const int flags = stream.readInt();
+  // 2. nothing sensible to do with a state from a newer
+  // version than this
+  if (version > STATE_VERSION) {
+    DLog::log("State version " + String(version) + " is newer than " +
+              String(STATE_VERSION));
+    return ValueTree();
+  }
+  if (flags & STATE_FLAG_GZIP) {
+    juce::GZIPDecompressorInputStream gzip(stream);
+    return ValueTree::readFromStream(gzip);
+  }
+  return ValueTree::readFromStream(stream);
+}
+
+}  // namespace StateFormat
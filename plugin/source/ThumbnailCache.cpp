@@ -0,0 +1,154 @@
+#include "Electrum/GUI/WaveEditor/ThumbnailCache.h"
+#include "Electrum/Audio/Wavetable.h"
+#include "Electrum/GUI/LookAndFeel/Color.h"
+
+ThumbnailCache::ThumbnailCache()
+    : juce::Thread("ThumbnailCache"),
+      atlas(juce::Image::RGB,
+            THUMBNAIL_W * THUMB_ATLAS_COLS,
+            THUMBNAIL_H * THUMB_ATLAS_ROWS,
+            true,
+            juce::SoftwareImageType()) {
+  startThread(juce::Thread::Priority::low);
+}
+
+ThumbnailCache::~ThumbnailCache() {
+  cancelPendingUpdate();
+  signalThreadShouldExit();
+  notify();
+  stopThread(1000);
+}
+
+juce::int64 ThumbnailCache::hashWave(const String& waveStr) {
+  // the low bit is left for the selection
+  return waveStr.hashCode64() & ~(juce::int64)1;
+}
+
+void ThumbnailCache::removeListener(Listener* l) {
+  for (auto it = listeners.begin(); it != listeners.end(); ++it) {
+    if (*it == l) {
+      listeners.erase(it);
+      return;
+    }
+  }
+}
+
+bool ThumbnailCache::draw(juce::Graphics& g,
+                          frect_t bounds,
+                          juce::int64 waveHash,
+                          const String& waveStr,
+                          bool selected) {
+  const juce::int64 key = waveHash | (selected ? 1 : 0);
+  const juce::ScopedLock sl(lock);
+  auto it = slots.find(key);
+  if (it != slots.end()) {
+    // 1. move it to the front of the LRU list and draw it
+    // straight from the atlas
+    lru.splice(lru.begin(), lru, it->second.lruPos);
+    auto slot = atlas.getClippedImage(slotBounds(it->second.index));
+    g.drawImage(slot, bounds);
+    return true;
+  }
+  // 2. otherwise queue it up if it isn't already
+  if (queued.insert(key).second) {
+    queue.push_back({key, waveStr, selected});
+    // anything this far back is long gone from the screen
+    if (queue.size() > (size_t)THUMB_ATLAS_SLOTS) {
+      queued.erase(queue.front().key);
+      queue.erase(queue.begin());
+    }
+    notify();
+  }
+  return false;
+}
+
+juce::Rectangle<int> ThumbnailCache::slotBounds(int index) {
+  const int x = (index % THUMB_ATLAS_COLS) * THUMBNAIL_W;
+  const int y = (index / THUMB_ATLAS_COLS) * THUMBNAIL_H;
+  return {x, y, THUMBNAIL_W, THUMBNAIL_H};
+}
+
+int ThumbnailCache::claimSlot(juce::int64 key) {
+  int index = (int)slots.size();
+  if (index >= THUMB_ATLAS_SLOTS) {
+    // evict the least recently drawn thumbnail
+    auto oldest = slots.find(lru.back());
+    jassert(oldest != slots.end());
+    index = oldest->second.index;
+    slots.erase(oldest);
+    lru.pop_back();
+  }
+  lru.push_front(key);
+  slots[key] = {index, lru.begin()};
+  return index;
+}
+
+void ThumbnailCache::renderThumbnail(juce::Image& img,
+                                     const String& waveStr,
+                                     bool selected) {
+  // 1. parse the wave into numbers
+  float temp[TABLE_SIZE];
+  stringDecodeWave(waveStr, temp);
+  img.clear(img.getBounds(), UIColor::windowBkgnd);
+  juce::Graphics g(img);
+  juce::Path p;
+  static const float y0 = (float)THUMBNAIL_H / 2.0f;
+  p.startNewSubPath(0.0f, y0);
+  float y = y0;
+  // 2. stroke the path
+  for (int i = 0; i < THUMBNAIL_W; ++i) {
+    float xNorm = (float)i / (float)THUMBNAIL_W;
+    int idx = (int)(xNorm * (float)TABLE_SIZE);
+    y = y0 + (y0 * temp[idx]);
+    p.lineTo((float)i, y);
+  }
+  juce::PathStrokeType pst(2.5f);
+  auto strokeColor = selected ? Color::periwinkle : Color::literalOrangePale;
+  g.setColour(strokeColor);
+  g.strokePath(p, pst);
+  auto rect = img.getBounds().toFloat();
+  auto outlineStroke = selected ? 3.0f : 1.0f;
+  g.drawRect(rect, outlineStroke);
+}
+
+void ThumbnailCache::run() {
+  // software images so nothing here touches the GPU off the
+  // message thread
+  juce::Image img(juce::Image::RGB, THUMBNAIL_W, THUMBNAIL_H, true,
+                  juce::SoftwareImageType());
+  while (!threadShouldExit()) {
+    // 1. grab the newest job
+    render_job_t job;
+    bool hasJob = false;
+    {
+      const juce::ScopedLock sl(lock);
+      if (!queue.empty()) {
+        job = queue.back();
+        queue.pop_back();
+        hasJob = true;
+      }
+    }
+    if (!hasJob) {
+      wait(-1);
+      continue;
+    }
+    // 2. render it without holding the lock
+    renderThumbnail(img, job.waveStr, job.selected);
+    // 3. copy it into the atlas
+    {
+      const juce::ScopedLock sl(lock);
+      queued.erase(job.key);
+      const int index = claimSlot(job.key);
+      auto dest = slotBounds(index);
+      juce::Graphics g(atlas);
+      g.drawImageAt(img, dest.getX(), dest.getY());
+    }
+    triggerAsyncUpdate();
+  }
+}
+
+void ThumbnailCache::handleAsyncUpdate() {
+  for (auto* l : listeners) {
+    l->thumbnailsReady();
+  }
+}
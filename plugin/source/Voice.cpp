@@ -43,20 +43,21 @@ bool VoiceGateEnvelope::isFinished() const {
 
 //===================================================
 
-float* FilterSumHandler::filterLeft(int f) {
-  size_t i = (size_t)(2 * f);
-  return &data[i];
+void FilterSumHandler::clear(int numSamples) {
+  for (int b = 0; b < ROUTING_NUM_BUFFERS; ++b) {
+    std::fill(data[b][0], data[b][0] + numSamples, 0.0f);
+    std::fill(data[b][1], data[b][1] + numSamples, 0.0f);
+    silent[b] = true;
+  }
 }
 
-float* FilterSumHandler::filterRight(int f) {
-  size_t i = (size_t)(2 * f) + 1;
-  return &data[i];
-}
-// call this with the references to the passed in samples
-void FilterSumHandler::addCurrentSumTo(float& left, float& right) const {
-  for (size_t i = 0; i < 3; ++i) {
-    left += data[(2 * i)];
-    right += data[(2 * i) + 1];
+void FilterSumHandler::addInto(int src, int dest, int numSamples) {
+  if (silent[src])
+    return;
+  silent[dest] = false;
+  for (int i = 0; i < numSamples; ++i) {
+    data[dest][0][i] += data[src][0][i];
+    data[dest][1][i] += data[src][1][i];
   }
 }
 
@@ -70,8 +71,11 @@ float ElectrumVoice::_currentModSrcVal(int src) {
   } else if (id < ModSourceE::Perlin1) {
     return lfos[src - NUM_ENVELOPES]->getCurrentSample();
   } else if (id < ModSourceE::LevelMono) {
-    return state->audioData.perlinGens[src - (NUM_ENVELOPES + NUM_LFOS)]
-        .getValue();
+    const int perlinIdx = src - (NUM_ENVELOPES + NUM_LFOS);
+    auto& shared = state->audioData.perlinGens[perlinIdx];
+    return shared.isPerVoice()
+               ? perlins[perlinIdx]->getValue()
+               : state->audioData.perlinValues[perlinIdx][blockSample];
   } else if (id == ModSourceE::LevelMono) {
     return rms.currentLevel();
   } else if (id == ModSourceE::LevelPoly) {
@@ -83,8 +87,6 @@ float ElectrumVoice::_currentModSrcVal(int src) {
 }
 
 float ElectrumVoice::_normalizedModulationForDest(ModMap* map, int destID) {
-  // this static array holds info about the current modulation dest
-  static mod_src_t currentMods[MOD_SOURCES];
   int numSources = 0;
   float sum = 0.0f;
   map->getSourcesSafe(currentMods, &numSources, destID);
@@ -100,31 +102,33 @@ float ElectrumVoice::_normalizedModulationForDest(ModMap* map, int destID) {
 }
 
 void ElectrumVoice::_updateModDests(ModMap* map) {
-  // 1. Update the  oscillators
+  // 1. work out every dest's value
+  for (int d = 0; d < MOD_DESTS; ++d) {
+    modDestValues[d] = _normalizedModulationForDest(map, d);
+  }
+  // 2. update the oscillators
   int oscIdx = 0;
   int destIdx = 0;
   int filterIdx = 0;
   while (oscIdx < NUM_OSCILLATORS && destIdx < (int)ModDestE::filt1Cutoff) {
-    oscModState[oscIdx].coarseMod = _normalizedModulationForDest(map, destIdx);
+    oscModState[oscIdx].coarseMod = modDestValues[destIdx];
     ++destIdx;
-    oscModState[oscIdx].fineMod = _normalizedModulationForDest(map, destIdx);
+    oscModState[oscIdx].fineMod = modDestValues[destIdx];
     ++destIdx;
-    oscModState[oscIdx].posMod = _normalizedModulationForDest(map, destIdx);
+    oscModState[oscIdx].posMod = modDestValues[destIdx];
     ++destIdx;
-    oscModState[oscIdx].levelMod = _normalizedModulationForDest(map, destIdx);
+    oscModState[oscIdx].levelMod = modDestValues[destIdx];
     ++destIdx;
-    oscModState[oscIdx].panMod = _normalizedModulationForDest(map, destIdx);
+    oscModState[oscIdx].panMod = modDestValues[destIdx];
     ++destIdx;
     ++oscIdx;
   }
   while (destIdx < MOD_DESTS && filterIdx < NUM_FILTERS) {
-    filters[filterIdx]->setCutoffMod(
-        _normalizedModulationForDest(map, destIdx));
+    filters[filterIdx]->setCutoffMod(modDestValues[destIdx]);
     ++destIdx;
-    filters[filterIdx]->setResonanceMod(
-        _normalizedModulationForDest(map, destIdx));
+    filters[filterIdx]->setResonanceMod(modDestValues[destIdx]);
     ++destIdx;
-    filters[filterIdx]->setGainMod(_normalizedModulationForDest(map, destIdx));
+    filters[filterIdx]->setGainMod(modDestValues[destIdx]);
     ++destIdx;
     ++filterIdx;
   }
@@ -145,6 +149,12 @@ ElectrumVoice::ElectrumVoice(ElectrumState* s, int idx)
   for (int i = 0; i < NUM_LFOS; i++) {
     lfos.add(new VoiceLFO(&state->audioData.lfos[i]));
   }
+  // instantiate the Perlin generators, each one gets a seed
+  // that no other voice or shared generator is using
+  for (int i = 0; i < NUM_PERLIN_GENS; ++i) {
+    const auto seed = (uint32_t)(NUM_PERLIN_GENS + (idx * NUM_PERLIN_GENS) + i);
+    perlins.add(new PerlinGenerator(seed));
+  }
   // instantiate the filters
   for (int i = 0; i < NUM_FILTERS; ++i) {
     auto* params = &state->audioData.filters[i];
@@ -153,11 +163,12 @@ ElectrumVoice::ElectrumVoice(ElectrumState* s, int idx)
 }
 
 bool ElectrumVoice::isBusy() const {
-  return gate || (!vge.isFinished());
+  return gate || (!vge.isFinished() && !endedSilent);
 }
 
 void ElectrumVoice::startNote(int note, float vel) {
   currentNote = note;
+  endedSilent = false;
   currentNoteVelocity = vel;
   gate = true;
   vge.start();
@@ -195,70 +206,153 @@ void ElectrumVoice::sampleRateSet(double sr) {
   }
 }
 
-void ElectrumVoice::addToFilterSums(float oscL, float oscR, int oscID) {
-  bool filtered = false;
-  auto& params1 = state->audioData.filters[0];
-  if (params1.oscActive[(size_t)oscID]) {
-    filtered = true;
-    filterSums.addToFilter1(oscL, oscR);
+bool ElectrumVoice::beginBlock() {
+  if (!isBusy()) {
+    if (wasBusy) {
+      state->graph.voiceEnded(voiceIndex);
+      wasBusy = false;
+    }
+    return false;
   }
-  auto& params2 = state->audioData.filters[1];
-  if (params2.oscActive[(size_t)oscID]) {
-    filtered = true;
-    filterSums.addToFilter2(oscL, oscR);
+  return true;
+}
+
+void ElectrumVoice::findAudibleOscillators(bool* audible) {
+  const auto& plan = state->audioData.routing.getPlan();
+  for (int i = 0; i < NUM_OSCILLATORS; ++i) {
+    audible[i] = plan.numOscDests[i] > 0 &&
+                 !oscs[i]->isSilent(oscModState[i].levelMod);
+    if (audible[i]) {
+      for (int d = 0; d < plan.numOscDests[i]; ++d) {
+        filterSums.markSounding(plan.oscDests[i][d]);
+      }
+    }
   }
-  if (!filtered) {
-    filterSums.addToDry(oscL, oscR);
+}
+
+bool ElectrumVoice::oscLevelsCanOnlyFall() {
+  // released envelopes and velocity can't push a level up,
+  // anything else might
+  for (int i = 0; i < NUM_OSCILLATORS; ++i) {
+    const int destID = (int)ModDestE::osc1Level + (5 * i);
+    int numSources = 0;
+    state->modulations.getSourcesSafe(currentMods, &numSources, destID);
+    for (int m = 0; m < numSources; ++m) {
+      const int src = currentMods[m].source;
+      const bool isEnv = src < NUM_ENVELOPES && currentMods[m].depth >= 0.0f;
+      if (!isEnv && src != (int)ModSourceE::Velocity)
+        return false;
+    }
   }
+  return true;
 }
 
-void ElectrumVoice::renderNextSample(float& left,
-                                     float& right,
-                                     bool updateDests) {
-  bool busy = isBusy();
-  if (!busy) {
-    if (wasBusy) {
-      state->graph.voiceEnded(voiceIndex);
-      wasBusy = false;
+void ElectrumVoice::renderOscillators(int numSamples,
+                                     bool updateDests,
+                                     bool everySample) {
+  jassert(numSamples <= MAX_VOICE_BLOCK);
+  filterSums.clear(numSamples);
+  const auto& plan = state->audioData.routing.getPlan();
+  bool audible[NUM_OSCILLATORS] = {};
+  for (int s = 0; s < numSamples; ++s) {
+    blockSample = s;
+    // 1. tick the envelopes and LFOs
+    for (auto* e : envs)
+      e->tick();
+    for (auto* l : lfos)
+      l->tick(s);
+    for (int i = 0; i < NUM_PERLIN_GENS; ++i) {
+      if (state->audioData.perlinGens[i].isPerVoice())
+        perlins[i]->tick();
+    }
+    vge.tick();
+    // 2. update modulation dests if needed, the levels can't
+    // change after this so the silent oscillators can be
+    // skipped for the rest of the block. Unless they're
+    // updating every sample, then it gets checked each time
+    if (s == 0 || everySample) {
+      if (updateDests || everySample)
+        _updateModDests(&state->modulations);
+      findAudibleOscillators(audible);
     }
+    // 3. add samples from the oscillators
+    for (int i = 0; i < NUM_OSCILLATORS; ++i) {
+      if (!audible[i])
+        continue;
+      float oscLeft = 0.0f;
+      float oscRight = 0.0f;
+      oscs[i]->renderSampleStereo(currentNote, oscModState[i].levelMod,
+                                  oscModState[i].posMod, oscModState[i].panMod,
+                                  oscModState[i].coarseMod,
+                                  oscModState[i].fineMod, oscLeft, oscRight);
+      for (int d = 0; d < plan.numOscDests[i]; ++d) {
+        filterSums.add(plan.oscDests[i][d], s, oscLeft, oscRight);
+      }
+    }
+    const float gateLvl = vge.getCurrentSample();
+    gateLevels[s] = gateLvl;
+    // 4. deal with any killQuick that may be happening
+    if (inQuickKill && gateLvl <= minEnvelopeLvl) {
+      inQuickKill = false;
+      startNote(queuedNote, queuedVelocity);
+    }
+  }
+}
+
+void ElectrumVoice::setFilterOversampling(OversamplingE rate) {
+  for (auto* f : filters) {
+    f->setOversampling(rate);
+  }
+}
+
+void ElectrumVoice::addFilterLanes(int filterIdx,
+                                   LadderBatch& ladders,
+                                   SVFBatch& svfs) {
+  // a filter that's rung out would just turn silence into
+  // more silence
+  if (filterSums.isSilent(filterIdx) && filters[filterIdx]->flushIfSilent())
     return;
+  filterSums.markSounding(filterIdx);
+  filters[filterIdx]->addToBatch(ladders, svfs,
+                                 filterSums.bufferLeft(filterIdx),
+                                 filterSums.bufferRight(filterIdx));
+}
+
+void ElectrumVoice::routeFilterOutput(const filter_step_t& step,
+                                      int numSamples) {
+  if (step.dest != ROUTING_OUTPUT) {
+    filterSums.addInto(step.filter, step.dest, numSamples);
   }
-  // 1. tick the envelopes and LFOs
-  for (auto* e : envs)
-    e->tick();
-  for (auto* l : lfos)
-    l->tick();
-  vge.tick();
-  // 2. update modulation dests if needed
-  if (updateDests)
-    _updateModDests(&state->modulations);
-  // 3. add samples from the oscillators
-  filterSums.clear();
-  for (int i = 0; i < NUM_OSCILLATORS; ++i) {
-    float oscLeft = 0.0f;
-    float oscRight = 0.0f;
-    oscs[i]->renderSampleStereo(currentNote, oscModState[i].levelMod,
-                                oscModState[i].posMod, oscModState[i].panMod,
-                                oscModState[i].coarseMod,
-                                oscModState[i].fineMod, oscLeft, oscRight);
-    addToFilterSums(oscLeft, oscRight, i);
-  }
-  // 4. this is where filters and any other per-voice waveshaping happens
-  for (int i = 0; i < NUM_FILTERS; ++i) {
-    filters[i]->processStereo(*filterSums.filterLeft(i),
-                              *filterSums.filterRight(i));
-  }
-  // 5. add to the output
-  const float gateLvl = vge.getCurrentSample();
-  auto vLeft = filterSums.getLeftSum() * gateLvl;
-  auto vRight = filterSums.getRightSum() * gateLvl;
-  rms.tick(vLeft, vRight);
-  left += vLeft;
-  right += vRight;
-  // 6. deal with any killQuick that may be happening
-  if (inQuickKill && gateLvl <= minEnvelopeLvl) {
-    inQuickKill = false;
-    startNote(queuedNote, queuedVelocity);
+}
+
+void ElectrumVoice::renderOutput(float* left, float* right, int numSamples) {
+  const auto& plan = state->audioData.routing.getPlan();
+  bool silent = true;
+  for (int o = 0; o < plan.numOutputs; ++o) {
+    silent = silent && filterSums.isSilent(plan.outputs[o]);
+  }
+  if (silent) {
+    for (int s = 0; s < numSamples; ++s) {
+      rms.tick(0.0f, 0.0f);
+    }
+    // nothing is making sound and nothing can start again
+    // without a new note
+    if (!gate && !inQuickKill && oscLevelsCanOnlyFall())
+      endedSilent = true;
+    return;
+  }
+  for (int s = 0; s < numSamples; ++s) {
+    float vLeft = 0.0f;
+    float vRight = 0.0f;
+    for (int o = 0; o < plan.numOutputs; ++o) {
+      vLeft += filterSums.bufferLeft(plan.outputs[o])[s];
+      vRight += filterSums.bufferRight(plan.outputs[o])[s];
+    }
+    vLeft *= gateLevels[s];
+    vRight *= gateLevels[s];
+    rms.tick(vLeft, vRight);
+    left[s] += vLeft;
+    right[s] += vRight;
   }
 }
 
@@ -266,31 +360,26 @@ void ElectrumVoice::updateForBlock() {
   for (int i = 0; i < NUM_FILTERS; ++i) {
     filters[i]->updateForBlock();
   }
+  for (int i = 0; i < NUM_PERLIN_GENS; ++i) {
+    perlins[i]->copyParams(state->audioData.perlinGens[i]);
+  }
 }
 
-void ElectrumVoice::updateGraphData(GraphingData* gd) {
+void ElectrumVoice::writeTelemetry(telemetry_snapshot_t& snap) const {
   // oscillators
   for (int i = 0; i < NUM_OSCILLATORS; ++i) {
-    const float latestPos = std::clamp(
+    snap.oscPositions[i] = std::clamp(
         state->audioData.wOsc[i].getPos() + oscModState[i].posMod, 0.0f, 1.0f);
-    gd->updateOscPos(i, latestPos);
   }
   // envelopes
   for (int i = 0; i < NUM_ENVELOPES; ++i) {
-    gd->updateEnvLevel(i, envs[i]->getCurrentSample());
+    snap.envLevels[i] = envs[i]->getCurrentSample();
   }
   // LFOs
   for (int i = 0; i < NUM_LFOS; ++i) {
-    gd->updateLFOPhase(i, lfos[i]->getCurrentPhase());
-  }
-  // mod dests
-  for (int i = 0; i < MOD_DESTS; ++i) {
-    gd->updateModulationDest(
-        i, _normalizedModulationForDest(&state->modulations, i));
-  }
-  if (isBusy())
-    gd->setMonoLevel(rms.currentLevel());
-  else {
-    gd->setMonoLevel(0.0f);
+    snap.lfoPhases[i] = lfos[i]->getCurrentPhase();
   }
+  // mod dests, these were worked out at the last update
+  std::copy(modDestValues, modDestValues + MOD_DESTS, snap.modDestValues);
+  snap.monoLevel = isBusy() ? rms.currentLevel() : 0.0f;
 }
@@ -3,27 +3,25 @@
 #include "Electrum/Identifiers.h"
 #include "Electrum/Shared/CommonAudioData.h"
 
+namespace {
+// the SVF's state is smaller than the ladders'
+template <typename F>
+constexpr int stateSize() {
+  if constexpr (requires(F f) {
+                  { f.getCoeffs() } -> std::same_as<svf_coeffs_t*>;
+                })
+    return SVF_STATE_SIZE;
+  else
+    return LADDER_STATE_SIZE;
+}
+}  // namespace
+
 void VoiceFilter::prepareCutoff() {
   const float _cutoff = AudioUtil::signed_flerp(
       FILTER_CUTOFF_MIN, FILTER_CUTOFF_MAX, baseCutoff, modState.cutoffMod);
   if (!fequal(_cutoff, workingCutoff)) {
     workingCutoff = _cutoff;
-    switch (currentFilterType) {
-      case LadderLPLinear:
-        ladderBasic.setCutoffHz(workingCutoff);
-        break;
-      case LadderLPSaturated:
-        ladderLoPass.setCutoffHz(workingCutoff);
-        break;
-      case LadderHP:
-        ladderHP.setCutoffHz(workingCutoff);
-        break;
-      case LadderBP:
-        ladderBP.setCutoffHz(workingCutoff);
-        break;
-      default:
-        return;
-    }
+    std::visit([this](auto& f) { f.setCutoffHz(workingCutoff); }, filter);
   }
 }
 
@@ -32,22 +30,7 @@ void VoiceFilter::prepareResonance() {
                                              baseRes, modState.resMod);
   if (!fequal(_res, workingRes)) {
     workingRes = _res;
-    switch (currentFilterType) {
-      case LadderLPLinear:
-        ladderBasic.setResonance(workingRes);
-        break;
-      case LadderLPSaturated:
-        ladderLoPass.setResonance(workingRes);
-        break;
-      case LadderHP:
-        ladderHP.setResonance(workingRes);
-        break;
-      case LadderBP:
-        ladderBP.setResonance(workingRes);
-        break;
-      default:
-        return;
-    }
+    std::visit([this](auto& f) { f.setResonance(workingRes); }, filter);
   }
 }
 
@@ -63,33 +46,65 @@ void VoiceFilter::prepareGain() {
   }
 }
 
-float VoiceFilter::processChannel(float input, int channel) {
-  input *= workingGainLin;
-  float raw;
+void VoiceFilter::reinitForType() {
   switch (currentFilterType) {
     case LadderLPLinear:
-      raw = ladderBasic.processMono(input, channel);
+      filter.emplace<LadderLPBasic>();
       break;
     case LadderLPSaturated:
-      raw = ladderLoPass.processMono(input, channel);
+      filter.emplace<LadderLP>();
       break;
     case LadderHP:
-      raw = ladderHP.processMono(input, channel);
+      filter.emplace<LadderHighPass>();
       break;
     case LadderBP:
-      raw = ladderBP.processMono(input, channel);
+      filter.emplace<LadderBandPass>();
+      break;
+    case SVFLowPass:
+      filter.emplace<StateVariable<SVFLowPass>>();
+      break;
+    case SVFBandPass:
+      filter.emplace<StateVariable<SVFBandPass>>();
+      break;
+    case SVFHighPass:
+      filter.emplace<StateVariable<SVFHighPass>>();
+      break;
+    case SVFNotch:
+      filter.emplace<StateVariable<SVFNotch>>();
+      break;
+    case SVFPeak:
+      filter.emplace<StateVariable<SVFPeak>>();
+      break;
     default:
       break;
   }
-  return raw;
+  jassert(filter.index() == (size_t)currentFilterType);
+  std::visit([this](auto& f) { f.getCoeffs()->tables = prewarp; }, filter);
+  // the new filter starts out with its default settings
+  workingCutoff = -50000.0f;
+  workingRes = 500000.0f;
+  prepareCutoff();
+  prepareResonance();
+  std::visit(
+      [this](auto& f) {
+        if constexpr (requires { f.setOversampling(oversampling); })
+          f.setOversampling(oversampling);
+        // start on the right coefficients rather than ramping
+        // from zero
+        f.prepare();
+      },
+      filter);
 }
 
 //===================================================
-VoiceFilter::VoiceFilter(shared_filter_params* p) : params(p) {
-  ladderBasic.prepare(44100.0);
-  ladderLoPass.prepare(44100.0);
-  ladderHP.prepare(44100.0);
-  ladderBP.prepare(44100.0);
+VoiceFilter::VoiceFilter(shared_filter_params* p)
+    : params(p), prewarp(Prewarp::getTables(SampleRate::get())) {
+  std::visit(
+      [this](auto& f) {
+        f.getCoeffs()->tables = prewarp;
+        f.prepare();
+      },
+      filter);
   prepareCutoff();
   prepareResonance();
   prepareGain();
@@ -105,22 +120,36 @@ void VoiceFilter::updateForBlock() {
     prepareResonance();
   }
   if (!fequal(params->baseGainLin, baseGain)) {
-    baseGain = params->baseResLin;
+    baseGain = params->baseGainLin;
     prepareGain();
   }
   if (currentFilterType != params->filterType) {
     currentFilterType = params->filterType;
-    prepareCutoff();
-    prepareResonance();
+    reinitForType();
     prepareGain();
   }
 }
 
 void VoiceFilter::prepare(double sampleRate) {
-  ladderBasic.prepare(sampleRate);
-  ladderLoPass.prepare(sampleRate);
-  ladderHP.prepare(sampleRate);
-  ladderBP.prepare(sampleRate);
+  // switch to the tables for the new rate and look up the
+  // coefficients again
+  prewarp = Prewarp::getTables(sampleRate);
+  std::visit(
+      [this](auto& f) {
+        f.getCoeffs()->tables = prewarp;
+        f.prepare();
+      },
+      filter);
+}
+
+void VoiceFilter::setOversampling(OversamplingE rate) {
+  oversampling = rate;
+  std::visit(
+      [rate](auto& f) {
+        if constexpr (requires { f.setOversampling(rate); })
+          f.setOversampling(rate);
+      },
+      filter);
 }
 
 void VoiceFilter::setCutoffMod(float val) {
@@ -142,9 +171,39 @@ void VoiceFilter::setGainMod(float val) {
   }
 }
 
-void VoiceFilter::processStereo(float& left, float& right) {
-  if (!params->active)
-    return;
-  left = processChannel(left, 0);
-  right = processChannel(right, 1);
+void VoiceFilter::addToBatch(LadderBatch& ladders,
+                             SVFBatch& svfs,
+                             float* left,
+                             float* right) {
+  std::visit(
+      [&](auto& f) {
+        auto* coeffs = f.getCoeffs();
+        if constexpr (std::is_same_v<decltype(coeffs), svf_coeffs_t*>) {
+          svfs.addLane(left, f.getState(0), coeffs, workingGainLin);
+          svfs.addLane(right, f.getState(1), coeffs, workingGainLin);
+        } else {
+          ladders.addLane(left, f.getState(0), coeffs, workingGainLin);
+          ladders.addLane(right, f.getState(1), coeffs, workingGainLin);
+        }
+      },
+      filter);
+}
+
+bool VoiceFilter::flushIfSilent() {
+  return std::visit(
+      [](auto& f) {
+        constexpr int size = stateSize<std::decay_t<decltype(f)>>();
+        for (int ch = 0; ch < 2; ++ch) {
+          const float* z = f.getState(ch);
+          for (int i = 0; i < size; ++i) {
+            if (std::abs(z[i]) > FILTER_SILENT_LEVEL)
+              return false;
+          }
+        }
+        for (int ch = 0; ch < 2; ++ch) {
+          std::fill(f.getState(ch), f.getState(ch) + size, 0.0f);
+        }
+        return true;
+      },
+      filter);
 }
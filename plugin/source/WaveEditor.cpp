@@ -66,6 +66,10 @@ WaveEditor::WaveEditor(ElectrumState* s, Wavetable* wt, int idx)
   tabs.reset(new WaveViewerTabs(waveTree));
   addAndMakeVisible(*tabs);
   thumbBar->addListener(this);
+  // 8. previews go straight to the oscillator
+  resynth.onSetReady = [this](WaveSet::Ptr set) {
+    state->audioData.wOsc[oscID].loadWaveSet(set);
+  };
   frameWasFocused(0);
 }
 
@@ -85,23 +89,9 @@ void WaveEditor::previewEditsOnOscillator() {
   for (auto* w : watchers) {
     w->waveTreeUpdateRequested();
   }
-  //  2. add up the wave string for all the frames
-  String str = "";
-  for (auto it = waveTree.begin(); it != waveTree.end(); ++it) {
-    auto frame = *it;
-    jassert(frame.hasType(WaveEdit::WAVE_FRAME));
-    auto warp = frame.getChildWithName(WaveEdit::FFT_WARP);
-    String frameStr;
-    if (warp.isValid()) {
-      frameStr = warp[WaveEdit::warpedWaveStringData];
-      jassert(frameStr != "null");
-    } else {
-      frameStr = frame[WaveEdit::frameStringData];
-    }
-    str += frameStr;
-  }
-  // 3. re-load the oscillator with the new string
-  state->audioData.wOsc[oscID].loadWaveData(str);
+  // 2. rebuild whichever frames changed and load them
+  // into the oscillator once they're done
+  resynth.resynthesize(waveTree);
 }
 
 void WaveEditor::resized() {
@@ -3,53 +3,41 @@
 #include "Electrum/Audio/Wavetable.h"
 #include "Electrum/GUI/LookAndFeel/Color.h"
 #include "Electrum/GUI/LookAndFeel/Fonts.h"
-void WaveThumbnail::updateImage() {
-  // 1. parse the wave into numbers
-  float temp[TABLE_SIZE];
-  stringDecodeWave(waveString, temp);
-  img.clear(img.getBounds(), UIColor::windowBkgnd);
-  juce::Graphics g(img);
-  juce::Path p;
-  static const float y0 = (float)THUMBNAIL_H / 2.0f;
-  p.startNewSubPath(0.0f, y0);
-  float y = y0;
-
-  for (int i = 0; i < THUMBNAIL_W; ++i) {
-    float xNorm = (float)i / (float)THUMBNAIL_W;
-    int idx = (int)(xNorm * (float)TABLE_SIZE);
-    y = y0 + (y0 * temp[idx]);
-    p.lineTo((float)i, y);
-  }
-  juce::PathStrokeType pst(2.5f);
-  auto strokeColor =
-      drawSelected ? Color::periwinkle : Color::literalOrangePale;
-  g.setColour(strokeColor);
-  g.strokePath(p, pst);
-  auto rect = img.getBounds().toFloat();
-  auto outlineStroke = drawSelected ? 3.0f : 1.0f;
-  g.drawRect(rect, outlineStroke);
-}
-
-//===================================================
-WaveThumbnail::WaveThumbnail(const String& waveStr, int i)
-    : img(juce::Image::RGB, THUMBNAIL_W, THUMBNAIL_H, true),
-      waveString(waveStr),
-      frameIndex(i) {
-  aStr.setText(String(frameIndex + 1));
+
+#define THUMB_PX_W 70
+#define THUMB_PX_H 50
+
+WaveThumbnail::WaveThumbnail() {
   aStr.setFont(FontData::getFontWithHeight(FontE::RobotoMI, 12));
   aStr.setJustification(juce::Justification::centred);
-  updateImage();
+}
+
+void WaveThumbnail::setFrameIndex(int i) {
+  if (frameIndex != i) {
+    frameIndex = i;
+    aStr.setText(String(frameIndex + 1));
+    repaint();
+  }
+}
+
+bool WaveThumbnail::isSelected() const {
+  auto* parent = findParentComponentOfClass<WaveThumbnailBar>();
+  return parent != nullptr && parent->isFrameSelected(frameIndex);
 }
 
 void WaveThumbnail::paint(juce::Graphics& g) {
+  auto* parent = findParentComponentOfClass<WaveThumbnailBar>();
+  if (parent == nullptr || frameIndex < 0)
+    return;
   auto fBounds = getLocalBounds().toFloat();
   auto sBounds = fBounds.removeFromBottom(15.0f);
   juce::TextLayout layout;
-  auto col = drawSelected ? Color::periwinkle : Color::literalOrangePale;
+  auto col = parent->isFrameSelected(frameIndex) ? Color::periwinkle
+                                                 : Color::literalOrangePale;
   aStr.setColour(col);
   layout.createLayout(aStr, sBounds.getWidth());
   layout.draw(g, sBounds);
-  g.drawImage(img, fBounds.reduced(2.5f));
+  parent->drawFrame(g, fBounds.reduced(2.5f), frameIndex);
 }
 
 void WaveThumbnail::mouseDown(const juce::MouseEvent& e) {
@@ -57,7 +45,7 @@ void WaveThumbnail::mouseDown(const juce::MouseEvent& e) {
     leftWasDown = true;
     auto* parent = findParentComponentOfClass<WaveThumbnailBar>();
     jassert(parent != nullptr);
-    if (!e.mods.isCommandDown() && !e.mods.isShiftDown() && !drawSelected) {
+    if (!e.mods.isCommandDown() && !e.mods.isShiftDown() && !isSelected()) {
       parent->clearSelection();
     }
   } else {
@@ -83,7 +71,7 @@ void WaveThumbnail::mouseUp(const juce::MouseEvent& e) {
     leftWasDown = false;
     auto m = e.mods;
     if (m.isCommandDown()) {
-      if (drawSelected) {
+      if (isSelected()) {
         group->removeFromSelection(frameIndex);
       } else {
         group->addToSelection(frameIndex);
@@ -106,41 +94,75 @@ void WaveThumbnail::mouseEnter(const juce::MouseEvent& e) {
 
 //==========================================================
 
-WaveThumbnailBar::ThumbRow::ThumbRow(const String& fullStr) {
-  auto waveStrings = splitWaveStrings(fullStr);
-  // DLog::log("Table split into " + String(waveStrings.size()) + " waves");
-  for (int i = 0; i < waveStrings.size(); ++i) {
-    auto thumb = thumbnails.add(new WaveThumbnail(waveStrings[i], i));
-    addAndMakeVisible(thumb);
+void WaveThumbnailBar::ThumbRow::showFrames(int first, int last) {
+  // 1. make sure there's a thumbnail for every visible frame
+  const int needed = last - first;
+  while (thumbnails.size() < needed) {
+    addChildComponent(thumbnails.add(new WaveThumbnail()));
   }
-  jassert(thumbnails.size() > 0);
-}
-
-void WaveThumbnailBar::ThumbRow::resized() {
-  static const int height = 50;
-  static const int width = 70;
-  int x = 0;
+  // 2. each frame always gets the same thumbnail while it
+  // stays visible, so one that's being dragged on doesn't
+  // get recycled out from under the mouse
+  const int poolSize = thumbnails.size();
   for (auto* t : thumbnails) {
-    t->setBounds(x, 0, width, height);
-    x += width;
+    t->setVisible(false);
+  }
+  for (int f = first; f < last; ++f) {
+    auto* t = thumbnails[f % poolSize];
+    t->setFrameIndex(f);
+    t->setBounds(f * THUMB_PX_W, 0, THUMB_PX_W, THUMB_PX_H);
+    t->setVisible(true);
   }
-  setSize(x + width, height);
 }
 //------------------------------
 
-WaveThumbnailBar::WaveThumbnailBar(const String& fullStr) : row(fullStr) {
+WaveThumbnailBar::WaveThumbnailBar(const String& fullStr)
+    : waveStrings(splitWaveStrings(fullStr)), vpt(this) {
+  jassert(waveStrings.size() > 0);
+  // 1. hash each frame once up front for the cache
+  for (auto& str : waveStrings) {
+    waveHashes.push_back(ThumbnailCache::hashWave(str));
+  }
+  selected.resize((size_t)waveStrings.size(), false);
+  selected[0] = true;
+  numSelected = 1;
+  // 2. the row is as wide as every frame but only the visible
+  // ones get components
+  row.setSize((waveStrings.size() + 1) * THUMB_PX_W, THUMB_PX_H);
   vpt.setViewedComponent(&row, false);
   vpt.setViewPosition(0, 0);
   vpt.setInterceptsMouseClicks(true, true);
   addAndMakeVisible(vpt);
-  row.thumbnails[0]->setSelected(true);
-  row.resized();
+  cache->addListener(this);
+}
+
+WaveThumbnailBar::~WaveThumbnailBar() {
+  cache->removeListener(this);
 }
 
 void WaveThumbnailBar::resized() {
   vpt.setBounds(getLocalBounds());
 }
 
+void WaveThumbnailBar::updateVisibleFrames(const juce::Rectangle<int>& area) {
+  const int first = std::max(0, area.getX() / THUMB_PX_W);
+  const int last = std::min(numFrames(), (area.getRight() / THUMB_PX_W) + 1);
+  row.showFrames(first, std::max(first, last));
+}
+
+void WaveThumbnailBar::drawFrame(juce::Graphics& g, frect_t bounds, int idx) {
+  const size_t i = (size_t)idx;
+  if (!cache->draw(g, bounds, waveHashes[i], waveStrings[idx], selected[i])) {
+    g.setColour(UIColor::windowBkgnd);
+    g.fillRect(bounds);
+  }
+}
+
+void WaveThumbnailBar::setFrameSelected(int idx, bool sel) {
+  selected[(size_t)idx] = sel;
+  row.repaint();
+}
+
 void WaveThumbnailBar::focusFrame(int idx) {
   for (auto* l : tListeners) {
     l->frameWasFocused(idx);
@@ -149,17 +171,17 @@ void WaveThumbnailBar::focusFrame(int idx) {
 
 std::vector<int> WaveThumbnailBar::getSelection() const {
   std::vector<int> sel = {};
-  for (auto* t : row.thumbnails) {
-    if (t->isSelected()) {
-      sel.push_back(t->frameIndex);
+  for (size_t i = 0; i < selected.size(); ++i) {
+    if (selected[i]) {
+      sel.push_back((int)i);
     }
   }
   return sel;
 }
 
 void WaveThumbnailBar::selectOnly(int idx) {
-  for (int i = 0; i < row.thumbnails.size(); ++i) {
-    row.thumbnails[i]->setSelected(i == idx);
+  for (int i = 0; i < numFrames(); ++i) {
+    setFrameSelected(i, i == idx);
   }
   focusFrame(idx);
   numSelected = 1;
@@ -169,34 +191,34 @@ void WaveThumbnailBar::selectUntil(int idx) {
   int startIdx = 0;
   numSelected = 0;
   for (int i = 0; i < idx; ++i) {
-    if (row.thumbnails[i]->isSelected()) {
+    if (isFrameSelected(i)) {
       startIdx = i;
       ++numSelected;
     }
   }
-  for (int i = startIdx + 1; i < row.thumbnails.size(); ++i) {
+  for (int i = startIdx + 1; i < numFrames(); ++i) {
     if (i <= idx) {
-      row.thumbnails[i]->setSelected(true);
+      setFrameSelected(i, true);
       ++numSelected;
     } else {
-      row.thumbnails[i]->setSelected(false);
+      setFrameSelected(i, false);
     }
   }
 }
 
 void WaveThumbnailBar::addToSelection(int idx) {
-  row.thumbnails[idx]->setSelected(true);
+  setFrameSelected(idx, true);
   ++numSelected;
 }
 
 void WaveThumbnailBar::removeFromSelection(int idx) {
-  row.thumbnails[idx]->setSelected(false);
+  setFrameSelected(idx, false);
   --numSelected;
 }
 
 void WaveThumbnailBar::clearSelection() {
-  for (int i = 0; i < row.thumbnails.size(); ++i) {
-    row.thumbnails[i]->setSelected(false);
+  for (int i = 0; i < numFrames(); ++i) {
+    setFrameSelected(i, false);
   }
   numSelected = 0;
 }
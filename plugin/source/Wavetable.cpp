@@ -135,12 +135,14 @@ void randomizePhasesComplex(std::complex<float>* freqDomain,
   }
 }
 
+// one per thread since the FFT engines may keep scratch
+// space, and frames get band-limited on a pool of threads
 void forwardFFT(float* data) {
-  static FFTProc fft(WAVE_FFT_ORDER);
+  static thread_local FFTProc fft(WAVE_FFT_ORDER);
   fft.performRealOnlyForwardTransform(data);
 }
 void inverseFFT(float* data) {
-  static FFTProc fft(WAVE_FFT_ORDER);
+  static thread_local FFTProc fft(WAVE_FFT_ORDER);
   fft.performRealOnlyInverseTransform(data);
 }
 //
@@ -199,8 +201,12 @@ static std::array<String, 3> s_genDefaultStrings() {
   return out;
 }
 
-static std::array<String, 3> defaultTableStrings = s_genDefaultStrings();
 String getDefaultTableString(int idx) {
+  // only needed when the factory waves get written out, so
+  // these get built the first time that happens rather than
+  // when the library loads
+  static const std::array<String, 3> defaultTableStrings =
+      s_genDefaultStrings();
   auto i = (size_t)(idx % 3);
   return defaultTableStrings[i];
 }
@@ -392,34 +398,46 @@ float BandLimitedWave::getSample(float phase, float phaseDelt) const {
   return data[iWave].wave[iIdx];
 }
 
-String BandLimitedWave::toString() {
-  return stringEncodeWave(data[0].wave);
-}
 // generate the default waves for each of the three oscillators
+#define DEFAULT_RAMP_WAVES 18
+static std::array<float, TABLE_SIZE> s_defaultRamp(size_t t) {
+  const float width = std::max((float)t / (float)DEFAULT_RAMP_WAVES, 0.026f);
+  return getRampNormalized(width);
+}
 
 String Wavetable::getDefaultWavesetString() {
   String str = "";
-  constexpr size_t numWaves = 18;
-
-  for (size_t t = 0; t < numWaves; ++t) {
-    float width = std::max((float)t / (float)numWaves, 0.026f);
-    auto arr = getRampNormalized(width);
-
+  for (size_t t = 0; t < DEFAULT_RAMP_WAVES; ++t) {
+    auto arr = s_defaultRamp(t);
     str += stringEncodeWave(arr.data());
   }
   return str;
 }
 
-static void loadWavesetIntoArr(wave_set_t* arr, const String& input) {
-  if (!arr->isEmpty())
-    arr->clear();
+WaveSet::Ptr Wavetable::getDefaultWaveSet() {
+  // built the first time an oscillator needs it and then
+  // shared by every oscillator in the process. Band-limiting
+  // the ramps directly skips the trip through base64 that
+  // the string version takes
+  static const WaveSet::Ptr defaultSet = [] {
+    juce::ReferenceCountedArray<BandLimitedWave> waves;
+    for (size_t t = 0; t < DEFAULT_RAMP_WAVES; ++t) {
+      auto arr = s_defaultRamp(t);
+      waves.add(new BandLimitedWave(arr.data()));
+    }
+    return WaveSet::Ptr(new WaveSet(waves));
+  }();
+  return defaultSet;
+}
+
+WaveSet::WaveSet(const String& input) {
   String str = input;
   float tempWave[TABLE_SIZE];
   int endTokenPos = str.indexOf(waveEndToken);
   while (endTokenPos != -1 && str.length() > 0) {
     String waveStr = str.substring(0, endTokenPos);
     stringDecodeWave(waveStr, tempWave);
-    arr->add(new BandLimitedWave(tempWave));
+    waves.add(new BandLimitedWave(tempWave));
     // trim the string
     const int newStart = waveStr.length() + waveEndToken.length();
     str = str.substring(newStart);
@@ -427,46 +445,78 @@ static void loadWavesetIntoArr(wave_set_t* arr, const String& input) {
   }
 }
 
-//====================================================================
-String Wavetable::getDefaultSetString(int idx) {
-  juce::ignoreUnused(idx);
-  return getDefaultWavesetString();
-}
+WaveSet::WaveSet(const juce::ReferenceCountedArray<BandLimitedWave>& w)
+    : waves(w) {}
 
-static int numTablesCreated = 0;
+//====================================================================
 Wavetable::Wavetable() {
-  auto str = getDefaultSetString(numTablesCreated);
-  ++numTablesCreated;
-
-  loadWavesetIntoArr(pActive, str);
-  fSize = (float)(pActive->size() - 1);
-  // DLog::log("Initialized " + String(pActive->size()) + " wave shapes");
+  activeSet = getDefaultWaveSet();
+  // liveSet's own reference
+  activeSet->incReferenceCount();
+  liveSet.store(activeSet.get());
 }
 
-// this should be thread-safe because it loads
-// data into the array at the 'waiting' pointer
-// but the audio thread will only touch the 'active'
-// pointer
-void Wavetable::loadWaveData(const String& str) {
-  loadWavesetIntoArr(pWaiting, str);
+Wavetable::~Wavetable() {
+  cancelPendingUpdate();
+  WaveSet* set = nullptr;
+  while (retiredSets.pop(set)) {
+    set->decReferenceCount();
+  }
+  liveSet.load()->decReferenceCount();
+  if (auto* pending = pendingSet.exchange(nullptr))
+    pending->decReferenceCount();
+}
+
+void Wavetable::loadWaveSet(WaveSet::Ptr set) {
+  jassert(set != nullptr && set->size() > 0);
+  set->incReferenceCount();
+  // anything that was already waiting never made it to the
+  // audio thread so it can just go
+  if (auto* prev = pendingSet.exchange(set.get()))
+    prev->decReferenceCount();
+}
+
+bool Wavetable::commitWaveSet(WaveSet* set) {
+  jassert(set != nullptr && set->size() > 0);
+  if (set == liveSet.load(std::memory_order_relaxed))
+    return true;
+  // 1. make sure there's room to retire the current one
+  if (!retiredSets.push(liveSet.load(std::memory_order_relaxed)))
+    return false;
+  // 2. take our own reference and swap. This is the only
+  // thread that ever stores to liveSet
+  set->incReferenceCount();
+  liveSet.store(set, std::memory_order_release);
+  // 3. the message thread catches up the GUI's handle and
+  // lets go of the old set
+  triggerAsyncUpdate();
+  return true;
+}
+
+bool Wavetable::commitPendingSet() {
+  if (pendingSet.load(std::memory_order_acquire) == nullptr)
+    return false;
+  if (!retiredSets.push(liveSet.load(std::memory_order_relaxed)))
+    return false;
+  // the message thread may have replaced it since, but this
+  // is the only thread that empties the slot so it's still
+  // not null. Its reference just moves over to liveSet
+  WaveSet* set = pendingSet.exchange(nullptr);
+  liveSet.store(set, std::memory_order_release);
   triggerAsyncUpdate();
+  return true;
 }
 
-// and this is where we swap the pointers
-// for the audio thread
 void Wavetable::handleAsyncUpdate() {
-  wave_set_t* prevActive = pActive;
-  pActive = pWaiting;
-  pWaiting = prevActive;
-  fSize = (float)(pActive->size() - 1);
-}
-
-String Wavetable::toString() const noexcept {
-  String str = "";
-  for (int i = 0; i < pActive->size(); ++i) {
-    str += pActive->getUnchecked(i)->toString();
+  // 1. point the GUI at the live set. Anything the audio
+  // thread has retired since is still held by retiredSets
+  // so this can't catch one that's being released
+  activeSet = liveSet.load(std::memory_order_acquire);
+  // 2. release the sets the audio thread is done with
+  WaveSet* set = nullptr;
+  while (retiredSets.pop(set)) {
+    set->decReferenceCount();
   }
-  return str;
 }
 
 std::vector<float> Wavetable::normVectorForWave(int wave, int numPoints) const {
@@ -476,7 +526,7 @@ std::vector<float> Wavetable::normVectorForWave(int wave, int numPoints) const {
   float phase;
   for (int i = 0; i < numPoints; ++i) {
     phase = (float)i / (float)numPoints;
-    float x = pActive->getUnchecked(wave)->getSample(phase, freq);
+    float x = activeSet->getWave(wave)->getSample(phase, freq);
 
     const float value = (x + 1.0f) / 2.0f;
 
@@ -492,17 +542,22 @@ std::vector<float> Wavetable::normVectorForWave(int wave, int numPoints) const {
 }
 
 float Wavetable::getSampleFixed(float phase, float phaseDelt, float pos) const {
+  const WaveSet* set = liveSet.load(std::memory_order_acquire);
+  const float fSize = (float)(set->size() - 1);
   int idx = AudioUtil::fastFloor32(pos * fSize);
-  return pActive->getUnchecked(idx)->getSample(phase, phaseDelt);
+  return set->getWave(idx)->getSample(phase, phaseDelt);
 }
 
 float Wavetable::getSampleSmooth(float phase,
                                  float phaseDelt,
                                  float pos) const {
+  const WaveSet* set = liveSet.load(std::memory_order_acquire);
+  const float fSize = (float)(set->size() - 1);
   float temp = pos * fSize;
   const int lIdx = AudioUtil::fastFloor32(temp);
-  const int hIdx = lIdx + 1;
+  // pos can be all the way at 1
+  const int hIdx = std::min(lIdx + 1, set->size() - 1);
   temp -= (float)lIdx;
-  return flerp(pActive->getUnchecked(lIdx)->getSample(phase, phaseDelt),
-               pActive->getUnchecked(hIdx)->getSample(phase, phaseDelt), temp);
+  return flerp(set->getWave(lIdx)->getSample(phase, phaseDelt),
+               set->getWave(hIdx)->getSample(phase, phaseDelt), temp);
 }
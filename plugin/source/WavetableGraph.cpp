@@ -12,25 +12,41 @@
 
 // 3D math stuff---------------
 
+// Mat3x3's vector multiply just scales each axis by the sum
+// of its row, so this does the same thing for every vertex at
+// once in flat arrays that the compiler can vectorize
 static void projectToPoints(const wave_vertices_t& verts,
                             wave_points_t& points,
-                            Mat3x3 rotationMatrix) {
+                            const Mat3x3& rotationMatrix) {
   const float yHeight = 1.4f;
   vec3D_f c = {-0.5f, yHeight, 0.0f};         // represents the camera pinhole
   vec3D_f e = {0.0f, 0.0f, CAMERA_DISTANCE};  // represents
+  float scale[3];
+  for (int r = 0; r < 3; ++r) {
+    auto& row = rotationMatrix.data[r];
+    scale[r] = row[0] + row[1] + row[2];
+  }
+  float xs[WAVE_PATH_POINTS];
+  float ys[WAVE_PATH_POINTS];
+  float zs[WAVE_PATH_POINTS];
+  for (size_t i = 0; i < WAVE_PATH_POINTS; ++i) {
+    xs[i] = (verts[i].x - c.x) * scale[0];
+    ys[i] = (verts[i].y - c.y) * scale[1];
+    zs[i] = (verts[i].z - c.z) * scale[2];
+  }
+  // now convert to the 2d plane
+  for (size_t i = 0; i < WAVE_PATH_POINTS; ++i) {
+    const float perspective = e.z / zs[i];
+    xs[i] = ((perspective * xs[i]) + e.x) * (float)GRAPH_W;
+    ys[i] = ((perspective * ys[i]) + e.y) * (float)GRAPH_H;
+  }
   for (size_t i = 0; i < WAVE_PATH_POINTS; ++i) {
-    auto d = verts[i] - c;
-    // multiply by the rotation matrix
-    d = rotationMatrix * d;
-    // now convert to the 2d plane
-    float xPos = ((e.z / d.z) * d.x) + e.x;
-    float yPos = ((e.z / d.z) * d.y) + e.y;
-    points[i] = {xPos * (float)GRAPH_W, yPos * (float)GRAPH_H};
+    points[i] = {xs[i], ys[i]};
   }
 }
 
 static void loadVertsForWave(wave_vertices_t& dest,
-                             float* waveData,
+                             const float* waveData,
                              float zPos) {
   dest[0] = {0.0f, 0.0f, zPos};
   for (size_t i = 0; i < WAVE_GRAPH_POINTS; ++i) {
@@ -61,17 +77,16 @@ vec3D_f WavetableGraph::vertexLerp(const vec3D_f& a,
   return {x, y, z};
 }
 
-void WavetableGraph::updateVertices(const String& waveStr) {
+void WavetableGraph::updateVertices(const WaveSet& waves) {
+  stackLayerStep = -1;
   waveVertArrays.clear();
   wavePaths.clear();
-  auto waves = splitWaveStrings(waveStr);
-  float waveBuf[TABLE_SIZE];
   float zPos;
   minVertexY = 1000.0f;
   for (int i = 0; i < waves.size(); ++i) {
     zPos = ((float)i / (float)waves.size()) + Z_SETBACK;
-    // 1. decode string into waveBuf
-    stringDecodeWave(waves[i], waveBuf);
+    // 1. grab the wave straight from the shared table
+    const float* waveBuf = waves.getWave(i)->getFullBandWave();
     // 2. convert into vertices
     wave_vertices_t verts;
     loadVertsForWave(verts, waveBuf, zPos);
@@ -164,14 +179,11 @@ void WavetableGraph::redrawBitmap() {
 void WavetableGraph::redrawBitmapMulti() {
   imgA.clear(imgA.getBounds(), Color::nearBlack);
   juce::Graphics g(imgA);
-  wave_points_t pathPoints;
-  wave_points_t virtualPoints;
   const size_t virtualIdx = AudioUtil::fastFloor64(
       currentWavePos * (float)(waveVertArrays.size() - 1));
   for (size_t i = 0; i < waveVertArrays.size(); ++i) {
-    // 1. project to 2d points
+    // 1. find the depth
     float zPos = waveVertArrays[i][0].z;
-    projectToPoints(waveVertArrays[i], pathPoints, rotationMatrix);
     // 2. set color and stroke width
     auto color = _getWaveColor(zPos - Z_SETBACK, currentWavePos);
     auto stroke = _getStrokeWidth(zPos);
@@ -182,7 +194,6 @@ void WavetableGraph::redrawBitmapMulti() {
     // 4. check if it's time to draw the virtual wave
     if (i == virtualIdx) {
       zPos = virtualVerts[0].z;
-      projectToPoints(virtualVerts, virtualPoints, rotationMatrix);
       g.setColour(Color::qualifierPurple);
       stroke = _getStrokeWidth(zPos) * 1.035f;
       juce::PathStrokeType vPst(stroke);
@@ -191,35 +202,35 @@ void WavetableGraph::redrawBitmapMulti() {
   }
 }
 
-void WavetableGraph::redrawBitmapMulti(juce::Image* img) {
-  img->clear(img->getBounds(), Color::nearBlack);
-  juce::Graphics g(*img);
-  wave_points_t pathPoints;
-  wave_points_t virtualPoints;
-  const size_t virtualIdx = AudioUtil::fastFloor64(
-      currentWavePos * (float)(waveVertArrays.size() - 1));
+void WavetableGraph::redrawStackLayer(int colorStep) {
+  stackLayerStep = colorStep;
+  const float highlightPos =
+      (float)colorStep / (float)(WAVE_LAYER_COLOR_STEPS - 1);
+  stackLayer.clear(stackLayer.getBounds(), Color::nearBlack);
+  juce::Graphics g(stackLayer);
   for (size_t i = 0; i < waveVertArrays.size(); ++i) {
-    // 1. project to 2d points
-    float zPos = waveVertArrays[i][0].z;
-    projectToPoints(waveVertArrays[i], pathPoints, rotationMatrix);
-    // 2. set color and stroke width
-    auto color = _getWaveColor(zPos - Z_SETBACK, currentWavePos);
-    auto stroke = _getStrokeWidth(zPos);
-    g.setColour(color);
-    // 3. draw the wave
-    juce::PathStrokeType pst(stroke);
+    const float zPos = waveVertArrays[i][0].z;
+    g.setColour(_getWaveColor(zPos - Z_SETBACK, highlightPos));
+    juce::PathStrokeType pst(_getStrokeWidth(zPos));
     g.strokePath(wavePaths[i], pst);
-    // 4. check if it's time to draw the virtual wave
-    if (i == virtualIdx) {
-      zPos = virtualVerts[0].z;
-      projectToPoints(virtualVerts, virtualPoints, rotationMatrix);
-      g.setColour(Color::qualifierPurple);
-      stroke = _getStrokeWidth(zPos) * 1.035f;
-      juce::PathStrokeType vPst(stroke);
-      g.strokePath(virtualWavePath, vPst);
-    }
   }
 }
+
+void WavetableGraph::redrawBitmapMulti(juce::Image* img) {
+  // 1. make sure the stack is drawn for this position
+  const int colorStep = juce::roundToInt(
+      currentWavePos * (float)(WAVE_LAYER_COLOR_STEPS - 1));
+  if (colorStep != stackLayerStep) {
+    redrawStackLayer(colorStep);
+  }
+  // 2. copy it and draw the virtual wave on top
+  juce::Graphics g(*img);
+  g.drawImageAt(stackLayer, 0, 0);
+  g.setColour(Color::qualifierPurple);
+  const float stroke = _getStrokeWidth(virtualVerts[0].z) * 1.035f;
+  juce::PathStrokeType vPst(stroke);
+  g.strokePath(virtualWavePath, vPst);
+}
 void WavetableGraph::redrawBitmapSingle() {
   imgA.clear(imgA.getBounds(), Color::nearBlack);
   juce::Graphics g(imgA);
@@ -264,28 +275,23 @@ WavetableGraph::WavetableGraph(ElectrumState* s, int osc)
     : state(s),
       imgA(juce::Image::RGB, GRAPH_W, GRAPH_H, true),
       imgB(juce::Image::RGB, GRAPH_W, GRAPH_H, true),
+      stackLayer(juce::Image::RGB, GRAPH_W, GRAPH_H, true),
       oscID(osc) {
   // 1. initialize our vertices
-  if (!state->graph.needsWavetableData()) {
-    auto str = state->graph.getWavetableString(oscID);
-    updateVertices(str);
-    updateVirtualVertices();
-    wavesReady = true;
-  }
+  shownSet = state->audioData.wOsc[oscID].getWaveSet();
+  updateVertices(*shownSet);
+  updateVirtualVertices();
+  wavesReady = true;
   // 2. calculate the rotation matrix
   const float xAngle = juce::MathConstants<float>::pi * 1.0f;
   const float yAngle = juce::MathConstants<float>::pi * -0.6f;
   const float zAngle = juce::MathConstants<float>::pi * -0.35f;
   rotationMatrix = Mat3x3::getRotationMatrix(xAngle, yAngle, zAngle);
-  // 3. attach the GraphingData::Listener
-  state->graph.addListener(this);
-  // 4. start the timer
+  // 3. start the timer
   startTimerHz(GRAPH_REFRESH_HZ);
 }
 
-WavetableGraph::~WavetableGraph() {
-  state->graph.removeListener(this);
-}
+WavetableGraph::~WavetableGraph() {}
 
 void WavetableGraph::mouseUp(const juce::MouseEvent& me) {
   if (me.mouseWasClicked()) {
@@ -306,8 +312,8 @@ void WavetableGraph::enablementChanged() {
 void WavetableGraph::handleAsyncUpdate() {
   // 1. compute the vertices/paths
   if (!wavesReady) {
-    auto str = state->graph.getWavetableString(oscID);
-    updateVertices(str);
+    shownSet = state->audioData.wOsc[oscID].getWaveSet();
+    updateVertices(*shownSet);
     updateVirtualVertices();
     wavesReady = true;
   } else {
@@ -324,14 +330,16 @@ void WavetableGraph::handleAsyncUpdate() {
 }
 
 void WavetableGraph::timerCallback() {
-  if (wavesReady) {
+  // a different handle means the table has been swapped
+  if (state->audioData.wOsc[oscID].getWaveSet() != shownSet) {
+    wavesReady = false;
+    triggerAsyncUpdate();
+  } else if (wavesReady) {
     auto _pos = state->graph.getOscPos(oscID);
     if (!fequal(_pos, currentWavePos)) {
       currentWavePos = _pos;
       triggerAsyncUpdate();
     }
-  } else if (!state->graph.needsWavetableData()) {
-    triggerAsyncUpdate();
   }
 }
 
@@ -0,0 +1,106 @@
+#include "OfflineRenderer.h"
+#include <iostream>
+
+using namespace electrum_render;
+
+static void printUsage() {
+  std::cout
+      << "Usage: ElectrumRender [options] file.mid [more.mid ...]\n"
+         "  --patch=<file>      the .epf patch to use, or the default one\n"
+         "  --out=<folder>      where the WAV files go, the current folder\n"
+         "                      by default\n"
+         "  --rate=<hz>         sample rate, 44100 by default\n"
+         "  --block=<samples>   block size, 512 by default\n"
+         "  --tail=<seconds>    time after the last event, 2 by default\n"
+         "  --bits=<16|24|32>   WAV bit depth, 24 by default\n"
+         "  --offline           render at offline quality\n"
+         "  --split-tracks      render each track to its own file\n"
+         "  --threads=<n>       files or tracks to render at once\n"
+      << std::endl;
+}
+
+int main(int argc, char* argv[]) {
+  juce::ArgumentList args(argc, argv);
+  if (args.size() == 0 || args.containsOption("--help|-h")) {
+    printUsage();
+    return 0;
+  }
+  // the processors need a message manager like they'd get in
+  // a host
+  juce::ScopedJuceInitialiser_GUI juceInit;
+  // 1. settings
+  render_settings_t settings;
+  if (args.containsOption("--patch")) {
+    settings.patch = args.getFileForOption("--patch");
+    if (!settings.patch.existsAsFile()) {
+      std::cerr << "No patch at " << settings.patch.getFullPathName()
+                << std::endl;
+      return 1;
+    }
+  }
+  if (args.containsOption("--rate"))
+    settings.sampleRate = args.getValueForOption("--rate").getDoubleValue();
+  if (args.containsOption("--block"))
+    settings.blockSize = args.getValueForOption("--block").getIntValue();
+  if (args.containsOption("--tail"))
+    settings.tailSeconds = args.getValueForOption("--tail").getDoubleValue();
+  if (args.containsOption("--bits"))
+    settings.bitDepth = args.getValueForOption("--bits").getIntValue();
+  settings.offlineQuality = args.containsOption("--offline");
+  settings.numThreads = juce::SystemStats::getNumCpus();
+  if (args.containsOption("--threads"))
+    settings.numThreads = args.getValueForOption("--threads").getIntValue();
+  if (settings.sampleRate <= 0.0 || settings.blockSize <= 0 ||
+      settings.numThreads <= 0 || settings.tailSeconds < 0.0) {
+    std::cerr << "Bad rate, block size, tail or thread count" << std::endl;
+    return 1;
+  }
+  File outputFolder = File::getCurrentWorkingDirectory();
+  if (args.containsOption("--out"))
+    outputFolder = args.getFileForOption("--out");
+  if (outputFolder.createDirectory().failed()) {
+    std::cerr << "Could not create " << outputFolder.getFullPathName()
+              << std::endl;
+    return 1;
+  }
+  // 2. options all take their values as --option=value, so
+  // anything that isn't an option has to be a MIDI file
+  std::vector<render_job_t> jobs;
+  const bool splitTracks = args.containsOption("--split-tracks");
+  for (auto& arg : args.arguments) {
+    if (arg.isOption())
+      continue;
+    const bool isMidi = arg.text.endsWithIgnoreCase(".mid") ||
+                        arg.text.endsWithIgnoreCase(".midi");
+    if (!isMidi) {
+      std::cerr << "Unknown argument " << arg.text
+                << ", expected a .mid or .midi file" << std::endl;
+      return 1;
+    }
+    if (!addJobsForMidiFile(arg.resolveAsFile(), outputFolder, splitTracks,
+                            jobs)) {
+      return 1;
+    }
+  }
+  if (jobs.empty()) {
+    std::cerr << "Nothing to render" << std::endl;
+    return 1;
+  }
+  // 3. render on the session's thread while this one runs
+  // the message loop
+  RenderSession session(settings, jobs);
+  session.startThread();
+  juce::MessageManager::getInstance()->runDispatchLoop();
+  session.stopThread(-1);
+  // 4. report how it went, one line per job so CI can keep
+  // track of the speed
+  for (auto& job : jobs) {
+    if (!job.succeeded)
+      continue;
+    std::cout << job.output.getFileName() << ": " << job.audioSeconds
+              << " s of audio in " << job.renderSeconds << " s ("
+              << job.audioSeconds / job.renderSeconds << "x realtime)"
+              << std::endl;
+  }
+  return session.succeeded() ? 0 : 1;
+}
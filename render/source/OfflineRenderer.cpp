@@ -0,0 +1,243 @@
+#include "OfflineRenderer.h"
+#include <chrono>
+#include <iostream>
+
+namespace electrum_render {
+
+bool addJobsForMidiFile(const File& midiFile,
+                        const File& outputFolder,
+                        bool splitTracks,
+                        std::vector<render_job_t>& jobs) {
+  // 1. read the file
+  juce::FileInputStream stream(midiFile);
+  juce::MidiFile midi;
+  if (!stream.openedOk() || !midi.readFrom(stream)) {
+    std::cerr << "Could not read MIDI file "
+              << midiFile.getFullPathName() << std::endl;
+    return false;
+  }
+  midi.convertTimestampTicksToSeconds();
+  // 2. the tempo only matters for tempo synced modulation,
+  // so the first one will do
+  double bpm = 120.0;
+  juce::MidiMessageSequence tempos;
+  midi.findAllTempoEvents(tempos);
+  if (tempos.getNumEvents() > 0) {
+    const double spq =
+        tempos.getEventPointer(0)->message.getTempoSecondsPerQuarterNote();
+    if (spq > 0.0)
+      bpm = 60.0 / spq;
+  }
+  // 3. make the jobs
+  const String stem = midiFile.getFileNameWithoutExtension();
+  auto hasNotes = [](const juce::MidiMessageSequence& seq) {
+    for (int i = 0; i < seq.getNumEvents(); ++i) {
+      if (seq.getEventPointer(i)->message.isNoteOn())
+        return true;
+    }
+    return false;
+  };
+  if (splitTracks) {
+    for (int t = 0; t < midi.getNumTracks(); ++t) {
+      auto* track = midi.getTrack(t);
+      if (!hasNotes(*track))
+        continue;
+      render_job_t job;
+      job.name = stem + " track " + String(t);
+      job.sequence = *track;
+      job.bpm = bpm;
+      job.output = outputFolder.getChildFile(stem + "_track" + String(t) +
+                                             ".wav");
+      jobs.push_back(job);
+    }
+    return true;
+  }
+  render_job_t job;
+  job.name = stem;
+  for (int t = 0; t < midi.getNumTracks(); ++t) {
+    job.sequence.addSequence(*midi.getTrack(t), 0.0);
+  }
+  job.sequence.updateMatchedPairs();
+  job.bpm = bpm;
+  job.output = outputFolder.getChildFile(stem + ".wav");
+  jobs.push_back(job);
+  return true;
+}
+
+//===================================================
+
+class RenderSession::RenderJob : public juce::ThreadPoolJob {
+private:
+  render_job_t& job;
+  ElectrumAudioProcessor& processor;
+  const render_settings_t& settings;
+
+public:
+  RenderJob(render_job_t& j,
+            ElectrumAudioProcessor& p,
+            const render_settings_t& s)
+      : juce::ThreadPoolJob("RenderJob"),
+        job(j),
+        processor(p),
+        settings(s) {}
+  JobStatus runJob() override {
+    RenderSession::render(job, processor, settings);
+    return jobHasFinished;
+  }
+};
+
+RenderSession::RenderSession(const render_settings_t& s,
+                             std::vector<render_job_t>& j)
+    : juce::Thread("RenderSession"),
+      settings(s),
+      jobs(j),
+      pool(juce::ThreadPoolOptions{}
+               .withThreadName("Render")
+               .withNumberOfThreads(std::max(1, s.numThreads))) {}
+
+RenderSession::~RenderSession() {
+  stopThread(5000);
+  pool.removeAllJobs(true, 5000);
+}
+
+void RenderSession::run() {
+  bool ok = true;
+  const size_t batchSize = (size_t)std::max(1, settings.numThreads);
+  for (size_t first = 0; first < jobs.size() && ok; first += batchSize) {
+    const size_t last = std::min(jobs.size(), first + batchSize);
+    // 1. set up a processor for each job in the batch
+    std::vector<std::unique_ptr<render_instance_t>> instances;
+    for (size_t i = first; i < last && ok; ++i) {
+      auto instance = createInstance(jobs[i]);
+      ok = instance != nullptr;
+      instances.push_back(std::move(instance));
+    }
+    // 2. render them all at once
+    if (ok) {
+      for (size_t i = first; i < last; ++i) {
+        pool.addJob(new RenderJob(jobs[i], *instances[i - first]->processor,
+                                  settings),
+                    true);
+      }
+      while (pool.getNumJobs() > 0 && !threadShouldExit()) {
+        wait(RENDER_POLL_MS);
+      }
+    }
+    // 3. and tear them down the way a host would
+    {
+      const juce::MessageManagerLock mml;
+      instances.clear();
+    }
+    if (threadShouldExit())
+      ok = false;
+  }
+  for (auto& job : jobs) {
+    ok = ok && job.succeeded;
+  }
+  allSucceeded.store(ok);
+  juce::MessageManager::getInstance()->stopDispatchLoop();
+}
+
+std::unique_ptr<RenderSession::render_instance_t>
+RenderSession::createInstance(const render_job_t& job) {
+  auto instance = std::make_unique<render_instance_t>();
+  instance->playHead.bpm = job.bpm;
+  {
+    const juce::MessageManagerLock mml;
+    instance->processor = std::make_unique<ElectrumAudioProcessor>();
+  }
+  auto& proc = *instance->processor;
+  // 1. patches point at waves by their index in the library,
+  // which isn't settled until the scan is done
+  while (proc.tree.userLib.isScanning() && !threadShouldExit()) {
+    wait(RENDER_POLL_MS);
+  }
+  {
+    const juce::MessageManagerLock mml;
+    // 2. load the patch
+    if (settings.patch != File() &&
+        !proc.tree.patchLoader.loadPatchNow(settings.patch)) {
+      std::cerr << "Could not load patch "
+                << settings.patch.getFullPathName() << std::endl;
+      return nullptr;
+    }
+    // 3. get it ready to play
+    proc.setNonRealtime(settings.offlineQuality);
+    proc.setPlayHead(&instance->playHead);
+    proc.prepareToPlay(settings.sampleRate, settings.blockSize);
+    // 4. a silent block picks up the tempo and kicks off
+    // anything that gets built on the message thread
+    juce::AudioBuffer<float> buffer(2, settings.blockSize);
+    buffer.clear();
+    juce::MidiBuffer midi;
+    proc.processBlock(buffer, midi);
+    // 5. which we build now, so the first note always plays
+    // with the patch's envelopes and LFO shapes
+    proc.tree.flushAsyncUpdates();
+  }
+  return instance;
+}
+
+void RenderSession::render(render_job_t& job,
+                           ElectrumAudioProcessor& processor,
+                           const render_settings_t& settings) {
+  const auto start = std::chrono::steady_clock::now();
+  const double sampleRate = settings.sampleRate;
+  const int totalSamples = (int)std::ceil(
+      (job.sequence.getEndTime() + settings.tailSeconds) * sampleRate);
+  juce::AudioBuffer<float> output(2, totalSamples);
+  output.clear();
+  juce::MidiBuffer midi;
+  int nextEvent = 0;
+  for (int pos = 0; pos < totalSamples; pos += settings.blockSize) {
+    const int length = std::min(settings.blockSize, totalSamples - pos);
+    // 1. grab the events for this block
+    midi.clear();
+    while (nextEvent < job.sequence.getNumEvents()) {
+      auto& msg = job.sequence.getEventPointer(nextEvent)->message;
+      const int sample = juce::roundToInt(msg.getTimeStamp() * sampleRate);
+      if (sample >= pos + length)
+        break;
+      if (!msg.isMetaEvent())
+        midi.addEvent(msg, std::max(0, sample - pos));
+      ++nextEvent;
+    }
+    // 2. render straight into the output
+    juce::AudioBuffer<float> block(output.getArrayOfWritePointers(), 2, pos,
+                                   length);
+    processor.processBlock(block, midi);
+  }
+  std::chrono::duration<double> elapsed =
+      std::chrono::steady_clock::now() - start;
+  job.audioSeconds = (double)totalSamples / sampleRate;
+  job.renderSeconds = elapsed.count();
+  job.succeeded =
+      writeWav(job.output, output, sampleRate, settings.bitDepth);
+  if (!job.succeeded) {
+    std::cerr << "Could not write " << job.output.getFullPathName()
+              << std::endl;
+  }
+}
+
+bool RenderSession::writeWav(const File& file,
+                             const juce::AudioBuffer<float>& buffer,
+                             double sampleRate,
+                             int bitDepth) {
+  file.deleteFile();
+  auto stream = file.createOutputStream();
+  if (stream == nullptr)
+    return false;
+  juce::WavAudioFormat wav;
+  std::unique_ptr<juce::AudioFormatWriter> writer(
+      wav.createWriterFor(stream.get(), sampleRate,
+                          (unsigned int)buffer.getNumChannels(), bitDepth,
+                          {}, 0));
+  if (writer == nullptr)
+    return false;
+  // the writer owns it now
+  stream.release();
+  return writer->writeFromAudioSampleBuffer(buffer, 0,
+                                            buffer.getNumSamples());
+}
+
+}  // namespace electrum_render
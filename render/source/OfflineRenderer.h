@@ -0,0 +1,89 @@
+#pragma once
+#include <Electrum/PluginProcessor.h>
+#include <Electrum/Shared/FixedPlayHead.h>
+#include <juce_audio_formats/juce_audio_formats.h>
+
+namespace electrum_render {
+
+using audio_plugin::ElectrumAudioProcessor;
+
+// how often to check on the library scan and the jobs
+#define RENDER_POLL_MS 10
+
+struct render_settings_t {
+  // left empty for the default patch
+  File patch;
+  double sampleRate = 44100.0;
+  int blockSize = 512;
+  // the same thing a host gets when it bounces: offline
+  // oversampling, blended wave frames and per sample
+  // modulation
+  bool offlineQuality = false;
+  // how long to keep going after the last MIDI event so the
+  // releases ring out
+  double tailSeconds = 2.0;
+  int bitDepth = 24;
+  int numThreads = 1;
+};
+
+// one MIDI sequence to one WAV file
+struct render_job_t {
+  String name;
+  // timestamps in seconds
+  juce::MidiMessageSequence sequence;
+  double bpm = 120.0;
+  File output;
+  // filled in once it's done
+  double audioSeconds = 0.0;
+  double renderSeconds = 0.0;
+  bool succeeded = false;
+};
+
+// adds a job for the whole file, or one for each track that
+// has notes in it if splitTracks. False if the file
+// couldn't be read
+bool addJobsForMidiFile(const File& midiFile,
+                        const File& outputFolder,
+                        bool splitTracks,
+                        std::vector<render_job_t>& jobs);
+
+/* Renders a batch of jobs, each with its own
+ * ElectrumAudioProcessor, as fast as the machine allows.
+ * Runs on its own thread so the main thread is free to run
+ * the message loop, which the processors still need for the
+ * things they build asynchronously. Each batch of processors
+ * gets set up with the message manager locked, like a host
+ * would on its message thread, and then they all render at
+ * once on the pool. Calls stopDispatchLoop() when it's done.
+ * */
+class RenderSession : public juce::Thread {
+public:
+  RenderSession(const render_settings_t& s, std::vector<render_job_t>& j);
+  ~RenderSession() override;
+  // whether every job got rendered and written
+  bool succeeded() const { return allSucceeded.load(); }
+
+private:
+  class RenderJob;
+  struct render_instance_t {
+    fixed_play_head_t playHead;
+    std::unique_ptr<ElectrumAudioProcessor> processor;
+  };
+  const render_settings_t settings;
+  std::vector<render_job_t>& jobs;
+  std::atomic<bool> allSucceeded{false};
+  juce::ThreadPool pool;
+
+  void run() override;
+  // null if the patch couldn't be loaded
+  std::unique_ptr<render_instance_t> createInstance(const render_job_t& job);
+  static void render(render_job_t& job,
+                     ElectrumAudioProcessor& processor,
+                     const render_settings_t& settings);
+  static bool writeWav(const File& file,
+                       const juce::AudioBuffer<float>& buffer,
+                       double sampleRate,
+                       int bitDepth);
+};
+
+}  // namespace electrum_render
@@ -0,0 +1,158 @@
+#include <Electrum/Audio/Filters/LadderSIMD.h>
+#include <Electrum/Audio/Filters/SVFSIMD.h>
+#include <Electrum/Audio/Filters/VoiceFilter.h>
+#include "TestHelpers.h"
+
+#include <gtest/gtest.h>
+#include <chrono>
+#include <iostream>
+#include <random>
+#include <vector>
+
+namespace audio_plugin_benchmark {
+
+using audio_plugin_test::filterNames;
+using audio_plugin_test::rateNames;
+using audio_plugin_test::setupLane;
+using audio_plugin_test::test_lane_t;
+
+static const char* saturationNames[] = {"std::tanh", "Pade", "Poly",
+                                        "Poly ADAA"};
+
+// enough lanes for every voice in stereo
+#define BENCH_LANES 48
+
+// returns the average time it took to process one sample
+// for one voice-channel in nanoseconds
+static double nsPerSample(FilterTypeE type,
+                          SaturationModeE mode,
+                          OversamplingE rate = OversampleOff) {
+  constexpr int numBlocks = (int)TEST_SAMPLE_RATE / MAX_VOICE_BLOCK;
+  std::vector<test_lane_t> lanes(BENCH_LANES);
+  for (int l = 0; l < BENCH_LANES; ++l) {
+    setupLane(lanes[(size_t)l], 200.0f + (150.0f * (float)l), 3.0f, rate);
+  }
+  std::mt19937 rng(0);
+  std::uniform_real_distribution<float> noise(-1.0f, 1.0f);
+  LadderBatch batch;
+  batch.setSaturationMode(mode);
+  std::chrono::nanoseconds elapsed(0);
+  for (int b = 0; b < numBlocks; ++b) {
+    batch.clear();
+    for (auto& lane : lanes) {
+      for (auto& s : lane.buffer)
+        s = noise(rng);
+      batch.addLane(lane.buffer, lane.state, &lane.coeffs, 1.0f);
+    }
+    const auto start = std::chrono::steady_clock::now();
+    batch.process(type, MAX_VOICE_BLOCK);
+    elapsed += std::chrono::steady_clock::now() - start;
+  }
+  const double samples = (double)numBlocks * MAX_VOICE_BLOCK * BENCH_LANES;
+  return (double)elapsed.count() / samples;
+}
+
+TEST(LadderSaturation, CPU) {
+  for (int t = LadderLPSaturated; t <= LadderBP; ++t) {
+    for (int m = TanhStd; m <= TanhPolyADAA; ++m) {
+      const double ns = nsPerSample((FilterTypeE)t, (SaturationModeE)m);
+      std::cout << filterNames[t] << ", " << saturationNames[m] << ": " << ns
+                << " ns/sample\n";
+    }
+  }
+}
+
+TEST(LadderOversampling, CPU) {
+  for (int t = LadderLPSaturated; t <= LadderBP; ++t) {
+    for (int r = OversampleOff; r <= Oversample4x; ++r) {
+      const double ns =
+          nsPerSample((FilterTypeE)t, TanhPoly, (OversamplingE)r);
+      std::cout << filterNames[t] << ", " << rateNames[r] << ": " << ns
+                << " ns/sample\n";
+    }
+  }
+}
+
+// every voice's filter going through the batches the way
+// the engine runs them
+TEST(VoiceFilter, CPU) {
+  constexpr int numVoices = BENCH_LANES / 2;
+  constexpr int numBlocks = (int)TEST_SAMPLE_RATE / MAX_VOICE_BLOCK;
+  std::mt19937 rng(0);
+  std::uniform_real_distribution<float> noise(-1.0f, 1.0f);
+  LadderBatch ladders;
+  SVFBatch svfs;
+  for (int t = LadderLPLinear; t <= SVFPeak; ++t) {
+    shared_filter_params params;
+    params.filterType = (FilterTypeE)t;
+    params.baseResLin = 0.3f;
+    juce::OwnedArray<VoiceFilter> filters;
+    for (int v = 0; v < numVoices; ++v) {
+      params.baseCutoff = 300.0f + (400.0f * (float)v);
+      filters.add(new VoiceFilter(&params));
+      filters.getLast()->updateForBlock();
+    }
+    std::vector<float> left((size_t)(numVoices * MAX_VOICE_BLOCK));
+    std::vector<float> right((size_t)(numVoices * MAX_VOICE_BLOCK));
+    std::chrono::nanoseconds elapsed(0);
+    for (int b = 0; b < numBlocks; ++b) {
+      ladders.clear();
+      svfs.clear();
+      for (int v = 0; v < numVoices; ++v) {
+        float* l = left.data() + (v * MAX_VOICE_BLOCK);
+        float* r = right.data() + (v * MAX_VOICE_BLOCK);
+        for (int i = 0; i < MAX_VOICE_BLOCK; ++i) {
+          l[i] = noise(rng);
+          r[i] = noise(rng);
+        }
+        filters[v]->addToBatch(ladders, svfs, l, r);
+      }
+      const auto start = std::chrono::steady_clock::now();
+      ladders.process((FilterTypeE)t, MAX_VOICE_BLOCK);
+      svfs.process((FilterTypeE)t, MAX_VOICE_BLOCK);
+      elapsed += std::chrono::steady_clock::now() - start;
+    }
+    const double ns = (double)elapsed.count() /
+                      ((double)numBlocks * MAX_VOICE_BLOCK * numVoices * 2);
+    std::cout << filterNames[t] << ", VoiceFilter: " << ns << " ns/sample\n";
+  }
+}
+
+TEST(SVF, CPU) {
+  constexpr int numBlocks = (int)TEST_SAMPLE_RATE / MAX_VOICE_BLOCK;
+  struct svf_bench_lane_t {
+    svf_coeffs_t coeffs;
+    float state[SVF_STATE_SIZE] = {};
+    float buffer[MAX_VOICE_BLOCK] = {};
+  };
+  std::mt19937 rng(0);
+  std::uniform_real_distribution<float> noise(-1.0f, 1.0f);
+  for (int t = SVFLowPass; t <= SVFPeak; ++t) {
+    std::vector<svf_bench_lane_t> lanes(BENCH_LANES);
+    for (int l = 0; l < BENCH_LANES; ++l) {
+      auto& c = lanes[(size_t)l].coeffs;
+      c.tables = Prewarp::getTables(TEST_SAMPLE_RATE);
+      c.setK(0.5f);
+      c.setCutoff(200.0f + (150.0f * (float)l));
+      c.snap();
+    }
+    SVFBatch batch;
+    std::chrono::nanoseconds elapsed(0);
+    for (int b = 0; b < numBlocks; ++b) {
+      batch.clear();
+      for (auto& lane : lanes) {
+        for (auto& s : lane.buffer)
+          s = noise(rng);
+        batch.addLane(lane.buffer, lane.state, &lane.coeffs, 1.0f);
+      }
+      const auto start = std::chrono::steady_clock::now();
+      batch.process((FilterTypeE)t, MAX_VOICE_BLOCK);
+      elapsed += std::chrono::steady_clock::now() - start;
+    }
+    const double ns = (double)elapsed.count() /
+                      ((double)numBlocks * MAX_VOICE_BLOCK * BENCH_LANES);
+    std::cout << filterNames[t] << ": " << ns << " ns/sample\n";
+  }
+}
+
+}  // namespace audio_plugin_benchmark
@@ -0,0 +1,30 @@
+#include <Electrum/Shared/PatchSearchIndex.h>
+#include "TestHelpers.h"
+
+#include <gtest/gtest.h>
+#include <chrono>
+#include <iostream>
+
+namespace audio_plugin_benchmark {
+
+using audio_plugin_test::buildIndex;
+using audio_plugin_test::makeLargeLibrary;
+
+// the browser searches on every keystroke, so this needs to
+// stay well inside a frame
+TEST(PatchSearchIndex, LargeLibraryCPU) {
+  auto patches = makeLargeLibrary();
+  PatchSearchIndex index;
+  buildIndex(index, patches);
+  const char* queries[] = {"s", "sq", "bright pl", "glsas", "author4"};
+  for (auto* q : queries) {
+    auto start = std::chrono::steady_clock::now();
+    auto results = index.search(q);
+    std::chrono::duration<double, std::milli> ms =
+        std::chrono::steady_clock::now() - start;
+    std::cout << "\"" << q << "\": " << results.size() << " results in "
+              << ms.count() << " ms" << std::endl;
+  }
+}
+
+}  // namespace audio_plugin_benchmark
@@ -0,0 +1,42 @@
+#include <Electrum/PluginProcessor.h>
+#include <Electrum/Shared/FixedPlayHead.h>
+
+#include <gtest/gtest.h>
+#include <chrono>
+#include <iostream>
+#include <memory>
+
+namespace audio_plugin_benchmark {
+
+using audio_plugin::ElectrumAudioProcessor;
+
+#define STARTUP_BENCH_ITERATIONS 10
+#define STARTUP_SAMPLE_RATE 44100.0
+#define STARTUP_BLOCK_SIZE 512
+
+TEST(PluginStartup, InstantiateToFirstBlock) {
+  fixed_play_head_t playHead;
+  juce::AudioBuffer<float> buffer(2, STARTUP_BLOCK_SIZE);
+  juce::MidiBuffer midi;
+  std::chrono::duration<double, std::milli> first(0.0);
+  std::chrono::duration<double, std::milli> total(0.0);
+  for (int i = 0; i < STARTUP_BENCH_ITERATIONS; ++i) {
+    buffer.clear();
+    auto start = std::chrono::steady_clock::now();
+    auto proc = std::make_unique<ElectrumAudioProcessor>();
+    proc->setPlayHead(&playHead);
+    proc->prepareToPlay(STARTUP_SAMPLE_RATE, STARTUP_BLOCK_SIZE);
+    proc->processBlock(buffer, midi);
+    std::chrono::duration<double, std::milli> elapsed =
+        std::chrono::steady_clock::now() - start;
+    // the first one pays for anything built once per process
+    if (i == 0)
+      first = elapsed;
+    total += elapsed;
+  }
+  std::cout << "instantiate to first block: first " << first.count()
+            << " ms, average " << total.count() / STARTUP_BENCH_ITERATIONS
+            << " ms" << std::endl;
+}
+
+}  // namespace audio_plugin_benchmark
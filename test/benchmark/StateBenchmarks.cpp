@@ -0,0 +1,56 @@
+#include <Electrum/PluginProcessor.h>
+#include <Electrum/Shared/StateFormat.h>
+#include "TestHelpers.h"
+
+#include <gtest/gtest.h>
+#include <chrono>
+#include <functional>
+#include <iostream>
+
+namespace audio_plugin_benchmark {
+
+using audio_plugin::ElectrumAudioProcessor;
+using audio_plugin_test::makeComplexPatch;
+using audio_plugin_test::TempLibraryTest;
+using audio_plugin_test::writeLegacyXml;
+
+#define STATE_BENCH_ITERATIONS 200
+
+typedef TempLibraryTest PluginState;
+
+TEST_F(PluginState, SaveRestoreCPU) {
+  ElectrumAudioProcessor proc;
+  makeComplexPatch(proc, 1);
+  typedef std::function<void(juce::MemoryBlock&)> writer_t;
+  const std::pair<const char*, writer_t> formats[] = {
+      {"XML", [&](juce::MemoryBlock& b) { writeLegacyXml(proc, b); }},
+      {"binary",
+       [&](juce::MemoryBlock& b) {
+         auto state = proc.tree.copyState();
+         proc.tree.addWaveRefs(state);
+         StateFormat::write(state, b, false);
+       }},
+      {"binary GZIP",
+       [&](juce::MemoryBlock& b) { proc.getStateInformation(b); }}};
+  for (auto& [name, write] : formats) {
+    juce::MemoryBlock block;
+    auto start = std::chrono::steady_clock::now();
+    for (int i = 0; i < STATE_BENCH_ITERATIONS; ++i) {
+      write(block);
+    }
+    std::chrono::duration<double, std::micro> saveTime =
+        std::chrono::steady_clock::now() - start;
+    start = std::chrono::steady_clock::now();
+    for (int i = 0; i < STATE_BENCH_ITERATIONS; ++i) {
+      proc.setStateInformation(block.getData(), (int)block.getSize());
+    }
+    std::chrono::duration<double, std::micro> loadTime =
+        std::chrono::steady_clock::now() - start;
+    std::cout << name << ": " << block.getSize() << " bytes, save "
+              << saveTime.count() / STATE_BENCH_ITERATIONS << " us, restore "
+              << loadTime.count() / STATE_BENCH_ITERATIONS << " us"
+              << std::endl;
+  }
+}
+
+}  // namespace audio_plugin_benchmark
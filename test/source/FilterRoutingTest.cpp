@@ -0,0 +1,113 @@
+#include <Electrum/Audio/Filters/VoiceFilter.h>
+#include <Electrum/Audio/Synth/FilterRouting.h>
+
+#include <gtest/gtest.h>
+#include <random>
+
+namespace audio_plugin_test {
+
+// the default patch: filter 1 on osc 1 and osc 2, osc 3
+// unrouted and filter 2 off
+static routing_params_t defaultRouting() {
+  routing_params_t p;
+  p.filterActive[0] = true;
+  for (int o = 0; o < NUM_OSCILLATORS; ++o) {
+    p.oscActive[o] = true;
+  }
+  p.oscToFilter[0][0] = true;
+  p.oscToFilter[1][0] = true;
+  return p;
+}
+
+TEST(FilterRouting, Plans) {
+  FilterRouter router;
+  // 1. parallel: filter 1 and dry go straight out
+  routing_params_t p = defaultRouting();
+  EXPECT_TRUE(router.update(p));
+  EXPECT_FALSE(router.update(p));
+  const routing_plan_t& plan = router.getPlan();
+  EXPECT_EQ(plan.numOscDests[0], 1);
+  EXPECT_EQ(plan.oscDests[0][0], 0);
+  EXPECT_EQ(plan.oscDests[2][0], ROUTING_DRY_BUFFER);
+  ASSERT_EQ(plan.numSteps, 1);
+  EXPECT_TRUE(plan.steps[0].process);
+  EXPECT_EQ(plan.steps[0].dest, ROUTING_OUTPUT);
+  EXPECT_EQ(plan.numOutputs, 2);
+  // 2. an oscillator on both filters goes into both buffers
+  p.filterActive[1] = true;
+  p.oscToFilter[1][1] = true;
+  EXPECT_TRUE(router.update(p));
+  EXPECT_EQ(plan.numOscDests[1], 2);
+  ASSERT_EQ(plan.numSteps, 2);
+  EXPECT_EQ(plan.numOutputs, 3);
+  // 3. serial: it only enters at filter 1, and filter 1
+  // feeds filter 2
+  p.mode = FilterSerial;
+  EXPECT_TRUE(router.update(p));
+  EXPECT_EQ(plan.numOscDests[1], 1);
+  ASSERT_EQ(plan.numSteps, 2);
+  EXPECT_EQ(plan.steps[0].dest, 1);
+  EXPECT_EQ(plan.steps[1].dest, ROUTING_OUTPUT);
+  EXPECT_EQ(plan.outputs[0], 1);
+  EXPECT_EQ(plan.outputs[1], ROUTING_DRY_BUFFER);
+  // 4. a bypassed filter still passes its input along
+  p.filterActive[0] = false;
+  EXPECT_TRUE(router.update(p));
+  ASSERT_EQ(plan.numSteps, 2);
+  EXPECT_FALSE(plan.steps[0].process);
+  EXPECT_EQ(plan.steps[0].dest, 1);
+  // 5. inactive oscillators have nowhere to go
+  p.oscActive[2] = false;
+  EXPECT_TRUE(router.update(p));
+  EXPECT_EQ(plan.numOscDests[2], 0);
+  EXPECT_EQ(plan.numOutputs, 1);
+}
+
+// every filter type should ring out after its input stops
+// and come back to exactly zero, so the engine can skip it
+TEST(VoiceFilter, FlushIfSilent) {
+  std::mt19937 rng(0);
+  std::uniform_real_distribution<float> noise(-1.0f, 1.0f);
+  LadderBatch ladders;
+  SVFBatch svfs;
+  for (int t = LadderLPLinear; t <= SVFPeak; ++t) {
+    shared_filter_params params;
+    params.filterType = (FilterTypeE)t;
+    params.baseResLin = 0.5f;
+    VoiceFilter filter(&params);
+    filter.updateForBlock();
+    float left[MAX_VOICE_BLOCK];
+    float right[MAX_VOICE_BLOCK];
+    // one block the way the engine runs it
+    auto process = [&]() {
+      ladders.clear();
+      svfs.clear();
+      filter.addToBatch(ladders, svfs, left, right);
+      ladders.process((FilterTypeE)t, MAX_VOICE_BLOCK);
+      svfs.process((FilterTypeE)t, MAX_VOICE_BLOCK);
+    };
+    for (int i = 0; i < MAX_VOICE_BLOCK; ++i) {
+      left[i] = noise(rng);
+      right[i] = noise(rng);
+    }
+    process();
+    EXPECT_FALSE(filter.flushIfSilent()) << "filter type " << t;
+    // a second of silence is plenty
+    int blocks = 0;
+    while (!filter.flushIfSilent() && blocks < 1000) {
+      std::fill(left, left + MAX_VOICE_BLOCK, 0.0f);
+      std::fill(right, right + MAX_VOICE_BLOCK, 0.0f);
+      process();
+      ++blocks;
+    }
+    EXPECT_LT(blocks, 1000) << "filter type " << t;
+    std::fill(left, left + MAX_VOICE_BLOCK, 0.0f);
+    std::fill(right, right + MAX_VOICE_BLOCK, 0.0f);
+    process();
+    for (int i = 0; i < MAX_VOICE_BLOCK; ++i) {
+      EXPECT_EQ(left[i], 0.0f) << "filter type " << t;
+    }
+  }
+}
+
+}  // namespace audio_plugin_test
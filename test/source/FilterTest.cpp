@@ -0,0 +1,402 @@
+#include <Electrum/Audio/Filters/LadderSIMD.h>
+#include <Electrum/Audio/Filters/Prewarp.h>
+#include <Electrum/Audio/Filters/SVFSIMD.h>
+#include <Electrum/Audio/Filters/VoiceFilter.h>
+#include "TestHelpers.h"
+
+#include <gtest/gtest.h>
+#include <random>
+#include <vector>
+
+namespace audio_plugin_test {
+
+TEST(Prewarp, Tables) {
+  // one set for each rate, and always the same one
+  auto* tables = Prewarp::getTables(TEST_SAMPLE_RATE);
+  EXPECT_EQ(Prewarp::getTables(TEST_SAMPLE_RATE), tables);
+  EXPECT_NE(Prewarp::getTables(48000.0), tables);
+  const double pi = juce::MathConstants<double>::pi;
+  for (int r = OversampleOff; r <= Oversample4x; ++r) {
+    const double sampleRate = TEST_SAMPLE_RATE * (double)(1 << r);
+    float g;
+    float bigG;
+    // powers of two are points in the table, so those
+    // should be exact
+    for (float hz : {32.0f, 256.0f, 1024.0f, 8192.0f}) {
+      Prewarp::lookup(tables, hz, g, bigG, (OversamplingE)r);
+      const double expected = std::tan(pi * hz / sampleRate);
+      EXPECT_NEAR(g, expected, expected * 1e-5) << rateNames[r];
+      EXPECT_NEAR(bigG, expected / (1.0 + expected), 1e-6) << rateNames[r];
+    }
+    // and anything between them close
+    for (float hz = FILTER_CUTOFF_MIN; hz < FILTER_CUTOFF_MAX; hz *= 1.1f) {
+      Prewarp::lookup(tables, hz, g, bigG, (OversamplingE)r);
+      const double expected = std::tan(pi * hz / sampleRate);
+      EXPECT_NEAR(g, expected, expected * 1e-3) << hz << " " << rateNames[r];
+    }
+  }
+}
+
+/* Drives the filter hard with a sine that sits exactly on an
+ * FFT bin, so every harmonic lands on a bin too. Anything that
+ * ends up in the other bins is aliasing (or noise), and we
+ * return its power relative to the harmonics in dB.
+ * */
+static double aliasingDb(FilterTypeE type,
+                         SaturationModeE mode,
+                         float cutoff,
+                         OversamplingE rate = OversampleOff) {
+  constexpr int fftSize = 4096;
+  constexpr int warmup = 4096;
+  constexpr int sineBin = 587;  // ~6.3kHz
+  test_lane_t lane;
+  setupLane(lane, cutoff, 0.3f * LADDER_MAX_K, rate);
+  LadderBatch batch;
+  batch.setSaturationMode(mode);
+  std::vector<float> output;
+  const double twoPi = juce::MathConstants<double>::twoPi;
+  int n = 0;
+  while ((int)output.size() < warmup + fftSize) {
+    for (int i = 0; i < MAX_VOICE_BLOCK; ++i) {
+      const double phase = twoPi * sineBin * (double)n / (double)fftSize;
+      lane.buffer[i] = (float)std::sin(phase);
+      ++n;
+    }
+    batch.clear();
+    batch.addLane(lane.buffer, lane.state, &lane.coeffs, 8.0f);
+    batch.process(type, MAX_VOICE_BLOCK);
+    output.insert(output.end(), lane.buffer, lane.buffer + MAX_VOICE_BLOCK);
+  }
+  // plain DFT, we only do this a few times
+  std::vector<double> cosTable(fftSize);
+  std::vector<double> sinTable(fftSize);
+  for (int i = 0; i < fftSize; ++i) {
+    cosTable[(size_t)i] = std::cos(twoPi * i / fftSize);
+    sinTable[(size_t)i] = std::sin(twoPi * i / fftSize);
+  }
+  double harmonicPower = 0.0;
+  double otherPower = 0.0;
+  for (int bin = 1; bin < fftSize / 2; ++bin) {
+    double re = 0.0;
+    double im = 0.0;
+    for (int i = 0; i < fftSize; ++i) {
+      const auto idx = (size_t)((bin * i) % fftSize);
+      const double x = (double)output[(size_t)(warmup + i)];
+      re += x * cosTable[idx];
+      im -= x * sinTable[idx];
+    }
+    const double power = (re * re) + (im * im);
+    if (bin % sineBin == 0)
+      harmonicPower += power;
+    else
+      otherPower += power;
+  }
+  return 10.0 * std::log10(otherPower / harmonicPower);
+}
+
+// at high cutoffs the feedback keeps the lowpass out of
+// saturation, so it gets a lower one than the sine
+static const float aliasingCutoffs[] = {0.0f, 4000.0f, 2000.0f, 6300.0f};
+
+TEST(LadderSaturation, Aliasing) {
+  for (int t = LadderLPSaturated; t <= LadderBP; ++t) {
+    const auto type = (FilterTypeE)t;
+    const double polyDb = aliasingDb(type, TanhPoly, aliasingCutoffs[t]);
+    const double adaaDb = aliasingDb(type, TanhPolyADAA, aliasingCutoffs[t]);
+    // anti-aliasing should be doing something
+    EXPECT_LT(adaaDb, polyDb) << filterNames[t];
+  }
+}
+
+// ADAA is opt in, so a batch that's left alone should sound
+// like the std::tanh the ladders have always used
+TEST(LadderSaturation, DefaultMatchesTanh) {
+  for (int t = LadderLPSaturated; t <= LadderBP; ++t) {
+    test_lane_t lanes[2];
+    LadderBatch batches[2];
+    batches[1].setSaturationMode(TanhStd);
+    for (auto& lane : lanes) {
+      setupLane(lane, 1200.0f, 0.6f * LADDER_MAX_K, OversampleOff);
+    }
+    std::mt19937 rng(0);
+    std::uniform_real_distribution<float> dist(-1.0f, 1.0f);
+    float maxDiff = 0.0f;
+    for (int block = 0; block < 8; ++block) {
+      for (int i = 0; i < MAX_VOICE_BLOCK; ++i) {
+        lanes[0].buffer[i] = lanes[1].buffer[i] = dist(rng);
+      }
+      for (int b = 0; b < 2; ++b) {
+        batches[b].clear();
+        batches[b].addLane(lanes[b].buffer, lanes[b].state, &lanes[b].coeffs,
+                           8.0f);
+        batches[b].process((FilterTypeE)t, MAX_VOICE_BLOCK);
+      }
+      for (int i = 0; i < MAX_VOICE_BLOCK; ++i) {
+        const float diff = std::abs(lanes[0].buffer[i] - lanes[1].buffer[i]);
+        maxDiff = std::max(maxDiff, diff);
+      }
+    }
+    // the Pade curve flattens out a little early past +-5
+    EXPECT_LT(maxDiff, 1e-3f) << filterNames[t];
+  }
+}
+
+// the scalar filters and the batches should give the same
+// output from the same coefficients and state
+template <typename F, typename Batch>
+static void expectBatchMatchesScalar(FilterTypeE type) {
+  F scalar;
+  F batched;
+  for (auto* f : {&scalar, &batched}) {
+    f->getCoeffs()->tables = Prewarp::getTables(TEST_SAMPLE_RATE);
+    f->setCutoffHz(1200.0f);
+    f->setResonance(0.6f);
+    f->prepare();
+  }
+  // loud enough to saturate
+  std::mt19937 rng(0);
+  std::uniform_real_distribution<float> noise(-2.0f, 2.0f);
+  Batch batch;
+  float buffer[MAX_VOICE_BLOCK];
+  float expected[MAX_VOICE_BLOCK];
+  for (int b = 0; b < 16; ++b) {
+    for (int i = 0; i < MAX_VOICE_BLOCK; ++i) {
+      buffer[i] = noise(rng);
+      expected[i] = scalar.processMono(buffer[i], 0);
+    }
+    batch.clear();
+    batch.addLane(buffer, batched.getState(0), batched.getCoeffs(), 1.0f);
+    batch.process(type, MAX_VOICE_BLOCK);
+    for (int i = 0; i < MAX_VOICE_BLOCK; ++i) {
+      ASSERT_NEAR(buffer[i], expected[i], 1e-4f) << filterNames[type];
+    }
+  }
+}
+
+TEST(LadderBatch, MatchesScalar) {
+  expectBatchMatchesScalar<LadderLPBasic, LadderBatch>(LadderLPLinear);
+  expectBatchMatchesScalar<LadderLP, LadderBatch>(LadderLPSaturated);
+  expectBatchMatchesScalar<LadderHighPass, LadderBatch>(LadderHP);
+  expectBatchMatchesScalar<LadderBandPass, LadderBatch>(LadderBP);
+}
+
+TEST(LadderOversampling, HalfBandRoundTrip) {
+  // a 1kHz sine should come back out of the up and
+  // downsamplers at the same level
+  constexpr int numSamples = 4096;
+  float up2x[HALFBAND_STATE_SIZE(HALFBAND_COEFFS_2X)] = {};
+  float down2x[HALFBAND_STATE_SIZE(HALFBAND_COEFFS_2X)] = {};
+  std::vector<float> in(numSamples);
+  std::vector<float> over(numSamples * 2);
+  std::vector<float> out(numSamples);
+  const double twoPi = juce::MathConstants<double>::twoPi;
+  for (int i = 0; i < numSamples; ++i) {
+    in[(size_t)i] = (float)std::sin(twoPi * 1000.0 * i / TEST_SAMPLE_RATE);
+  }
+  HalfBand::upsample<HALFBAND_COEFFS_2X>(HalfBand::coeffs2x, in.data(),
+                                         over.data(), numSamples, up2x);
+  HalfBand::downsample<HALFBAND_COEFFS_2X>(HalfBand::coeffs2x, over.data(),
+                                           out.data(), numSamples, down2x);
+  double inPower = 0.0;
+  double outPower = 0.0;
+  for (int i = numSamples / 2; i < numSamples; ++i) {
+    inPower += (double)(in[(size_t)i] * in[(size_t)i]);
+    outPower += (double)(out[(size_t)i] * out[(size_t)i]);
+  }
+  EXPECT_NEAR(outPower / inPower, 1.0, 0.01);
+}
+
+// gain in dB of a quiet sine through a lowpass ladder at its
+// cutoff, which shouldn't depend on the rate it runs at
+static double gainAtCutoffDb(OversamplingE rate) {
+  constexpr int numBlocks = 64;
+  constexpr float cutoff = 1000.0f;
+  test_lane_t lane;
+  setupLane(lane, cutoff, 0.0f, rate);
+  LadderBatch batch;
+  const double twoPi = juce::MathConstants<double>::twoPi;
+  double inPower = 0.0;
+  double outPower = 0.0;
+  int n = 0;
+  for (int b = 0; b < numBlocks; ++b) {
+    for (int i = 0; i < MAX_VOICE_BLOCK; ++i) {
+      lane.buffer[i] =
+          0.01f * (float)std::sin(twoPi * cutoff * n / TEST_SAMPLE_RATE);
+      if (b >= numBlocks / 2)
+        inPower += (double)(lane.buffer[i] * lane.buffer[i]);
+      ++n;
+    }
+    batch.clear();
+    batch.addLane(lane.buffer, lane.state, &lane.coeffs, 1.0f);
+    batch.process(LadderLPSaturated, MAX_VOICE_BLOCK);
+    if (b >= numBlocks / 2) {
+      for (auto s : lane.buffer)
+        outPower += (double)(s * s);
+    }
+  }
+  return 10.0 * std::log10(outPower / inPower);
+}
+
+TEST(LadderOversampling, GainAtCutoff) {
+  // each of the four poles is 3dB down at the cutoff
+  const double expected = (double)LADDER_MAKEUP_DB - 12.04;
+  for (int r = OversampleOff; r <= Oversample4x; ++r) {
+    EXPECT_NEAR(gainAtCutoffDb((OversamplingE)r), expected, 0.1)
+        << rateNames[r];
+  }
+}
+
+TEST(LadderOversampling, Aliasing) {
+  for (int t = LadderLPSaturated; t <= LadderBP; ++t) {
+    double dbAt[NUM_OVERSAMPLING_MODES];
+    for (int r = OversampleOff; r <= Oversample4x; ++r) {
+      dbAt[r] = aliasingDb((FilterTypeE)t, TanhPoly, aliasingCutoffs[t],
+                           (OversamplingE)r);
+    }
+    EXPECT_LT(dbAt[Oversample2x], dbAt[OversampleOff]) << filterNames[t];
+    EXPECT_LT(dbAt[Oversample4x], dbAt[Oversample2x]) << filterNames[t];
+  }
+}
+
+// one block of a single voice's filter
+static void processVoiceFilter(VoiceFilter& filter,
+                               FilterTypeE type,
+                               float* left,
+                               float* right) {
+  static LadderBatch ladders;
+  static SVFBatch svfs;
+  ladders.clear();
+  svfs.clear();
+  filter.addToBatch(ladders, svfs, left, right);
+  ladders.process(type, MAX_VOICE_BLOCK);
+  svfs.process(type, MAX_VOICE_BLOCK);
+}
+
+// the gain parameter scales what goes into the filter, so
+// a linear filter's output should scale with it
+TEST(VoiceFilter, Gain) {
+  const float gains[] = {0.25f, 1.0f};
+  std::mt19937 rng(0);
+  std::uniform_real_distribution<float> noise(-1.0f, 1.0f);
+  float input[MAX_VOICE_BLOCK];
+  for (auto& s : input)
+    s = noise(rng);
+  double power[2];
+  for (int g = 0; g < 2; ++g) {
+    shared_filter_params params;
+    params.baseGainLin = gains[g];
+    VoiceFilter filter(&params);
+    filter.updateForBlock();
+    float left[MAX_VOICE_BLOCK];
+    float right[MAX_VOICE_BLOCK];
+    std::copy(input, input + MAX_VOICE_BLOCK, left);
+    std::copy(input, input + MAX_VOICE_BLOCK, right);
+    processVoiceFilter(filter, params.filterType, left, right);
+    power[g] = 0.0;
+    for (auto s : left)
+      power[g] += (double)(s * s);
+  }
+  EXPECT_NEAR(power[1] / power[0], 16.0, 0.001);
+}
+
+// a type change should carry the current cutoff over to the
+// new filter rather than leaving it on its default
+TEST(VoiceFilter, TypeChangeKeepsCutoff) {
+  constexpr int numBlocks = 64;
+  constexpr float cutoff = 500.0f;
+  shared_filter_params params;
+  params.baseCutoff = cutoff;
+  params.baseResLin = 0.0f;
+  VoiceFilter filter(&params);
+  filter.updateForBlock();
+  const double twoPi = juce::MathConstants<double>::twoPi;
+  for (auto type : {LadderLPSaturated, LadderHP}) {
+    params.filterType = type;
+    filter.updateForBlock();
+    float left[MAX_VOICE_BLOCK];
+    float right[MAX_VOICE_BLOCK];
+    double inPower = 0.0;
+    double outPower = 0.0;
+    int n = 0;
+    for (int b = 0; b < numBlocks; ++b) {
+      for (int i = 0; i < MAX_VOICE_BLOCK; ++i) {
+        left[i] =
+            0.01f * (float)std::sin(twoPi * cutoff * n / TEST_SAMPLE_RATE);
+        right[i] = left[i];
+        if (b >= numBlocks / 2)
+          inPower += (double)(left[i] * left[i]);
+        ++n;
+      }
+      processVoiceFilter(filter, type, left, right);
+      if (b >= numBlocks / 2) {
+        for (auto s : left)
+          outPower += (double)(s * s);
+      }
+    }
+    // each of the four poles is 3dB down at the cutoff
+    EXPECT_NEAR(10.0 * std::log10(outPower / inPower),
+                (double)LADDER_MAKEUP_DB - 12.04, 0.1)
+        << filterNames[type];
+  }
+}
+
+// gain of a settled sine through an SVF in dB
+static double svfGainDb(FilterTypeE mode, float cutoff, double sineHz) {
+  constexpr int numBlocks = 64;
+  svf_coeffs_t coeffs;
+  coeffs.tables = Prewarp::getTables(TEST_SAMPLE_RATE);
+  coeffs.setK(1.0f);
+  coeffs.setCutoff(cutoff);
+  coeffs.snap();
+  float state[SVF_STATE_SIZE] = {};
+  float buffer[MAX_VOICE_BLOCK];
+  SVFBatch batch;
+  const double twoPi = juce::MathConstants<double>::twoPi;
+  double inPower = 0.0;
+  double outPower = 0.0;
+  int n = 0;
+  for (int b = 0; b < numBlocks; ++b) {
+    for (int i = 0; i < MAX_VOICE_BLOCK; ++i) {
+      buffer[i] = (float)std::sin(twoPi * sineHz * n / TEST_SAMPLE_RATE);
+      if (b >= numBlocks / 2)
+        inPower += (double)(buffer[i] * buffer[i]);
+      ++n;
+    }
+    batch.clear();
+    batch.addLane(buffer, state, &coeffs, 1.0f);
+    batch.process(mode, MAX_VOICE_BLOCK);
+    if (b >= numBlocks / 2) {
+      for (auto s : buffer)
+        outPower += (double)(s * s);
+    }
+  }
+  return 10.0 * std::log10(outPower / inPower);
+}
+
+TEST(SVF, Responses) {
+  // with k = 1 every mode but the notch is at 0dB at the
+  // cutoff, and the ones that pass DC or high frequencies
+  // should leave them alone
+  EXPECT_NEAR(svfGainDb(SVFLowPass, 2000.0f, 2000.0), 0.0, 0.1);
+  EXPECT_NEAR(svfGainDb(SVFBandPass, 2000.0f, 2000.0), 0.0, 0.1);
+  EXPECT_NEAR(svfGainDb(SVFHighPass, 2000.0f, 2000.0), 0.0, 0.1);
+  EXPECT_NEAR(svfGainDb(SVFLowPass, 2000.0f, 50.0), 0.0, 0.1);
+  EXPECT_NEAR(svfGainDb(SVFHighPass, 2000.0f, 15000.0), 0.0, 0.5);
+  EXPECT_LT(svfGainDb(SVFNotch, 2000.0f, 2000.0), -30.0);
+  EXPECT_NEAR(svfGainDb(SVFNotch, 2000.0f, 50.0), 0.0, 0.1);
+  EXPECT_NEAR(svfGainDb(SVFPeak, 2000.0f, 50.0), 0.0, 0.1);
+  // 12dB per octave
+  EXPECT_NEAR(svfGainDb(SVFLowPass, 500.0f, 4000.0), -36.0, 1.5);
+}
+
+TEST(SVF, BatchMatchesScalar) {
+  expectBatchMatchesScalar<StateVariable<SVFLowPass>, SVFBatch>(SVFLowPass);
+  expectBatchMatchesScalar<StateVariable<SVFBandPass>, SVFBatch>(
+      SVFBandPass);
+  expectBatchMatchesScalar<StateVariable<SVFHighPass>, SVFBatch>(
+      SVFHighPass);
+  expectBatchMatchesScalar<StateVariable<SVFNotch>, SVFBatch>(SVFNotch);
+  expectBatchMatchesScalar<StateVariable<SVFPeak>, SVFBatch>(SVFPeak);
+}
+
+}  // namespace audio_plugin_test
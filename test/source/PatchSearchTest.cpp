@@ -0,0 +1,101 @@
+#include <Electrum/Shared/PatchSearchIndex.h>
+
+#include "TestHelpers.h"
+
+#include <gtest/gtest.h>
+#include <algorithm>
+#include <functional>
+#include <set>
+
+namespace audio_plugin_test {
+
+TEST(PatchSearchIndex, Tokenize) {
+  auto tokens = PatchSearchIndex::tokenize("Big-Saw  LEAD_2");
+  ASSERT_EQ(tokens.size(), 4);
+  EXPECT_EQ(tokens[0], "big");
+  EXPECT_EQ(tokens[1], "saw");
+  EXPECT_EQ(tokens[2], "lead");
+  EXPECT_EQ(tokens[3], "2");
+}
+
+TEST(PatchSearchIndex, Search) {
+  auto saw = makePatch("Big Saw", "hayden", "detuned supersaw", Lead);
+  auto sub = makePatch("Sub Bass", "someone", "sine with a bit of saw", Bass);
+  auto pad = makePatch("Glass Pad", "hayden", "slow and airy", Pad);
+  PatchSearchIndex index;
+  index.add(&saw);
+  index.add(&sub);
+  index.add(&pad);
+  // prefixes on the last term, name hits rank first
+  auto results = index.search("sa");
+  ASSERT_EQ(results.size(), 2u);
+  EXPECT_EQ(results[0], &saw);
+  // every term has to match
+  results = index.search("hayden pad");
+  ASSERT_EQ(results.size(), 1u);
+  EXPECT_EQ(results[0], &pad);
+  // categories are searchable
+  results = index.search("bass");
+  ASSERT_EQ(results.size(), 1u);
+  EXPECT_EQ(results[0], &sub);
+  // one typo is fine
+  results = index.search("glsas");
+  ASSERT_EQ(results.size(), 1u);
+  EXPECT_EQ(results[0], &pad);
+  // removing and updating
+  index.remove(&saw);
+  EXPECT_EQ(index.search("supersaw").size(), 0u);
+  pad.name = "Crystal Pad";
+  index.update(&pad);
+  EXPECT_EQ(index.search("glass").size(), 0u);
+  EXPECT_EQ(index.search("crystal").size(), 1u);
+  EXPECT_EQ(index.size(), 2);
+}
+
+// every token the index knows about for a patch
+static juce::StringArray patchTokens(const patch_meta_t& p) {
+  auto tokens = PatchSearchIndex::tokenize(p.name + " " + p.author + " " +
+                                           p.description);
+  tokens.addArray(
+      PatchSearchIndex::tokenize(UserFiles::PatchCategStrings[p.category]));
+  return tokens;
+}
+
+static bool hasPrefix(const juce::StringArray& tokens, const String& prefix) {
+  return std::any_of(tokens.begin(), tokens.end(),
+                     [&](const String& t) { return t.startsWith(prefix); });
+}
+
+// the search should find exactly the patches the slow way
+// does
+TEST(PatchSearchIndex, LargeLibrary) {
+  auto patches = makeLargeLibrary();
+  PatchSearchIndex index;
+  buildIndex(index, patches);
+  typedef std::function<bool(const juce::StringArray&)> match_t;
+  const std::pair<const char*, match_t> queries[] = {
+      {"s", [](auto& t) { return hasPrefix(t, "s"); }},
+      {"sq", [](auto& t) { return hasPrefix(t, "sq"); }},
+      {"bright pl",
+       [](auto& t) { return t.contains("bright") && hasPrefix(t, "pl"); }},
+      // nothing starts with it, so it's the one typo away
+      {"glsas", [](auto& t) { return hasPrefix(t, "glas"); }},
+      {"author4", [](auto& t) { return hasPrefix(t, "author4"); }}};
+  for (auto& [q, matches] : queries) {
+    std::set<const patch_meta_t*> expected;
+    for (auto& p : patches) {
+      if (matches(patchTokens(p)))
+        expected.insert(&p);
+    }
+    auto results = index.search(q);
+    std::set<const patch_meta_t*> found(results.begin(), results.end());
+    EXPECT_FALSE(expected.empty()) << q;
+    EXPECT_EQ(found.size(), results.size()) << q;
+    EXPECT_EQ(found, expected) << q;
+  }
+  // author4 and author40 to author49
+  EXPECT_EQ(index.search("author4").size(),
+            (size_t)(LARGE_LIBRARY_SIZE / LARGE_LIBRARY_AUTHORS * 11));
+}
+
+}  // namespace audio_plugin_test
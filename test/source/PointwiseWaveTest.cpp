@@ -0,0 +1,59 @@
+#include <Electrum/Shared/PointwiseWave.h>
+
+#include <gtest/gtest.h>
+
+namespace audio_plugin_test {
+
+// points a handle at the spot 'frac' of the way toward
+// another point, in the same space the editor drags them in
+static void aimHandle(wave_point_t& pt,
+                      const wave_point_t& toward,
+                      bool isLeft,
+                      float frac) {
+  const frect_t bounds = {0.0f, 0.0f, 1.0f, 1.0f};
+  auto center = Pointwise::projectWavePointToSpace(bounds, pt);
+  auto target = Pointwise::projectWavePointToSpace(bounds, toward);
+  auto handle = center + ((target - center) * frac);
+  auto params = Pointwise::projectSpaceToBezierHandle(bounds, center, handle);
+  if (isLeft) {
+    pt.leftBezLength = params.normLength;
+    pt.leftBezTheta = params.theta;
+  } else {
+    pt.rightBezLength = params.normLength;
+    pt.rightBezTheta = params.theta;
+  }
+}
+
+static float maxErrorFromLine(const float* wave, float start, float end) {
+  float maxErr = 0.0f;
+  for (int i = 0; i < TABLE_SIZE; ++i) {
+    const float t = (float)i / (float)(TABLE_SIZE - 1);
+    const float expected = start + ((end - start) * t);
+    maxErr = std::max(maxErr, std::abs(wave[i] - expected));
+  }
+  return maxErr;
+}
+
+// handles that sit on the line between their points but
+// at uneven x positions still make a straight line, only
+// if each sample follows x(t) and not just t
+TEST(PointwiseWave, CubicFollowsHandleX) {
+  wave_pt_vec points = {{0, -0.5f, true, BezierFree},
+                        {TABLE_SIZE - 1, 0.5f, true, BezierFree}};
+  aimHandle(points[0], points[1], false, 0.1f);
+  aimHandle(points[1], points[0], true, 0.2f);
+  float wave[TABLE_SIZE];
+  Pointwise::renderWavePoints(points, wave);
+  EXPECT_LT(maxErrorFromLine(wave, -0.5f, 0.5f), 1e-3f);
+}
+
+TEST(PointwiseWave, QuadraticFollowsHandleX) {
+  wave_pt_vec points = {{0, 0.8f, true, BezierFree},
+                        {TABLE_SIZE - 1, -0.2f, true, Linear}};
+  aimHandle(points[0], points[1], false, 0.75f);
+  float wave[TABLE_SIZE];
+  Pointwise::renderWavePoints(points, wave);
+  EXPECT_LT(maxErrorFromLine(wave, 0.8f, -0.2f), 1e-3f);
+}
+
+}  // namespace audio_plugin_test
@@ -0,0 +1,38 @@
+#include <Electrum/Audio/AudioUtil.h>
+#include <Electrum/PluginProcessor.h>
+#include "TestHelpers.h"
+
+#include <gtest/gtest.h>
+
+namespace audio_plugin_test {
+
+// the default waves come from the library, so keep the
+// user's out of it
+typedef TempLibraryTest PluginStartup;
+
+TEST_F(PluginStartup, SharedDefaultWaves) {
+  ElectrumAudioProcessor first;
+  ElectrumAudioProcessor second;
+  // every oscillator in the process should start out on the
+  // same set rather than building its own
+  auto set = first.tree.audioData.wOsc[0].getWaveSet();
+  for (auto* proc : {&first, &second}) {
+    for (int o = 0; o < NUM_OSCILLATORS; ++o) {
+      EXPECT_EQ(proc->tree.audioData.wOsc[o].getWaveSet(), set);
+    }
+  }
+}
+
+// the table gets built at compile time without std::sin, so
+// check it against std::sin on each of its points
+TEST(AudioUtil, FastSineTable) {
+  constexpr int numPoints = 2048;
+  const double twoPi = juce::MathConstants<double>::twoPi;
+  for (int i = 0; i < numPoints; ++i) {
+    const float phase = (float)i / (float)numPoints;
+    const double expected = std::sin(twoPi * (double)i / (double)numPoints);
+    ASSERT_NEAR(AudioUtil::fastSine(phase), expected, 1e-6) << i;
+  }
+}
+
+}  // namespace audio_plugin_test
@@ -0,0 +1,115 @@
+#include <Electrum/PluginProcessor.h>
+#include <Electrum/Shared/StateFormat.h>
+#include "TestHelpers.h"
+
+#include <gtest/gtest.h>
+#include <vector>
+
+namespace audio_plugin_test {
+
+static std::vector<float> paramValues(ElectrumAudioProcessor& proc) {
+  std::vector<float> values;
+  for (auto* p : proc.getParameters()) {
+    values.push_back(p->getValue());
+  }
+  return values;
+}
+
+// the format on its own, with a tree that has a bit of
+// everything in it
+TEST(StateFormat, RoundTrip) {
+  ValueTree state("STATE");
+  state.setProperty("int", 42, nullptr);
+  state.setProperty("float", 0.25f, nullptr);
+  state.setProperty("string", "some text", nullptr);
+  for (int i = 0; i < 3; ++i) {
+    ValueTree child("CHILD");
+    child.setProperty("index", i, nullptr);
+    state.appendChild(child, nullptr);
+  }
+  for (bool compress : {false, true}) {
+    juce::MemoryBlock block;
+    StateFormat::write(state, block, compress);
+    EXPECT_TRUE(StateFormat::isBinary(block.getData(), block.getSize()));
+    auto restored = StateFormat::read(block.getData(), block.getSize());
+    EXPECT_TRUE(restored.isEquivalentTo(state)) << compress;
+  }
+  // the old XML states still come back
+  const String xml = state.toXmlString();
+  EXPECT_FALSE(StateFormat::isBinary(xml.toRawUTF8(), xml.getNumBytesAsUTF8()));
+  auto restored =
+      StateFormat::read(xml.toRawUTF8(), xml.getNumBytesAsUTF8());
+  EXPECT_TRUE(restored.isEquivalentTo(state));
+  // and anything else is invalid
+  const char junk[] = "not a state";
+  EXPECT_FALSE(StateFormat::read(junk, sizeof(junk)).isValid());
+}
+
+// every test that makes a processor gets a library of its
+// own
+typedef TempLibraryTest PluginState;
+
+TEST_F(PluginState, RoundTrip) {
+  ElectrumAudioProcessor proc;
+  makeComplexPatch(proc, 1);
+  const auto expected = paramValues(proc);
+  const float expectedDepth = proc.tree.modulationDepth(0, 0);
+  juce::MemoryBlock binary;
+  proc.getStateInformation(binary);
+  EXPECT_TRUE(StateFormat::isBinary(binary.getData(), binary.getSize()));
+  juce::MemoryBlock legacy;
+  writeLegacyXml(proc, legacy);
+  // both formats should bring back the same parameters
+  for (auto* block : {&binary, &legacy}) {
+    makeComplexPatch(proc, 2);
+    proc.setStateInformation(block->getData(), (int)block->getSize());
+    EXPECT_EQ(paramValues(proc), expected);
+    EXPECT_EQ(proc.tree.modulationDepth(0, 0), expectedDepth);
+  }
+}
+
+TEST_F(PluginState, RestoresProgram) {
+  ElectrumAudioProcessor proc;
+  juce::MemoryBlock block;
+  proc.getStateInformation(block);
+  // as if it was saved on a program whose file has since
+  // gone, so only the number is left to go on
+  auto state = StateFormat::read(block.getData(), block.getSize());
+  state.setProperty(ID::programIndex, 3, nullptr);
+  state.removeProperty(ID::programPath, nullptr);
+  StateFormat::write(state, block);
+  proc.setStateInformation(block.getData(), (int)block.getSize());
+  EXPECT_EQ(proc.getCurrentProgram(), 3);
+  EXPECT_FALSE(proc.tree.copyState().hasProperty(ID::programIndex));
+}
+
+// a prepared patch's parameters and modulations go in along
+// with everything else, without waiting on the tree
+TEST_F(PluginState, CommitPrepared) {
+  ElectrumAudioProcessor proc;
+  auto& params = proc.getParameters();
+  const String cutoffID = ID::filterCutoff.toString() + "0";
+  int cutoff = -1;
+  for (int i = 0; i < params.size(); ++i) {
+    auto* param = dynamic_cast<juce::RangedAudioParameter*>(params[i]);
+    if (param != nullptr && param->paramID == cutoffID)
+      cutoff = i;
+  }
+  ASSERT_GE(cutoff, 0);
+  ValueTree modTree(ID::ELECTRUM_MOD_TREE);
+  ValueTree mod(ID::ELECTRUM_MODULATION);
+  mod.setProperty(ID::modSourceID, 2, nullptr);
+  mod.setProperty(ID::modDestID, 5, nullptr);
+  mod.setProperty(ID::modDepth, 0.5f, nullptr);
+  modTree.appendChild(mod, nullptr);
+  PreparedPatch::Ptr p = new PreparedPatch();
+  p->params.push_back({cutoff, 0.75f});
+  p->modulations.updateMap(modTree);
+  p->hasModulations = true;
+  ASSERT_FALSE(proc.tree.modulations.modExists(2, 5));
+  EXPECT_TRUE(proc.tree.commitPrepared(*p));
+  EXPECT_NEAR(params[cutoff]->getValue(), 0.75f, 0.01f);
+  EXPECT_TRUE(proc.tree.modulations.modExists(2, 5));
+}
+
+}  // namespace audio_plugin_test
@@ -0,0 +1,63 @@
+#include <Electrum/Shared/SPSCRing.h>
+
+#include <gtest/gtest.h>
+#include <thread>
+
+namespace audio_plugin_test {
+
+// big enough that a torn copy would show up
+struct test_item_t {
+  int index;
+  float values[31];
+};
+
+TEST(SPSCRing, FillAndDrain) {
+  SPSCRing<test_item_t, 4> ring;
+  test_item_t item = {};
+  EXPECT_FALSE(ring.pop(item));
+  for (int i = 0; i < 4; ++i) {
+    item.index = i;
+    EXPECT_TRUE(ring.push(item));
+  }
+  // full, so the newest gets dropped
+  item.index = 4;
+  EXPECT_FALSE(ring.push(item));
+  EXPECT_TRUE(ring.pop(item));
+  EXPECT_EQ(item.index, 0);
+  EXPECT_TRUE(ring.popLatest(item));
+  EXPECT_EQ(item.index, 3);
+  EXPECT_FALSE(ring.popLatest(item));
+}
+
+TEST(SPSCRing, Threaded) {
+  constexpr int numItems = 200000;
+  SPSCRing<test_item_t, 8> ring;
+  std::thread producer([&ring]() {
+    test_item_t item;
+    for (int i = 0; i < numItems; ++i) {
+      item.index = i;
+      for (auto& v : item.values)
+        v = (float)i;
+      while (!ring.push(item)) {
+        std::this_thread::yield();
+      }
+    }
+  });
+  // every item should arrive whole and in order
+  int expected = 0;
+  test_item_t item;
+  while (expected < numItems) {
+    if (!ring.pop(item)) {
+      std::this_thread::yield();
+      continue;
+    }
+    ASSERT_EQ(item.index, expected);
+    for (auto v : item.values) {
+      ASSERT_EQ(v, (float)expected);
+    }
+    ++expected;
+  }
+  producer.join();
+}
+
+}  // namespace audio_plugin_test
@@ -0,0 +1,146 @@
+#pragma once
+#include <Electrum/Audio/Filters/LadderSIMD.h>
+#include <Electrum/Audio/Filters/Prewarp.h>
+#include <Electrum/PluginProcessor.h>
+#include <Electrum/Shared/FileSystem.h>
+#include <Electrum/Shared/PatchSearchIndex.h>
+
+#include <gtest/gtest.h>
+#include <random>
+#include <vector>
+
+/* Helpers shared by the tests and the benchmarks.
+ * */
+namespace audio_plugin_test {
+
+// filters------------------------------------------------------
+
+static const char* const filterNames[] = {
+    "LP linear", "LP saturated", "HP",        "BP",      "SVF LP",
+    "SVF BP",    "SVF HP",       "SVF notch", "SVF peak"};
+static const char* const rateNames[] = {"1x", "2x", "4x"};
+
+#define TEST_SAMPLE_RATE 44100.0
+
+// one voice-channel's worth of filter
+struct test_lane_t {
+  ladder_coeffs_t coeffs;
+  float state[LADDER_STATE_SIZE] = {};
+  float buffer[MAX_VOICE_BLOCK] = {};
+};
+
+inline void setupLane(test_lane_t& lane,
+                      float cutoff,
+                      float k,
+                      OversamplingE rate) {
+  lane.coeffs.tables = Prewarp::getTables(TEST_SAMPLE_RATE);
+  lane.coeffs.rate = rate;
+  lane.coeffs.setK(k);
+  lane.coeffs.setCutoff(cutoff);
+  lane.coeffs.snap();
+}
+
+// patches and state--------------------------------------------
+
+using audio_plugin::ElectrumAudioProcessor;
+
+/* Points the library at an empty temporary folder for as
+ * long as it's around, so a test starts from the default
+ * waves and no patches no matter what the user has
+ * installed, and doesn't leave anything behind. Create it
+ * before any processor.
+ * */
+struct scoped_temp_library_t {
+  File folder;
+  scoped_temp_library_t()
+      : folder(File::getSpecialLocation(File::tempDirectory)
+                   .getNonexistentChildFile("ElectrumTestLibrary", "",
+                                            false)) {
+    UserFiles::setDataFolder(folder);
+  }
+  ~scoped_temp_library_t() {
+    UserFiles::setDataFolder(File());
+    folder.deleteRecursively();
+  }
+};
+
+// for tests whose processors shouldn't touch the user's
+// library
+class TempLibraryTest : public ::testing::Test {
+protected:
+  scoped_temp_library_t library;
+};
+
+// every parameter moved and a third of the modulation
+// matrix in use
+inline void makeComplexPatch(ElectrumAudioProcessor& proc, unsigned seed) {
+  std::mt19937 rng(seed);
+  std::uniform_real_distribution<float> dist(0.0f, 1.0f);
+  for (auto* p : proc.getParameters()) {
+    p->setValueNotifyingHost(dist(rng));
+  }
+  for (int s = 0; s < MOD_SOURCES; ++s) {
+    for (int d = 0; d < MOD_DESTS; ++d) {
+      if ((s + d) % 3 == 0)
+        proc.tree.setModulation(s, d, dist(rng) - 0.5f);
+    }
+  }
+}
+
+// the way states were saved before the binary format
+inline void writeLegacyXml(ElectrumAudioProcessor& proc,
+                           juce::MemoryBlock& dest) {
+  String xml = proc.tree.copyState().toXmlString();
+  dest.replaceAll(xml.toRawUTF8(), xml.getNumBytesAsUTF8());
+}
+
+// patch search-----------------------------------------------
+
+// a big made up library
+#define LARGE_LIBRARY_SIZE 50000
+#define LARGE_LIBRARY_AUTHORS 100
+
+inline patch_meta_t makePatch(const String& name,
+                              const String& author,
+                              const String& desc,
+                              int category) {
+  patch_meta_t p;
+  p.name = name;
+  p.author = author;
+  p.description = desc;
+  p.category = category;
+  return p;
+}
+
+// the same patches every time
+inline std::vector<patch_meta_t> makeLargeLibrary() {
+  const char* words[] = {"saw",   "square", "pluck", "bass", "pad",
+                         "lead",  "bright", "dark",  "warm", "glass",
+                         "metal", "soft",   "wide",  "deep", "keys"};
+  std::mt19937 rng(0);
+  std::uniform_int_distribution<int> pick(0, 14);
+  std::uniform_int_distribution<int> categ(0, NUM_PATCH_CATEGORIES - 1);
+  std::vector<patch_meta_t> patches;
+  patches.reserve(LARGE_LIBRARY_SIZE);
+  for (int i = 0; i < LARGE_LIBRARY_SIZE; ++i) {
+    String name = String(words[pick(rng)]) + " " + words[pick(rng)] + " " +
+                  String(i);
+    String desc = String(words[pick(rng)]) + " " + words[pick(rng)];
+    patches.push_back(makePatch(name,
+                                "author" + String(i % LARGE_LIBRARY_AUTHORS),
+                                desc, categ(rng)));
+  }
+  return patches;
+}
+
+// indexes the patches the way the library does
+inline void buildIndex(PatchSearchIndex& index,
+                       std::vector<patch_meta_t>& patches) {
+  for (auto& p : patches) {
+    index.add(&p);
+  }
+  // the library does this once a scan finishes
+  index.updateNameRanks();
+}
+
+}  // namespace audio_plugin_test